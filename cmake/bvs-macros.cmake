@@ -10,3 +10,16 @@ macro(add_bvs_module MODULE_NAME)
 	add_library(${MODULE_NAME} ${BVS_MODULE_TYPE} ${SRC_LIST})
 	target_link_libraries(${MODULE_NAME} ${BVS_LINK_LIBRARIES})
 endmacro()
+
+# add bvs unit test, runs in the bin directory (sources of library internals have
+# to be listed, they are hidden in libbvs)
+#
+# CALL: add_bvs_test(TEST_NAME SRC_LIST)
+macro(add_bvs_test TEST_NAME)
+	set(SRC_LIST ${ARGV})
+	list(REMOVE_AT SRC_LIST 0)
+	add_executable(${TEST_NAME} ${SRC_LIST})
+	target_link_libraries(${TEST_NAME} bvs pthread)
+	add_test(NAME ${TEST_NAME} COMMAND ${TEST_NAME} WORKING_DIRECTORY ${EXECUTABLE_OUTPUT_PATH})
+	set_tests_properties(${TEST_NAME} PROPERTIES TIMEOUT 60)
+endmacro()
@@ -5,6 +5,10 @@
 set(BVS_ANDROID_APP FALSE CACHE BOOL "Generate Android targets!")
 mark_as_advanced(BVS_ANDROID_APP)
 
+# BVS_ALLOCATION_TRACKING
+set(BVS_ALLOCATION_TRACKING OFF CACHE BOOL "Count heap allocations per thread and module (replaces global operator new/delete, see BVS.allocationTracking).")
+mark_as_advanced(BVS_ALLOCATION_TRACKING)
+
 # BVS_GCC_VISIBILITY
 set(BVS_GCC_VISIBILITY ON CACHE BOOL "Enable GCC's visibility feature (reduce library size and load time).")
 mark_as_advanced(BVS_GCC_VISIBILITY)
@@ -12,6 +16,10 @@ mark_as_advanced(BVS_GCC_VISIBILITY)
 # BVS_LOG_SYSTEM
 set(BVS_LOG_SYSTEM ON CACHE BOOL "Enable BVS' builtin log system.")
 
+# BVS_LOG_MAX_LEVEL
+set(BVS_LOG_MAX_LEVEL "" CACHE STRING "Remove all LOG calls above this level at compile time (empty keeps all).")
+mark_as_advanced(BVS_LOG_MAX_LEVEL)
+
 # BVS_MODULE_HOTSWAP
 set(BVS_MODULE_HOTSWAP OFF CACHE BOOL "Enable BVS's modular HotSwap(TM;-) facilities. WARNING: DEVELOPERS ONLY!")
 mark_as_advanced(BVS_MODULE_HOTSWAP)
@@ -24,6 +32,10 @@ mark_as_advanced(BVS_STATIC)
 set(BVS_STATIC_MODULES OFF CACHE BOOL "Include modules in 'libbvs'!")
 mark_as_advanced(BVS_STATIC_MODULES)
 
+# BVS_TESTS
+set(BVS_TESTS ON CACHE BOOL "Build unit tests of library internals (run with ctest).")
+mark_as_advanced(BVS_TESTS)
+
 # BVS_THREAD_NAMES
 set(BVS_THREAD_NAMES ${UNIX} CACHE BOOL "Name threads (htop: enable 'Show custom thread names', or try 'ps -La'). UNIX ONLY!")
 mark_as_advanced(BVS_THREAD_NAMES)
@@ -40,12 +52,19 @@ add_option_dependency(BVS_STATIC_MODULES ON_IF BVS_ANDROID_APP)
 add_option_dependency(BVS_STATIC_MODULES ON_IF BVS_STATIC)
 add_option_dependency(BVS_MODULE_HOTSWAP OFF_IF BVS_STATIC_MODULES)
 add_option_dependency(BVS_GCC_VISIBILITY OFF_IF BVS_ANDROID_APP)
+add_option_dependency(BVS_TESTS OFF_IF BVS_ANDROID_APP)
 
 
 
 ################
 ### SETTINGS ###
 ################
+if(BVS_ALLOCATION_TRACKING)
+	add_definitions(-DBVS_ALLOCATION_TRACKING)
+else()
+	remove_definitions(-DBVS_ALLOCATION_TRACKING)
+endif()
+
 if(BVS_GCC_VISIBILITY)
 	add_definitions(-DBVS_GCC_VISIBILITY -fvisibility=hidden)
 else()
@@ -58,6 +77,10 @@ else()
 	remove_definitions(-DBVS_LOG_SYSTEM)
 endif()
 
+if(NOT BVS_LOG_MAX_LEVEL STREQUAL "")
+	add_definitions(-DBVS_LOG_MAX_LEVEL=${BVS_LOG_MAX_LEVEL})
+endif()
+
 if(BVS_MODULE_HOTSWAP)
 	add_definitions(-DBVS_MODULE_HOTSWAP)
 else()
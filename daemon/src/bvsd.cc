@@ -5,10 +5,18 @@ int main(const int argc, const char** argv)
 {
 	signal(SIGINT, mainSignal);
 	signal(SIGSEGV, mainSignal);
+	signal(SIGABRT, mainSignal);
 	signal(SIGALRM, mainSignal);
 
 	bvs = new BVS::BVS(argc, argv, &shutdownFunction);
 
+	std::unique_ptr<BVSD::MetricsServer> metrics;
+	std::string metricsListen = bvs->config.getValue<std::string>("BVSD.metricsListen", "");
+	if (!metricsListen.empty()) {
+		metrics.reset(new BVSD::MetricsServer{metricsListen, "/dev/shm/bvs-" + std::to_string(getpid())});
+		if (!metrics->start()) metrics.reset();
+	}
+
 	LOG(2, "loading modules!");
 	bvs->loadModules();
 
@@ -16,7 +24,22 @@ int main(const int argc, const char** argv)
 	bvs->connectAllModules();
 
 	LOG(2, "starting!");
-	if (bvs->config.getValue<bool>("BVSD.interactive", true)) {
+	unsigned long long benchmarkRounds = bvs->config.getValue<unsigned long long>("BVSD.benchmarkRounds", 0);
+	if (benchmarkRounds>0) {
+		bvs->start(false);
+		BVS::BenchmarkSummary summary = bvs->benchmark(bvs->config.getValue<unsigned long long>("BVSD.warmupRounds", 10), benchmarkRounds);
+		bvs->quit();
+
+		std::cout << summary.text();
+		std::string jsonFile = bvs->config.getValue<std::string>("BVSD.benchmarkJSON", "");
+		if (jsonFile.empty()) {
+			std::cout << summary.json();
+		} else {
+			std::ofstream json{jsonFile};
+			json << summary.json();
+			if (!json) LOG(1, "could not write benchmark summary to '" << jsonFile << "'!");
+		}
+	} else if (bvs->config.getValue<bool>("BVSD.interactive", true)) {
 		bvs->start();
 		bvs->run();
 		std::string input;
@@ -47,6 +70,14 @@ int main(const int argc, const char** argv)
 				if (input.empty() || delimiter==std::string::npos) std::cout << "ERROR: no module ID given!" << std::endl;
 				else bvs->hotSwap(input);
 			}
+			else if (input == "cs" || input == "connections")
+			{
+				bvs->logConnectorStatistics();
+			}
+			else if (input == "fr" || input == "flightrecorder")
+			{
+				bvs->dumpFlightRecorder();
+			}
 			else if (input == "q" || input == "quit")
 			{
 				LOG(2, "quitting...");
@@ -62,6 +93,8 @@ int main(const int argc, const char** argv)
 				std::cout << "   s|step           advance system by one step" << std::endl;
 				std::cout << "   p|pause          pause(stop) system" << std::endl;
 				std::cout << "   hs|hotswap <arg> HotSwap(TM) <moduleID>" << std::endl;
+				std::cout << "   cs|connections   show connection statistics" << std::endl;
+				std::cout << "   fr|flightrecorder dump flight recorder" << std::endl;
 				std::cout << "   q|quit           shutdown system and quit" << std::endl;
 				std::cout << "   h|help           show help" << std::endl;
 			}
@@ -75,7 +108,9 @@ int main(const int argc, const char** argv)
 		bvs->run();
 	}
 
+	metrics.reset();
 	delete bvs;
+	bvs = nullptr;
 
 	return 0;
 }
@@ -90,7 +125,10 @@ void mainSignal(int sig)
 			LOG(1, "Caught 'Ctrl-C', quitting!");
 			break;
 		case SIGSEGV:
-			LOG(1, "Caught segmentation fault...!");
+		case SIGABRT:
+			if (bvs) bvs->dumpFlightRecorder();
+			LOG(1, "Caught " << (sig==SIGSEGV ? "segmentation fault" : "abort") << "...!");
+			if (bvs) bvs->flushLog();
 			void *msgs[100];
 			size_t size;
 			size = backtrace(msgs, 100);
@@ -102,14 +140,19 @@ void mainSignal(int sig)
 			free(messages);
 			break;
 		case SIGALRM:
+			if (quitting) {
+				LOG(1, "Shutdown did not finish (hung module?), exiting!");
+				bvs->flushLog();
+				_exit(EXIT_FAILURE);
+			}
 			LOG(1, "Shutdown requested, quitting!");
 			break;
 	}
 
-	if (sig==SIGSEGV)
+	if (sig==SIGSEGV || sig==SIGABRT)
 	{
-		signal(SIGSEGV, SIG_DFL);
-		raise(SIGSEGV);
+		signal(sig, SIG_DFL);
+		raise(sig);
 	}
 	else
 	{
@@ -124,7 +167,11 @@ void mainSignal(int sig)
 void shutdownFunction()
 {
 	LOG(1,"daemon exit caused by bvs shutdown request!");
+	// quit() does not return if a module hangs (watchdog shutdown), SIGALRM exits anyway
+	quitting = 1;
+	alarm(5);
 	bvs->quit();
+	quitting = 0;
 	alarm(1); // SIGALRM after 1 second so all framework/module threads have a chance to quit
 }
 
@@ -2,13 +2,16 @@
 #include <execinfo.h>
 #include <cstdio>
 #include <cstring>
+#include <fstream>
 #include <unistd.h>
 #include "bvs/bvs.h"
+#include "metricsserver.h"
 
 
 
 BVS::BVS* bvs;
 BVS::Logger logger("Daemon");
+volatile sig_atomic_t quitting = 0; /**< Set while shutdownFunction waits for quit(). */
 
 
 
@@ -41,6 +44,8 @@ namespace BVSD
  * @li \c continue same as run
  * @li \c step advance system by one step.
  * @li \c pause pause(stop) system.
+ * @li \c connections show connection statistics.
+ * @li \c flightrecorder dump flight recorder (also done on crashes).
  * @li \c test call test functions.
  * @li \c quit shutdown system and quit.
  * @li \c help show help.
@@ -51,6 +56,26 @@ namespace BVSD
  * [BVSD]
  * interactive = OFF
  * @endcode
+ *
+ * To serve metrics in Prometheus text format (requires BVS.statsPage = ON)
+ * on a TCP address or a Unix socket, set:
+ * @code
+ * [BVSD]
+ * metricsListen = localhost:9464
+ * # metricsListen = unix:/run/bvs-metrics.sock
+ * @endcode
+ *
+ * To compare configs and builds, run a fixed number of rounds as fast as
+ * possible (ignoring BVS.minRoundTime) and print a summary (rounds/s, round
+ * time percentiles, per pool and module mean/p99, pool idle time on the
+ * barrier and peak RSS) as text and JSON, then quit:
+ * @code
+ * [BVSD]
+ * benchmarkRounds = 1000
+ * warmupRounds = 10
+ * # write JSON to a file instead of stdout
+ * # benchmarkJSON = bench.json
+ * @endcode
  */
 	class BVSD
 	{
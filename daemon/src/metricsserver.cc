@@ -0,0 +1,313 @@
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+
+#include <fcntl.h>
+#include <netdb.h>
+#include <poll.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "metricsserver.h"
+
+using BVSD::MetricsServer;
+
+
+
+/** Escape a Prometheus label value. */
+static std::string escape(const char* value)
+{
+	std::string escaped;
+	for (; *value; value++) {
+		if (*value=='\\' || *value=='"') escaped += '\\';
+		if (*value=='\n') { escaped += "\\n"; continue; }
+		escaped += *value;
+	}
+	return escaped;
+}
+
+
+
+/** Write a histogram (buckets are not cumulative in the page). */
+static void histogram(std::ostream& out, const std::string& name, const std::string& labels,
+		const uint64_t* buckets, uint64_t sum, uint64_t count)
+{
+	std::string separator = labels.empty() ? "" : ",";
+	uint64_t cumulative = 0;
+	for (uint32_t i=0; i<BVS::statsPageBuckets; i++) {
+		cumulative += buckets[i];
+		out << name << "_bucket{" << labels << separator << "le=\"";
+		if (i<BVS::statsPageBuckets-1) out << BVS::statsPageBucketBounds[i]/1e6;
+		else out << "+Inf";
+		out << "\"} " << cumulative << "\n";
+	}
+	out << name << "_sum" << (labels.empty() ? "" : "{" + labels + "}") << " " << sum/1e6 << "\n";
+	out << name << "_count" << (labels.empty() ? "" : "{" + labels + "}") << " " << count << "\n";
+}
+
+
+
+MetricsServer::MetricsServer(const std::string& listen, const std::string& page)
+	: logger{"Metrics"},
+	listen{listen},
+	pagePath{page},
+	page{nullptr},
+	pageSize{0},
+	snapshot{},
+	socket{-1},
+	running{false},
+	thread{}
+{ }
+
+
+
+MetricsServer::~MetricsServer()
+{
+	running = false;
+	if (thread.joinable()) thread.join();
+	if (socket>=0) close(socket);
+	if (listen.compare(0, 5, "unix:")==0) unlink(listen.substr(5).c_str());
+	if (page) munmap(const_cast<BVS::StatsPageHeader*>(page), pageSize);
+}
+
+
+
+bool MetricsServer::start()
+{
+	if (!mapPage() || !openSocket()) return false;
+
+	running = true;
+	thread = std::thread{&MetricsServer::run, this};
+	LOG(2, "serving metrics on '" << listen << "'!");
+
+	return true;
+}
+
+
+
+bool MetricsServer::mapPage()
+{
+	int fd = open(pagePath.c_str(), O_RDONLY);
+	struct stat info;
+	if (fd<0 || fstat(fd, &info)!=0) {
+		LOG(1, "could not open statistics page '" << pagePath << "', metrics require BVS.statsPage = ON!");
+		if (fd>=0) close(fd);
+		return false;
+	}
+	void* mapped = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (mapped==MAP_FAILED) {
+		LOG(1, "could not map statistics page '" << pagePath << "': " << strerror(errno));
+		return false;
+	}
+	page = static_cast<const BVS::StatsPageHeader*>(mapped);
+	pageSize = info.st_size;
+	snapshot.resize(pageSize);
+
+	return true;
+}
+
+
+
+bool MetricsServer::openSocket()
+{
+	if (listen.compare(0, 5, "unix:")==0) {
+		std::string path = listen.substr(5);
+		sockaddr_un address{};
+		address.sun_family = AF_UNIX;
+		if (path.size()>=sizeof(address.sun_path)) {
+			LOG(1, "unix socket path too long: " << path);
+			return false;
+		}
+		strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path)-1);
+		unlink(path.c_str());
+		socket = ::socket(AF_UNIX, SOCK_STREAM, 0);
+		if (socket<0 || bind(socket, reinterpret_cast<sockaddr*>(&address), sizeof(address))!=0
+				|| ::listen(socket, 8)!=0) {
+			LOG(1, "could not listen on '" << listen << "': " << strerror(errno));
+			return false;
+		}
+		return true;
+	}
+
+	size_t separator = listen.find_last_of(':');
+	std::string host = separator==std::string::npos || separator==0 ? "localhost" : listen.substr(0, separator);
+	std::string port = separator==std::string::npos ? listen : listen.substr(separator+1);
+
+	addrinfo hints{};
+	hints.ai_family = AF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
+	hints.ai_flags = AI_PASSIVE;
+	addrinfo* addresses = nullptr;
+	int error = getaddrinfo(host.c_str(), port.c_str(), &hints, &addresses);
+	if (error!=0) {
+		LOG(1, "could not resolve '" << listen << "': " << gai_strerror(error));
+		return false;
+	}
+
+	for (addrinfo* address = addresses; address!=nullptr; address = address->ai_next) {
+		socket = ::socket(address->ai_family, address->ai_socktype, address->ai_protocol);
+		if (socket<0) continue;
+		int reuse = 1;
+		setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+		if (bind(socket, address->ai_addr, address->ai_addrlen)==0 && ::listen(socket, 8)==0) break;
+		close(socket);
+		socket = -1;
+	}
+	freeaddrinfo(addresses);
+
+	if (socket<0) LOG(1, "could not listen on '" << listen << "': " << strerror(errno));
+	return socket>=0;
+}
+
+
+
+void MetricsServer::run()
+{
+	pollfd listening{socket, POLLIN, 0};
+
+	while (running) {
+		// poll with timeout, so the thread notices when it should stop
+		if (poll(&listening, 1, 200)<=0) continue;
+		int client = accept(socket, nullptr, nullptr);
+		if (client<0) continue;
+		serve(client);
+		close(client);
+	}
+}
+
+
+
+void MetricsServer::serve(int fd)
+{
+	timeval timeout{1, 0};
+	setsockopt(fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+	std::string request;
+	char buffer[1024];
+	while (request.find("\r\n\r\n")==std::string::npos && request.size()<8192) {
+		ssize_t size = recv(fd, buffer, sizeof(buffer), 0);
+		if (size<=0) break;
+		request.append(buffer, size);
+	}
+
+	std::string status = "200 OK";
+	std::string body;
+	if (request.compare(0, 13, "GET /metrics ")==0 || request.compare(0, 6, "GET / ")==0) {
+		body = render();
+		if (body.empty()) {
+			status = "503 Service Unavailable";
+			body = "statistics page is being updated, try again\n";
+		}
+	} else {
+		status = "404 Not Found";
+		body = "only GET /metrics is served\n";
+	}
+
+	std::string response = "HTTP/1.0 " + status + "\r\n"
+		+ "Content-Type: text/plain; version=0.0.4\r\n"
+		+ "Content-Length: " + std::to_string(body.size()) + "\r\n"
+		+ "Connection: close\r\n\r\n" + body;
+
+	const char* data = response.data();
+	size_t remaining = response.size();
+	while (remaining>0) {
+		ssize_t written = send(fd, data, remaining, MSG_NOSIGNAL);
+		if (written<=0) break;
+		data += written;
+		remaining -= written;
+	}
+}
+
+
+
+std::string MetricsServer::render()
+{
+	if (!page || !BVS::readStatsPage(page, snapshot.data(), snapshot.size())) return std::string{};
+
+	auto header = reinterpret_cast<const BVS::StatsPageHeader*>(snapshot.data());
+	auto modules = reinterpret_cast<const BVS::StatsPageModule*>(header + 1);
+	auto pools = reinterpret_cast<const BVS::StatsPagePool*>(modules + header->moduleCapacity);
+	auto connectors = reinterpret_cast<const BVS::StatsPageConnector*>(pools + header->poolCapacity);
+
+	std::ostringstream out;
+
+	out << "# HELP bvs_rounds_total Number of finished rounds.\n"
+		<< "# TYPE bvs_rounds_total counter\n"
+		<< "bvs_rounds_total " << header->rounds << "\n";
+	out << "# HELP bvs_round_duration_seconds Round duration.\n"
+		<< "# TYPE bvs_round_duration_seconds histogram\n";
+	histogram(out, "bvs_round_duration_seconds", "", header->roundHistogram, header->roundDurationSum, header->rounds);
+	out << "# HELP bvs_round_utilization_ratio Utilization of all pools in the last round.\n"
+		<< "# TYPE bvs_round_utilization_ratio gauge\n"
+		<< "bvs_round_utilization_ratio " << header->roundUtilization/100 << "\n";
+	out << "# HELP bvs_pool_imbalance_ratio Slowest pool busy time / mean pool busy time in the last round.\n"
+		<< "# TYPE bvs_pool_imbalance_ratio gauge\n"
+		<< "bvs_pool_imbalance_ratio " << header->poolImbalance << "\n";
+
+	out << "# HELP bvs_module_executions_total Number of execute() calls of a module.\n"
+		<< "# TYPE bvs_module_executions_total counter\n";
+	for (uint32_t i=0; i<header->moduleCount; i++)
+		out << "bvs_module_executions_total{module=\"" << escape(modules[i].id) << "\"} " << modules[i].executions << "\n";
+	out << "# HELP bvs_module_duration_seconds Module wall time per round.\n"
+		<< "# TYPE bvs_module_duration_seconds histogram\n";
+	for (uint32_t i=0; i<header->moduleCount; i++)
+		histogram(out, "bvs_module_duration_seconds",
+				"module=\"" + escape(modules[i].id) + "\",pool=\"" + escape(modules[i].pool) + "\"",
+				modules[i].histogram, modules[i].durationSum, modules[i].executions);
+	out << "# HELP bvs_module_cpu_seconds_total Module cpu time.\n"
+		<< "# TYPE bvs_module_cpu_seconds_total counter\n";
+	for (uint32_t i=0; i<header->moduleCount; i++)
+		out << "bvs_module_cpu_seconds_total{module=\"" << escape(modules[i].id) << "\"} " << modules[i].cpuDurationSum/1e6 << "\n";
+	out << "# HELP bvs_module_status_total Rounds ending with a non-OK status.\n"
+		<< "# TYPE bvs_module_status_total counter\n";
+	for (uint32_t i=0; i<header->moduleCount; i++) {
+		out << "bvs_module_status_total{module=\"" << escape(modules[i].id) << "\",status=\"NOINPUT\"} " << modules[i].noinputCount << "\n";
+		out << "bvs_module_status_total{module=\"" << escape(modules[i].id) << "\",status=\"FAIL\"} " << modules[i].failCount << "\n";
+	}
+	out << "# HELP bvs_module_status Last module status (0=OK, 1=NOINPUT, 2=FAIL, 3=WAIT, 4=DONE, 5=SHUTDOWN).\n"
+		<< "# TYPE bvs_module_status gauge\n";
+	for (uint32_t i=0; i<header->moduleCount; i++)
+		out << "bvs_module_status{module=\"" << escape(modules[i].id) << "\"} " << modules[i].status << "\n";
+	out << "# HELP bvs_module_loaded Module is loaded.\n"
+		<< "# TYPE bvs_module_loaded gauge\n";
+	for (uint32_t i=0; i<header->moduleCount; i++)
+		out << "bvs_module_loaded{module=\"" << escape(modules[i].id) << "\"} " << modules[i].active << "\n";
+
+	out << "# HELP bvs_pool_busy_seconds_total Time pools spent executing modules.\n"
+		<< "# TYPE bvs_pool_busy_seconds_total counter\n";
+	for (uint32_t i=0; i<header->poolCount; i++)
+		out << "bvs_pool_busy_seconds_total{pool=\"" << escape(pools[i].name) << "\"} " << pools[i].busySum/1e6 << "\n";
+	out << "# HELP bvs_pool_idle_seconds_total Time pools spent waiting.\n"
+		<< "# TYPE bvs_pool_idle_seconds_total counter\n";
+	for (uint32_t i=0; i<header->poolCount; i++)
+		out << "bvs_pool_idle_seconds_total{pool=\"" << escape(pools[i].name) << "\"} " << pools[i].idleSum/1e6 << "\n";
+	out << "# HELP bvs_pool_utilization_ratio Pool utilization in the last round.\n"
+		<< "# TYPE bvs_pool_utilization_ratio gauge\n";
+	for (uint32_t i=0; i<header->poolCount; i++)
+		out << "bvs_pool_utilization_ratio{pool=\"" << escape(pools[i].name) << "\"} " << pools[i].utilization/100 << "\n";
+
+	out << "# HELP bvs_connector_messages_total Messages sent (outputs) or received (inputs).\n"
+		<< "# TYPE bvs_connector_messages_total counter\n";
+	for (uint32_t i=0; i<header->connectorCount; i++)
+		out << "bvs_connector_messages_total{connector=\"" << escape(connectors[i].name) << "\",direction=\""
+			<< (connectors[i].output ? "out" : "in") << "\"} "
+			<< (connectors[i].output ? connectors[i].sends : connectors[i].receives) << "\n";
+	out << "# HELP bvs_connector_bytes_total Bytes transferred (if the type exposes its size).\n"
+		<< "# TYPE bvs_connector_bytes_total counter\n";
+	for (uint32_t i=0; i<header->connectorCount; i++)
+		out << "bvs_connector_bytes_total{connector=\"" << escape(connectors[i].name) << "\"} " << connectors[i].bytes << "\n";
+	out << "# HELP bvs_connector_contended_total Lock acquisitions that had to wait.\n"
+		<< "# TYPE bvs_connector_contended_total counter\n";
+	for (uint32_t i=0; i<header->connectorCount; i++)
+		out << "bvs_connector_contended_total{connector=\"" << escape(connectors[i].name) << "\"} " << connectors[i].contended << "\n";
+	out << "# HELP bvs_connector_wait_seconds_total Time waited for connector locks.\n"
+		<< "# TYPE bvs_connector_wait_seconds_total counter\n";
+	for (uint32_t i=0; i<header->connectorCount; i++)
+		out << "bvs_connector_wait_seconds_total{connector=\"" << escape(connectors[i].name) << "\"} " << connectors[i].waitNanoseconds/1e9 << "\n";
+
+	return out.str();
+}
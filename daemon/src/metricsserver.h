@@ -0,0 +1,87 @@
+#ifndef BVSD_METRICSSERVER_H
+#define BVSD_METRICSSERVER_H
+
+#include <atomic>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bvs/logger.h"
+#include "bvs/statspage.h"
+
+
+
+/** BVSD namespace, contains only the bvs daemon. */
+namespace BVSD
+{
+	/** Minimal HTTP server exposing BVS metrics in Prometheus text format.
+	 * Serves 'GET /metrics' on a TCP address ('host:port') or a Unix socket
+	 * ('unix:/path'), see BVSD.metricsListen. Metrics are rendered from
+	 * snapshots of the statistics page (BVS.statsPage must be ON), so
+	 * scraping never touches the control loop.
+	 *
+	 * Exposed metrics: rounds, round duration histogram, utilization and
+	 * imbalance, per module executions, wall/cpu time (histogram), statuses
+	 * (NOINPUT/FAIL counts), per pool busy/idle time and per connector
+	 * traffic and contention.
+	 */
+	class MetricsServer
+	{
+		public:
+			/** Create server.
+			 * @param[in] listen Listen address, 'host:port' or 'unix:/path'.
+			 * @param[in] page Path of the statistics page.
+			 */
+			MetricsServer(const std::string& listen, const std::string& page);
+
+			/** Stop server. */
+			~MetricsServer();
+
+			/** Map statistics page, open socket and start server thread.
+			 * @return True on success.
+			 */
+			bool start();
+
+			/** Map statistics page (done by start()).
+			 * @return True on success.
+			 */
+			bool mapPage();
+
+			/** Render metrics from a page snapshot.
+			 * @return Metrics in Prometheus text format (empty while the page is being updated).
+			 */
+			std::string render();
+
+		private:
+			/** Open listening socket.
+			 * @return True on success.
+			 */
+			bool openSocket();
+
+			/** Server thread, accepts and answers requests. */
+			void run();
+
+			/** Answer a request.
+			 * @param[in] fd Client socket.
+			 */
+			void serve(int fd);
+
+			BVS::Logger logger; /**< Logger metadata. */
+			std::string listen; /**< Listen address. */
+			std::string pagePath; /**< Statistics page path. */
+			const BVS::StatsPageHeader* page; /**< Mapped statistics page. */
+			size_t pageSize; /**< Mapped size. */
+			std::vector<char> snapshot; /**< Snapshot buffer. */
+			int socket; /**< Listening socket. */
+			std::atomic<bool> running; /**< Server thread should keep running. */
+			std::thread thread; /**< Server thread. */
+
+			MetricsServer(const MetricsServer&) = delete; /**< -Weffc++ */
+			MetricsServer& operator=(const MetricsServer&) = delete; /**< -Weffc++ */
+	};
+} // namespace BVSD
+
+
+
+#endif //BVSD_METRICSSERVER_H
+
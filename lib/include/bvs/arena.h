@@ -0,0 +1,147 @@
+#ifndef BVS_ARENA_H
+#define BVS_ARENA_H
+
+#include <cstddef>
+
+#include "bvs/traits.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Monotonic memory arena for temporaries of a single module.
+	 * Every module gets its own arena (ModuleInfo::arena), the framework
+	 * resets it after each execution. Allocating is a pointer bump inside
+	 * the current chunk, deallocating does nothing. Since only the executing
+	 * pool thread uses a module's arena, it never needs a lock.
+	 *
+	 * Chunks are requested lazily, starting with BVS.arenaSize. If a round
+	 * needs more than one chunk, reset() replaces them with a single chunk
+	 * large enough for the whole round, so steady rounds do not allocate.
+	 *
+	 * Use it directly or through ArenaAllocator with standard containers:
+	 * @code
+	 * std::vector<int, BVS::ArenaAllocator<int>> values{*info.arena};
+	 * @endcode
+	 *
+	 * Memory from the arena must not be used after execute() returns.
+	 */
+	class BVS_PUBLIC Arena
+	{
+		public:
+			/** Create empty arena.
+			 * @param[in] chunkSize Size of the first chunk in bytes.
+			 */
+			Arena(size_t chunkSize);
+
+			/** Free all chunks. */
+			~Arena();
+
+			/** Allocate memory.
+			 * @param[in] size Size in bytes.
+			 * @param[in] alignment Alignment (power of two).
+			 * @return Pointer to memory (throws std::bad_alloc on failure).
+			 */
+			void* allocate(size_t size, size_t alignment = alignof(std::max_align_t));
+
+			/** Release all allocations, keeps (and merges) chunks. */
+			void reset();
+
+			/** Bytes allocated since the last reset.
+			 * @return Allocated bytes.
+			 */
+			size_t used() const { return allocated; }
+
+			/** Most bytes allocated between two resets.
+			 * @return High water mark in bytes.
+			 */
+			size_t highWaterMark() const { return highWater; }
+
+			/** Bytes allocated in the last round (before the last reset).
+			 * @return Allocated bytes.
+			 */
+			size_t lastUsed() const { return last; }
+
+			/** Size of all chunks.
+			 * @return Capacity in bytes.
+			 */
+			size_t capacity() const { return total; }
+
+		private:
+			/** Chunk header, followed by the chunk's memory. */
+			struct Chunk
+			{
+				Chunk* next; /**< Previous (full) chunk. */
+				size_t size; /**< Usable size. */
+			};
+
+			/** Add a chunk and make it current.
+			 * @param[in] size Usable size.
+			 */
+			void addChunk(size_t size);
+
+			/** Free all chunks. */
+			void release();
+
+			size_t chunkSize; /**< Size of the first chunk. */
+			Chunk* chunks; /**< Current chunk (list of all chunks). */
+			char* position; /**< Next free byte in current chunk. */
+			char* end; /**< End of current chunk. */
+			size_t allocated; /**< Bytes allocated since last reset. */
+			size_t last; /**< Bytes allocated in last round. */
+			size_t highWater; /**< High water mark. */
+			size_t total; /**< Size of all chunks. */
+
+			Arena(const Arena&) = delete; /**< -Weffc++ */
+			Arena& operator=(const Arena&) = delete; /**< -Weffc++ */
+	};
+
+
+
+	/** Standard allocator handing out memory of an Arena.
+	 * Deallocation does nothing, the arena is reset by the framework.
+	 */
+	template<typename T> class ArenaAllocator
+	{
+		public:
+			using value_type = T; /**< Allocated type. */
+
+			/** Construct allocator.
+			 * @param[in] arena Arena to allocate from.
+			 */
+			ArenaAllocator(Arena& arena) noexcept : arena(&arena) {}
+
+			/** Rebind allocator. */
+			template<typename U> ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena(other.arena) {}
+
+			/** Allocate memory for n objects. */
+			T* allocate(size_t n) { return static_cast<T*>(arena->allocate(n*sizeof(T), alignof(T))); }
+
+			/** Deallocate memory (does nothing). */
+			void deallocate(T*, size_t) noexcept {}
+
+			Arena* arena; /**< Arena to allocate from. */
+	};
+
+
+
+	/** Allocators are equal if they use the same arena. */
+	template<typename T, typename U> bool operator==(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+	{
+		return a.arena==b.arena;
+	}
+
+
+
+	/** Allocators are equal if they use the same arena. */
+	template<typename T, typename U> bool operator!=(const ArenaAllocator<T>& a, const ArenaAllocator<U>& b)
+	{
+		return a.arena!=b.arena;
+	}
+} // namespace BVS
+
+
+
+#endif //BVS_ARENA_H
+
@@ -0,0 +1,56 @@
+#ifndef BVS_BENCHMARK_H
+#define BVS_BENCHMARK_H
+
+#include <map>
+#include <string>
+
+#include "bvs/traits.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Distribution of durations, all values in microseconds. */
+	struct BVS_PUBLIC DurationSummary
+	{
+		double mean; /**< Mean. */
+		double p50; /**< Median. */
+		double p90; /**< 90th percentile. */
+		double p99; /**< 99th percentile. */
+		double max; /**< Maximum. */
+	};
+
+
+
+	/** Result of a benchmark run, see BVS::benchmark().
+	 * Only measured rounds are included, warmup rounds are discarded.
+	 */
+	struct BVS_PUBLIC BenchmarkSummary
+	{
+		unsigned long long warmupRounds; /**< Rounds run before measuring. */
+		unsigned long long rounds; /**< Measured rounds. */
+		double seconds; /**< Wall time of the measured rounds. */
+		double roundsPerSecond; /**< Throughput. */
+		DurationSummary roundTime; /**< Round durations. */
+		std::map<std::string, DurationSummary> modules; /**< Module execution times. */
+		std::map<std::string, DurationSummary> pools; /**< Pool busy times. */
+		std::map<std::string, DurationSummary> poolIdle; /**< Pool idle times (waiting on the barrier). */
+		long peakRSS; /**< Peak resident set size of the process in KB. */
+
+		/** Human readable summary.
+		 * @return Summary text (multiple lines).
+		 */
+		std::string text() const;
+
+		/** Summary as JSON.
+		 * @return JSON document.
+		 */
+		std::string json() const;
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_BENCHMARK_H
+
@@ -0,0 +1,106 @@
+#ifndef BVS_BINARYLOG_H
+#define BVS_BINARYLOG_H
+
+#include <cstdint>
+#include <cstring>
+#include <ostream>
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Binary log layout version, increased on incompatible changes. */
+	static const uint32_t binaryLogVersion = 1;
+
+	/** Binary log file header.
+	 * The binary log (BVS.logFormat = BINARY) is a memory-mapped file of
+	 * BVS.logBinarySize MB starting with this header, followed by records.
+	 * Every record starts with [uint32_t size][uint8_t type] (size includes
+	 * these 5 bytes), all values are unaligned in native byte order:
+	 *
+	 * @li \c binaryLogSite [uint32_t site][uint32_t line][uint16_t length][file][uint16_t length][expression]
+	 * @li \c binaryLogLogger [uint32_t logger][name]
+	 * @li \c binaryLogMessage [uint8_t level][uint32_t site][uint32_t logger][uint32_t thread][uint64_t time][arguments]
+	 *
+	 * Site and logger records are written once, before their first message.
+	 * Every argument is a tag followed by its value, see binaryLogBool etc.
+	 * The unused rest of the file is zero, so a record size of 0 ends the
+	 * log. Decode with 'bvs-logdecode'.
+	 */
+	struct BinaryLogHeader
+	{
+		char magic[8]; /**< "BVSBLOG\0". */
+		uint32_t version; /**< Layout version, see binaryLogVersion. */
+		uint32_t headerSize; /**< Size of this header. */
+		uint64_t pid; /**< Process id. */
+		uint64_t startTime; /**< System clock when the log was opened in ns. */
+	};
+
+	static const uint8_t binaryLogSite = 'S'; /**< Record: call site (file, line, LOG arguments). */
+	static const uint8_t binaryLogLogger = 'L'; /**< Record: logger name. */
+	static const uint8_t binaryLogMessage = 'M'; /**< Record: message. */
+
+	static const uint8_t binaryLogBool = 'b'; /**< Argument: uint8_t. */
+	static const uint8_t binaryLogChar = 'c'; /**< Argument: char. */
+	static const uint8_t binaryLogInt = 'i'; /**< Argument: int64_t. */
+	static const uint8_t binaryLogUnsigned = 'u'; /**< Argument: uint64_t. */
+	static const uint8_t binaryLogDouble = 'f'; /**< Argument: double. */
+	static const uint8_t binaryLogPointer = 'p'; /**< Argument: uint64_t address. */
+	static const uint8_t binaryLogString = 's'; /**< Argument: [uint32_t length][characters]. */
+
+
+
+	/** Read a raw argument value, advancing position.
+	 * @return False if the value exceeds the end.
+	 */
+	template<typename T> inline bool readBinaryLogValue(const char*& position, const char* end, T& value)
+	{
+		if (position+sizeof(value) > end) return false;
+		memcpy(&value, position, sizeof(value));
+		position += sizeof(value);
+		return true;
+	}
+
+
+
+	/** Format tagged argument values (see binaryLogMessage) to a stream.
+	 * Used by 'bvs-logdecode' and by the text log for messages captured for
+	 * duplicate suppression.
+	 * @param[in] position Start of the arguments.
+	 * @param[in] end End of the arguments.
+	 * @param[in,out] out Stream to format to.
+	 * @return False if an argument was malformed (formatting stops there).
+	 */
+	inline bool formatBinaryLogArguments(const char* position, const char* end, std::ostream& out)
+	{
+		while (position<end) {
+			uint8_t tag = *position++;
+			bool ok = true;
+			switch (tag) {
+				case binaryLogBool: { uint8_t v; ok = readBinaryLogValue(position, end, v); if (ok) out << bool(v); break; }
+				case binaryLogChar: { char v; ok = readBinaryLogValue(position, end, v); if (ok) out << v; break; }
+				case binaryLogInt: { int64_t v; ok = readBinaryLogValue(position, end, v); if (ok) out << v; break; }
+				case binaryLogUnsigned: { uint64_t v; ok = readBinaryLogValue(position, end, v); if (ok) out << v; break; }
+				case binaryLogDouble: { double v; ok = readBinaryLogValue(position, end, v); if (ok) out << v; break; }
+				case binaryLogPointer: { uint64_t v; ok = readBinaryLogValue(position, end, v); if (ok) out << "0x" << std::hex << v << std::dec; break; }
+				case binaryLogString: {
+					uint32_t length;
+					ok = readBinaryLogValue(position, end, length) && position+length<=end;
+					if (ok) out.write(position, length);
+					position += ok ? length : 0;
+					break;
+				}
+				default: ok = false;
+			}
+			if (!ok) return false;
+		}
+
+		return true;
+	}
+} // namespace BVS
+
+
+
+#endif //BVS_BINARYLOG_H
+
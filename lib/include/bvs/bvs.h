@@ -5,6 +5,7 @@
 #include <iostream>
 #include <string>
 
+#include "bvs/benchmark.h"
 #include "bvs/config.h"
 #include "bvs/connector.h"
 #include "bvs/info.h"
@@ -25,6 +26,7 @@ namespace BVS
 	// Forward declarations
 	class Loader;
 	class Control;
+	class ConfigWatcher;
 
 
 
@@ -45,8 +47,35 @@ namespace BVS
 	 * @li \c logSystem enables the logging system (ON/OFF).
 	 * @li \c logConsole enables console output (ON/OFF).
 	 * @li \c logFile enables logging to file (""/$FILE/+$FILE, '+' appends).
+	 * @li \c logFileMaxSize rotates the log file at the given size (0/1/2... MB).
+	 * @li \c logFileSegments sets the number of rotated log files to keep (1/2/3...).
+	 * @li \c logJSON enables a JSON log with one object per message (""/$FILE/+$FILE, '+' appends).
 	 * @li \c logVerbosity sets the overall log verbosity (0/1/2/3...).
+	 * @li \c logAsync writes log messages from a background thread (ON/OFF).
+	 * @li \c logBufferSize sets the size of each thread's log ring buffer (bytes).
+	 * @li \c logOverflow selects what happens if a log ring buffer is full (BLOCK/DROP/COUNT).
+	 * @li \c logFormat selects text or binary log messages (TEXT/BINARY).
+	 * @li \c logBinaryFile sets the binary log file ($FILE).
+	 * @li \c logBinarySize sets the size of the binary log (1/2/3... MB).
 	 * @li \c logStatistics enables statistics output (ON/OFF).
+	 * @li \c connectorStatistics enables connection statistics output on shutdown (ON/OFF).
+	 * @li \c flightRecorder sets the number of recent rounds kept by the flight recorder (0/1/2/...).
+	 * @li \c flightRecorderSlots sets the maximum number of recorded modules (1/2/3...).
+	 * @li \c flightRecorderFile sets the flight recorder dump file ($FILE).
+	 * @li \c flightRecorderFormat sets the flight recorder dump format (JSON/BINARY).
+	 * @li \c stallThreshold dumps the flight recorder if a round takes longer (0/1/2... ms).
+	 * @li \c stallDumpInterval sets the minimal time between two of these dumps (0/1/2... ms).
+	 * @li \c statsPage publishes statistics to '/dev/shm/bvs-<pid>' for external tools like bvs-top (ON/OFF).
+	 * @li \c statsPageSlots sets the maximum number of modules/pools (4x connectors) in the statistics page (1/2/3...).
+	 * @li \c watchdogInterval sets the interval in which module budgets (<module>.budgetMs) are checked (1/2/3... ms).
+	 * @li \c watchdogShutdownFactor calls the shutdown handler if an execution exceeds its budget this many times (0/1/2...).
+	 * @li \c perfCounters lists performance counters to read around each module execution (Linux only).
+	 * @li \c configWatch applies changes of the loaded config files between rounds (ON/OFF, Linux only).
+	 * @li \c loadThreads sets the number of threads opening libraries and constructing modules (1/2/3...).
+	 * @li \c allocationTracking counts heap allocations of modules and framework each round (ON/OFF, needs BVS_ALLOCATION_TRACKING).
+	 * @li \c allocationStrict aborts if the framework allocates in a steady-state round (ON/OFF).
+	 * @li \c allocationWarmup sets the number of rounds before rounds are considered steady (0/1/2...).
+	 * @li \c arenaSize sets the size of the first chunk of each module's arena (1/2/3... KB).
 	 * @li \c parallelism allows modules to run in dedicated (forced) threads or pools (NONE/THREAD/FORCE/ANY).
 	 * @li \c modules lists modules to load and their options.
 	 *
@@ -88,6 +117,14 @@ namespace BVS
 	 * YourLogger = ...
 	 * @endcode
 	 *
+	 * Message storms (e.g. a module missing its input every round) can be
+	 * limited per logger, see Logger::Limits:
+	 * @code
+	 * [Logger]
+	 * Control.rateLimit = 10 # messages per second and call site
+	 * Control.suppressDuplicates = ON # write repeats once per second with a count
+	 * @endcode
+	 *
 	 * If you want to override configuration options on the command line, make sure
 	 * to pass argc and argv to BVS. Then you can override command line options with:
 	 * @code
@@ -103,6 +140,9 @@ namespace BVS
 			 * @param[in] argc Main's argc.
 			 * @param[in] argv Main's argv, used to pass config options to BVS, see Config.
 			 * @param[in] shutdownHandler A function the framework calls upon shutting down.
+			 * It is called by the master after the shutdown rounds, or by the
+			 * watchdog thread while a module hangs (see watchdogShutdownFactor),
+			 * in which case waiting for the system (e.g. quit()) never returns.
 			 */
 			BVS(const int argc, const char** argv, std::function<void()> shutdownHandler = [](){ exit(1);} );
 
@@ -111,6 +151,9 @@ namespace BVS
 			~BVS();
 
 			/** Load modules selected by config variable [BVS]modules.
+			 * Libraries are opened and modules constructed by BVS.loadThreads
+			 * threads, then all modules are started in configuration order.
+			 * Logs startup timings of every module.
 			 * @return Reference to object.
 			 */
 			BVS& loadModules();
@@ -153,6 +196,14 @@ namespace BVS
 			 */
 			BVS& loadConfigFile(const std::string& configFile);
 
+			/** Apply config changes staged by Config::stageReload (e.g. by BVS.configWatch).
+			 * Refreshes config handles, notifies subscribers and updates logger
+			 * levels, watches newly sourced files. Called by the master controller
+			 * between rounds.
+			 * @return Reference to object.
+			 */
+			BVS& applyConfigChanges();
+
 			/** Set the log system verbosity.
 			 * This sets the logging system's overall verbosity.
 			 * Only messages with logging level lower or equal with be displayed.
@@ -240,6 +291,41 @@ namespace BVS
 			 */
 			BVS& hotSwap(const std::string& id);
 
+			/** Log connection statistics.
+			 * Logs traffic (sends, receives, bytes) and contention (lock
+			 * acquisitions, contended acquisitions, time waited) of every
+			 * connection between modules.
+			 * @return Reference to object.
+			 */
+			BVS& logConnectorStatistics();
+
+			/** Dump the flight recorder.
+			 * Writes timings, statuses and output sequence numbers of the most
+			 * recent rounds to BVS.flightRecorderFile. Does not allocate, so
+			 * it can be used from signal handlers (e.g. on SIGSEGV).
+			 * @return Reference to object.
+			 */
+			BVS& dumpFlightRecorder();
+
+			/** Run a benchmark.
+			 * Runs warmupRounds + rounds rounds as fast as possible (ignores
+			 * BVS.minRoundTime) and returns round, pool and module timings of
+			 * the measured rounds. Blocks until done, the master controller
+			 * must have been started unforked (start(false)).
+			 * @param[in] warmupRounds Rounds to run before measuring.
+			 * @param[in] rounds Rounds to measure.
+			 * @return Summary of the measured rounds.
+			 */
+			BenchmarkSummary benchmark(unsigned long long warmupRounds, unsigned long long rounds);
+
+			/** Write all pending log messages.
+			 * Only has an effect with asynchronous logging (BVS.logAsync), waits
+			 * only a bounded time for the log system, so it can be used from
+			 * signal handlers (e.g. on SIGSEGV).
+			 * @return Reference to object.
+			 */
+			BVS& flushLog();
+
 			/** Tells the system to quit.
 			 * This will signal the system's controller to issue a quit signal to
 			 * all modules after which it will start to shutdown the entire system
@@ -252,6 +338,24 @@ namespace BVS
 			std::function<void()> shutdownHandler; /**< Function to call when shutting system down. */
 
 		private:
+			/** Parsed module traits, see loadModule(). */
+			struct ModuleTraits
+			{
+				std::string id; /**< Module id. */
+				std::string library; /**< Library to load the module from. */
+				std::string configuration; /**< Configuration section. */
+				std::string options; /**< Connector settings. */
+				std::string poolName; /**< Pool to run the module in (empty for master). */
+			};
+
+			/** Separate module id, library, configuration and options.
+			 * @param[in] moduleTraits The module id, library name and connector settings, see loadModule().
+			 * @param[in] singlePool Select, if the module should run in it's own pool(thread).
+			 * @param[in] poolName Select, if desired, the module pool to execute this module.
+			 * @return Parsed traits, adapted to BVS.parallelism.
+			 */
+			ModuleTraits parseModuleTraits(const std::string& moduleTraits, bool singlePool, std::string poolName);
+
 			Info info; //**< BVS' information object. */
 #ifdef BVS_LOG_SYSTEM
 			std::shared_ptr<LogSystem> logSystem; /**< Internal log system backend. */
@@ -259,9 +363,11 @@ namespace BVS
 #endif
 			Loader* loader; /**< BVS' module loader. */
 			Control* control; /**< BVS' module controller. */
+			ConfigWatcher* configWatcher; /**< BVS' config file watcher (nullptr if disabled). */
 			std::stack<std::string> moduleStack; /**< Stack of modules names. */
 
 			bool connectorTypeMatching; /**< Try to match connector types. */
+			bool connectorStatistics; /**< Log connector statistics on shutdown. */
 			std::string parallelism; /**< Type of parallism to use. */
 
 			BVS(const BVS&) = delete; /**< -Weffc++ */
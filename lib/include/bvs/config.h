@@ -1,11 +1,15 @@
 #ifndef BVS_CONFIG_H
 #define BVS_CONFIG_H
 
+#include <atomic>
+#include <functional>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <sstream>
 #include <stack>
 #include <string>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -16,6 +20,184 @@
 /** BVS namespace, contains all library stuff. */
 namespace BVS
 {
+	class Config;
+
+
+
+	/** Cached value of a config handle, refreshed by Config whenever options change.
+	 * Values are usually created from module code, so Config only keeps a
+	 * plain pointer, which the (library defined) destructor removes again.
+	 * Thus, nothing owned by Config depends on code of unloaded modules.
+	 */
+	class BVS_PUBLIC ConfigValueBase
+	{
+		public:
+			/** Construct value.
+			 * @param[in] config Config the value will be registered with.
+			 */
+			ConfigValueBase(const Config& config) : config(&config) {}
+
+			/** Unregister value from its config. */
+			virtual ~ConfigValueBase();
+
+			/** Look up and parse the option again.
+			 * @param[in] config Config to read from.
+			 */
+			virtual void refresh(const Config& config) = 0;
+
+			/** Delete values replaced by earlier refreshes. */
+			virtual void reclaim() = 0;
+
+		protected:
+			/** Unregister value, derived classes call this first in their destructor. */
+			void release();
+
+		private:
+			const Config* config; /**< Config the value is registered with (nullptr once released). */
+
+			ConfigValueBase(const ConfigValueBase&) = delete; /**< -Weffc++ */
+			ConfigValueBase& operator=(const ConfigValueBase&) = delete; /**< -Weffc++ */
+	};
+
+
+
+	/** Storage of a cached value, atomic for trivially copyable types. */
+	template<typename T, bool = std::is_trivially_copyable<T>::value> class ConfigStorage
+	{
+		public:
+			typedef T Value; /**< Type returned by load(). */
+
+			/** Construct storage. @param[in] t Initial value. */
+			ConfigStorage(const T& t) : value{t} {}
+
+			/** Load value. @return Value. */
+			T load() const { return value.load(std::memory_order_relaxed); }
+
+			/** Store value. @param[in] t New value. */
+			void store(const T& t) { value.store(t, std::memory_order_relaxed); }
+
+			/** Nothing to reclaim. */
+			void reclaim() {}
+
+		private:
+			std::atomic<T> value; /**< Value. */
+	};
+
+
+
+	/** Storage of a cached value, other types are swapped as immutable copies.
+	 * load() is a single atomic pointer load (no locking, no reference
+	 * counting). Replaced copies are retired instead of deleted and only
+	 * reclaimed between rounds (see Config::reclaim), so a loaded copy stays
+	 * valid until the end of the round, even if the option changes.
+	 */
+	template<typename T> class ConfigStorage<T, false>
+	{
+		public:
+			typedef const T* Value; /**< Type returned by load(). */
+
+			/** Construct storage. @param[in] t Initial value. */
+			ConfigStorage(const T& t) : value{new T(t)}, retired{} {}
+
+			/** Delete current copy. */
+			~ConfigStorage() { delete value.load(std::memory_order_relaxed); }
+
+			/** Load value. @return Current immutable copy (valid until the end of the round). */
+			const T* load() const { return value.load(std::memory_order_acquire); }
+
+			/** Store value, retires the current copy. @param[in] t New value. */
+			void store(const T& t) { retired.emplace_back(value.exchange(new T(t), std::memory_order_acq_rel)); }
+
+			/** Delete retired copies, no reader may hold them anymore. */
+			void reclaim() { retired.clear(); }
+
+		private:
+			std::atomic<const T*> value; /**< Current copy. */
+			std::vector<std::unique_ptr<const T>> retired; /**< Replaced copies (guarded by the Config mutex). */
+
+			ConfigStorage(const ConfigStorage&) = delete; /**< -Weffc++ */
+			ConfigStorage& operator=(const ConfigStorage&) = delete; /**< -Weffc++ */
+	};
+
+
+
+	/** Cached value of one option. */
+	template<typename T> class ConfigValue : public ConfigValueBase
+	{
+		public:
+			/** Construct value.
+			 * @param[in] sectionOption The option, in form "section.option".
+			 * @param[in] defaultValue Default value if the option is not found.
+			 * @param[in] config Config to read the initial value from.
+			 */
+			ConfigValue(const std::string& sectionOption, const T& defaultValue, const Config& config);
+
+			/** Unregister value before it is destroyed, so it is not refreshed anymore. */
+			virtual ~ConfigValue() { release(); }
+
+			/** Look up and parse the option again.
+			 * @param[in] config Config to read from.
+			 */
+			virtual void refresh(const Config& config);
+
+			/** Delete values replaced by earlier refreshes. */
+			virtual void reclaim() { value.reclaim(); }
+
+			const std::string sectionOption; /**< The option. */
+			const T defaultValue; /**< Default value. */
+			ConfigStorage<T> value; /**< Current value. */
+	};
+
+
+
+	/** Typed handle to a config option.
+	 * A handle looks up and parses its option once, get() only loads the
+	 * cached value (atomically, so handles can be read from any thread). The
+	 * Config refreshes all handles whenever its options change, so handles
+	 * are the way to read options inside execute(), e.g.:
+	 * @code
+	 * // in your module's constructor
+	 * , threshold{bvs.config.handle<int>(info.conf + ".threshold", 5)}
+	 *
+	 * // in execute()
+	 * if (value > threshold.get()) ...
+	 * @endcode
+	 * Types that are not trivially copyable (e.g. std::string) are returned
+	 * as const T* to the current immutable copy, so get() never allocates or
+	 * locks, e.g. 'if (*name.get()=="left")'. The copy stays valid until the
+	 * end of the round, do not keep the pointer any longer.
+	 * Lists (std::vector) are not supported, use getValue for those.
+	 * @tparam T Type of the option.
+	 */
+	template<typename T> class ConfigHandle
+	{
+		public:
+			/** Construct unbound handle, assign a handle from Config::handle before use. */
+			ConfigHandle() : value{} {}
+
+			/** Get the option's current value.
+			 * @return Value (const T* for types that are not trivially copyable).
+			 */
+			typename ConfigStorage<T>::Value get() const { return value->value.load(); }
+
+			/** Get the option's name.
+			 * @return Option in form "section.option".
+			 */
+			const std::string& getOption() const { return value->sectionOption; }
+
+		private:
+			/** Construct handle.
+			 * @param[in] value Cached value.
+			 */
+			ConfigHandle(std::shared_ptr<ConfigValue<T>> value) : value{value} {}
+
+			std::shared_ptr<ConfigValue<T>> value; /**< Cached value (shared with Config). */
+
+			friend class Config;
+	};
+
+
+
 	/** The BVS configuration mechanism.
 	 * This is the BVS configuration system. Option-value pairs are taken from the
 	 * command line and loaded from config files. Option names are handled case
@@ -83,6 +265,13 @@ namespace BVS
 	 * when not in single or double quotes, as your $SHELL will most likely use
 	 * them as an argument delimiter (you have been warned).
 	 * @see loadCommandLine
+	 *
+	 * Loaded config files (including sourced ones) can be reloaded while the
+	 * system is running: stageReload() parses all files again (command line
+	 * options still take precedence) and keeps the result, applyReload()
+	 * replaces the options, refreshes all handles and notifies subscribers
+	 * of the changed options. BVS applies staged changes between rounds, see
+	 * BVS.configWatch.
 	 */
 	class BVS_PUBLIC Config
 	{
@@ -136,6 +325,62 @@ namespace BVS
 			 */
 			template<typename T> const Config& getValue(const std::string& sectionOption, std::vector<T>& t) const;
 
+			/** Template to create a typed handle to an option.
+			 * The option is looked up and parsed once and again whenever the
+			 * options change, ConfigHandle::get only loads the cached value.
+			 * @param[in] sectionOption The desired option, should be in form "section.option".
+			 * @param[in] defaultValue Default value to be used if desired option is not found.
+			 * @tparam T Type argument.
+			 * @return Handle to the option.
+			 */
+			template<typename T> ConfigHandle<T> handle(const std::string& sectionOption, T defaultValue) const;
+
+			/** Callback for changed options, receives the names of all added, removed or changed options. */
+			typedef std::function<void(const std::vector<std::string>& options)> ChangeCallback;
+
+			/** Subscribe to option changes by applyReload().
+			 * Callbacks are called by the thread applying the changes (between
+			 * rounds), after all handles were refreshed. Modules must
+			 * unsubscribe in their destructor, as the callback's code is
+			 * unloaded with the module.
+			 * @param[in] callback Function to call.
+			 * @return Subscription id for unsubscribe().
+			 */
+			unsigned int subscribe(ChangeCallback callback) const;
+
+			/** Cancel a subscription.
+			 * @param[in] id Subscription id from subscribe().
+			 */
+			void unsubscribe(unsigned int id) const;
+
+			/** List all loaded config files, including sourced ones.
+			 * @return File names as given when loading.
+			 */
+			std::vector<std::string> getLoadedFiles() const;
+
+			/** Parse all loaded config files again and stage changed options.
+			 * Parse errors are logged but not fatal, the options stay unchanged.
+			 * @return True if changed options (or a changed list of sourced files) were staged.
+			 */
+			bool stageReload();
+
+			/** Whether stageReload() staged changes that were not applied yet.
+			 * @return True if changes are pending.
+			 */
+			bool hasPendingReload() const { return reloadPending.load(std::memory_order_acquire); }
+
+			/** Apply staged options and loaded files, refresh handles and notify subscribers.
+			 * @return Names of all added, removed or changed options.
+			 */
+			std::vector<std::string> applyReload();
+
+			/** Delete handle values replaced by earlier refreshes.
+			 * Values loaded from handles may be used until the end of the round,
+			 * so BVS calls this between rounds. Only checks a flag if nothing
+			 * was replaced.
+			 */
+			void reclaim();
+
 			const std::string name; /**< Instance's name. */
 
 		private:
@@ -150,6 +395,48 @@ namespace BVS
 			/** A stack of the current config and line. */
 			std::stack<std::pair<std::string, int>> fileStack;
 
+			/** Values of all handles. */
+			mutable std::vector<ConfigValueBase*> handles;
+
+			/** Register a handle's value.
+			 * @param[in] value Value to refresh on changes.
+			 */
+			void registerHandle(ConfigValueBase* value) const;
+
+			/** Unregister a handle's value.
+			 * @param[in] value Value to forget.
+			 */
+			void unregisterHandle(ConfigValueBase* value) const;
+
+			/** Refresh all handles after options changed. */
+			void refreshHandles();
+
+			/** Options given on the command line (override config files on reload). */
+			std::map<std::string, std::string> commandLineOptions;
+
+			/** Config files loaded directly (not sourced), in order. */
+			std::vector<std::string> configFiles;
+
+			/** All loaded config files, including sourced ones. */
+			std::vector<std::string> loadedFiles;
+
+			/** Options staged by stageReload(). */
+			std::map<std::string, std::string> stagedOptions;
+
+			/** Sections staged by stageReload(). */
+			std::map<std::string, std::string> stagedSections;
+
+			/** Loaded files staged by stageReload(). */
+			std::vector<std::string> stagedFiles;
+
+			std::atomic<bool> reloadPending; /**< Whether staged options are pending. */
+			std::atomic<bool> valuesRetired; /**< Whether handles hold replaced values (see reclaim()). */
+			bool reloading; /**< Parse errors are not fatal (while staging). */
+			mutable bool reloadFailed; /**< A parse error occured while staging. */
+
+			mutable std::map<unsigned int, ChangeCallback> subscribers; /**< Change subscribers by id. */
+			mutable unsigned int subscriberCount; /**< Last subscription id. */
+
 			/** Loads the given arguments into the system.
 			 * This checks argv for occurences of --$NAME.config and
 			 * --$NAME.options.
@@ -186,6 +473,8 @@ namespace BVS
 			 * @return Converted argument of desired type.
 			 */
 			template<typename T> T convertStringTo(const std::string& input) const;
+
+			friend class ConfigValueBase;
 	};
 
 
@@ -242,6 +531,31 @@ namespace BVS
 
 
 
+	template<typename T> ConfigHandle<T> Config::handle(const std::string& sectionOption, T defaultValue) const
+	{
+		std::shared_ptr<ConfigValue<T>> value = std::make_shared<ConfigValue<T>>(sectionOption, defaultValue, *this);
+		registerHandle(value.get());
+		return ConfigHandle<T>{value};
+	}
+
+
+
+	template<typename T> ConfigValue<T>::ConfigValue(const std::string& sectionOption, const T& defaultValue, const Config& config)
+		: ConfigValueBase{config}
+		, sectionOption{sectionOption}
+		, defaultValue{defaultValue}
+		, value{config.getValue<T>(sectionOption, defaultValue)}
+	{ }
+
+
+
+	template<typename T> void ConfigValue<T>::refresh(const Config& config)
+	{
+		value.store(config.getValue<T>(sectionOption, defaultValue));
+	}
+
+
+
 	template<typename T> const Config& Config::convertStringTo(const std::string& input, T& t) const
 	{
 		std::istringstream stream{input};
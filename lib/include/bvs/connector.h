@@ -1,13 +1,16 @@
 #ifndef BVS_CONNECTOR_H
 #define BVS_CONNECTOR_H
 
+#include <algorithm>
 #include <atomic>
+#include <cctype>
+#include <chrono>
 #include <iostream>
 #include <map>
 #include <memory>
 #include <mutex>
-#include <regex>
 #include <string>
+#include <type_traits>
 #include <typeinfo>
 
 #include "bvs/connectordata.h"
@@ -18,6 +21,40 @@
 /** BVS namespace, contains all library stuff. */
 namespace BVS
 {
+	/** Payload size of objects sent through a Connector, used for traffic statistics.
+	 * Containers exposing size() and value_type (e.g. std::vector,
+	 * std::string) report size()*sizeof(value_type), other trivially
+	 * copyable types their sizeof(), everything else 0. Specialize this for
+	 * your own types if necessary:
+	 * @code
+	 * template<> struct BVS::PayloadSize<cv::Mat>
+	 * {
+	 *	static size_t size(const cv::Mat& t) { return t.total()*t.elemSize(); }
+	 * };
+	 * @endcode
+	 */
+	template<typename T, typename = void> struct PayloadSize
+	{
+		/** @return Payload size in bytes. */
+		static size_t size(const T&) { return std::is_trivially_copyable<T>::value ? sizeof(T) : 0; }
+	};
+
+
+
+	/** Used by PayloadSize to detect containers. */
+	template<typename...> struct PayloadVoid { using type = void; };
+
+
+
+	/** PayloadSize for containers. */
+	template<typename T> struct PayloadSize<T, typename PayloadVoid<typename T::value_type, decltype(std::declval<const T&>().size())>::type>
+	{
+		/** @return Payload size in bytes. */
+		static size_t size(const T& t) { return t.size()*sizeof(typename T::value_type); }
+	};
+
+
+
 	/** The connection between modules, sends and receives arbitrary data.
 	 * This class provides access to creating connections between different
 	 * modules by creating a connector on each side and then pushing data
@@ -94,6 +131,9 @@ namespace BVS
 			void unlockConnection();
 
 		private:
+			/** Lock the connection and update the contention statistics. */
+			void acquire();
+
 			/** Activate connector.
 			 * This means that an input is actually connected to an output enabling
 			 * data to be retrieved. Before this executes, the connector will only
@@ -128,10 +168,12 @@ namespace BVS
 						false}}}
 	{
 		Logger logger{"Connector"};
-		if (ConnectorDataCollector::connectors.find(connectorName)==ConnectorDataCollector::connectors.end()) {
-			if (!std::regex_match(connectorName, std::regex{"[-_[:alnum:]]+"}))
+		ConnectorMap& connectors = ConnectorDataCollector::connectors();
+		if (connectors.find(connectorName)==connectors.end()) {
+			if (connectorName.empty() || !std::all_of(connectorName.begin(), connectorName.end(),
+						[](char c){ return std::isalnum(static_cast<unsigned char>(c)) || c=='-' || c=='_'; }))
 				LOG(0, "invalid name, only alphanumeric characters and '_-' are allowed: " << connectorName);
-			ConnectorDataCollector::connectors[connectorName] = data;
+			connectors[connectorName] = data;
 		} else {
 			LOG(0, "connector already exists: " << connectorName);
 		}
@@ -173,9 +215,12 @@ namespace BVS
 			LOG(0, "writing to INPUT connector!");
 		}
 
-		if (data->active && !data->locked) data->lock.lock();
+		if (data->active && !data->locked) acquire();
 		*connection = t;
 		if (data->active && !data->locked) data->lock.unlock();
+
+		data->statistics.sends.fetch_add(1, std::memory_order_relaxed);
+		data->statistics.bytes.fetch_add(PayloadSize<T>::size(t), std::memory_order_relaxed);
 	}
 
 
@@ -191,10 +236,13 @@ namespace BVS
 
 		if (!data->active && !activate()) return false;
 
-		if (data->active && !data->locked) data->lock.lock();
+		if (data->active && !data->locked) acquire();
 		t = *connection;
 		if (data->active && !data->locked) data->lock.unlock();
 
+		data->statistics.receives.fetch_add(1, std::memory_order_relaxed);
+		data->statistics.bytes.fetch_add(PayloadSize<T>::size(t), std::memory_order_relaxed);
+
 		return data->active;
 	}
 
@@ -222,7 +270,7 @@ namespace BVS
 	{
 		if (data->active)
 		{
-			data->lock.lock();
+			acquire();
 			data->locked = true;
 		}
 	}
@@ -240,6 +288,21 @@ namespace BVS
 
 
 
+	template<typename T> void Connector<T>::acquire()
+	{
+		data->statistics.acquisitions.fetch_add(1, std::memory_order_relaxed);
+		if (data->lock.try_lock()) return;
+
+		std::chrono::time_point<std::chrono::steady_clock> waitTimer = std::chrono::steady_clock::now();
+		data->lock.lock();
+		data->statistics.contended.fetch_add(1, std::memory_order_relaxed);
+		data->statistics.waitNanoseconds.fetch_add(
+				std::chrono::duration_cast<std::chrono::nanoseconds>
+				(std::chrono::steady_clock::now() - waitTimer).count(), std::memory_order_relaxed);
+	}
+
+
+
 	template<typename T> bool Connector<T>::activate()
 	{
 		if (connection == nullptr && data->pointer != nullptr)
@@ -1,6 +1,7 @@
 #ifndef BVS_CONNECTORDATA_H
 #define BVS_CONNECTORDATA_H
 
+#include <atomic>
 #include <mutex>
 #include <iostream>
 #include <map>
@@ -43,6 +44,36 @@ namespace BVS
 
 
 
+	/** Connector traffic and contention statistics.
+	 * Counted by the connector owning this data, i.e. an output counts its
+	 * sends and an input its receives, so counters are (mostly) only
+	 * modified by one thread.
+	 */
+	struct ConnectorStatistics
+	{
+		/** Creates zeroed statistics. */
+		ConnectorStatistics()
+			: acquisitions{0},
+			contended{0},
+			waitNanoseconds{0},
+			sends{0},
+			receives{0},
+			bytes{0}
+		{ }
+
+		std::atomic<unsigned long long> acquisitions; /**< Number of lock acquisitions. */
+		std::atomic<unsigned long long> contended; /**< Number of acquisitions that had to wait. */
+		std::atomic<unsigned long long> waitNanoseconds; /**< Total time waited for the lock. */
+		std::atomic<unsigned long long> sends; /**< Number of sends. */
+		std::atomic<unsigned long long> receives; /**< Number of receives. */
+		std::atomic<unsigned long long> bytes; /**< Bytes transferred (if the type exposes its size). */
+
+		ConnectorStatistics(const ConnectorStatistics&) = delete; /**< -Weffc++ */
+		ConnectorStatistics& operator=(const ConnectorStatistics&) = delete; /**< -Weffc++ */
+	};
+
+
+
 	/** Connector meta data store. */
 	struct ConnectorData
 	{
@@ -65,7 +96,8 @@ namespace BVS
 			typeIDName{typeIDName},
 			mutex{},
 			lock{},
-			locked{locked}
+			locked{locked},
+			statistics{}
 		{ }
 
 		std::string id; /**< Identifier. */
@@ -77,6 +109,7 @@ namespace BVS
 		std::mutex mutex; /**< Mutex to lock resource. */
 		std::unique_lock<std::mutex> lock; /**< Lock to use with mutex. */
 		bool locked; /**< If connection is locked. */
+		ConnectorStatistics statistics; /**< Traffic and contention statistics. */
 
 		ConnectorData(const ConnectorData&) = delete; /**< -Weffc++ */
 		ConnectorData& operator=(const ConnectorData&) = delete; /**< -Weffc++ */
@@ -93,11 +126,17 @@ namespace BVS
 	 * This is a workaround so that there can exists one map of connector metadata
 	 * for all possible template instatiations of connector that is truly shared
 	 * between all of them.
+	 *
+	 * The map is per thread: it collects the connectors of the module being
+	 * constructed by the calling thread, so modules can be constructed
+	 * concurrently (see BVS.loadThreads).
 	 */
 	struct BVS_PUBLIC ConnectorDataCollector
 	{
-		/** Map of connectors. */
-		static ConnectorMap connectors;
+		/** Map of connectors registered by the calling thread.
+		 * @return Map of connectors.
+		 */
+		static ConnectorMap& connectors();
 	};
 } // namespace BVS
 
@@ -4,7 +4,9 @@
 #include <chrono>
 #include <map>
 #include <string>
+#include <vector>
 
+#include "bvs/arena.h"
 #include "bvs/config.h"
 #include "bvs/traits.h"
 
@@ -13,6 +15,24 @@
 /** BVS namespace, contains all library stuff. */
 namespace BVS
 {
+	/** Context switches of a thread during a module's execution. */
+	struct BVS_PUBLIC ContextSwitches
+	{
+		long voluntary; /**< Voluntary switches, e.g. waiting for a lock or I/O. */
+		long involuntary; /**< Involuntary switches, i.e. preempted by the scheduler. */
+	};
+
+
+
+	/** Heap allocations, counted if built with BVS_ALLOCATION_TRACKING. */
+	struct BVS_PUBLIC Allocations
+	{
+		unsigned long long count; /**< Number of allocations. */
+		unsigned long long bytes; /**< Allocated bytes. */
+	};
+
+
+
 	/** Info meta data stuff. */
 	struct BVS_PUBLIC Info
 	{
@@ -31,13 +51,69 @@ namespace BVS
 		/** Module durations of last round. */
 		std::map<std::string, std::chrono::duration<unsigned int, std::milli>> moduleDurations;
 
+		/** Module cpu (thread) times of last round.
+		 * Compare with moduleDurations: a module with a wall time much larger
+		 * than its cpu time is blocked (e.g. on a connector lock) or
+		 * descheduled instead of computing.
+		 */
+		std::map<std::string, std::chrono::duration<unsigned int, std::milli>> moduleCPUDurations;
+
+		/** Module context switches of last round. */
+		std::map<std::string, ContextSwitches> moduleContextSwitches;
+
+		/** Performance counters (BVS.perfCounters) counted for all modules. */
+		std::vector<std::string> perfCounterEvents;
+
+		/** Module performance counter values of last round, same order as perfCounterEvents. */
+		std::map<std::string, std::vector<unsigned long long>> modulePerfCounters;
+
+		/** Module performance counter totals of all rounds, same order as perfCounterEvents. */
+		std::map<std::string, std::vector<unsigned long long>> modulePerfCounterTotals;
+
 		/** Pool durations of last round. */
 		std::map<std::string, std::chrono::duration<unsigned int, std::milli>> poolDurations;
 
+		/** Pool idle durations of last round.
+		 * Time a pool spent at the barrier (waiting to be woken up or for
+		 * the slowest pool) instead of executing its modules, this includes
+		 * the master's wait for all other pools.
+		 */
+		std::map<std::string, std::chrono::duration<unsigned int, std::milli>> poolIdleDurations;
+
+		/** Pool utilization of last round in percent (busy time / round time). */
+		std::map<std::string, double> poolUtilization;
+
+		/** Utilization of all pools of last round in percent. */
+		double roundUtilization;
+
+		/** Pool imbalance of last round (max/mean pool busy time, 1 is perfectly balanced). */
+		double poolImbalance;
+
+		/** Module heap allocations of last round (BVS.allocationTracking). */
+		std::map<std::string, Allocations> moduleAllocations;
+
+		/** Heap allocations of the framework itself (all pools, without modules) in last round. */
+		Allocations frameworkAllocations;
+
 		/** Calculate frames per second.
 		 * @return FPS as string.
 		 */
 		std::string getFPS() const;
+
+		/** Calculate a module's instructions per cycle over all rounds.
+		 * Requires the 'cycles' and 'instructions' performance counters.
+		 * @param[in] id Module id.
+		 * @return IPC or 0 if not available.
+		 */
+		double getIPC(const std::string& id) const;
+
+		/** Calculate a module's misses per thousand instructions over all rounds.
+		 * Requires the 'instructions' and the given performance counter.
+		 * @param[in] id Module id.
+		 * @param[in] event Miss counter, e.g. 'cache-misses' or 'branch-misses'.
+		 * @return Misses per thousand instructions or 0 if not available.
+		 */
+		double getMissRate(const std::string& id, const std::string& event) const;
 	};
 
 
@@ -47,6 +123,7 @@ namespace BVS
 	{
 		std::string id; /**< Module id. */
 		std::string conf; /**< Module Configuration. */
+		Arena* arena; /**< Arena for temporaries, reset after each execution. */
 	};
 }
 
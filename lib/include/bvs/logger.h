@@ -1,26 +1,47 @@
 #ifndef BVS_LOGGER_H
 #define BVS_LOGGER_H
 
+#include <atomic>
+#include <cstring>
 #include <functional>
 #include <iostream>
 #include <memory>
+#include <sstream>
 #include <string>
 
+#include "bvs/binarylog.h"
 #include "bvs/traits.h"
 
 
 
-/** Macro to use with Logger. */
+/** Highest level that is compiled in, LOG calls above are removed entirely.
+ * Set with the cmake option BVS_LOG_MAX_LEVEL (e.g. 2 strips all DEBUG logs).
+ */
+#ifndef BVS_LOG_MAX_LEVEL
+#define BVS_LOG_MAX_LEVEL 65535
+#endif
+
+/** Macro to use with Logger.
+ * Filtered messages cost one (compile time or atomic) comparison, args are
+ * only evaluated if the message will be logged. Every call site has a static
+ * LogSite, which holds its rate limit and duplicate state and, in binary mode
+ * (see BVS.logFormat), is registered once so only the raw argument values
+ * are written. With duplicate suppression, args are captured as raw values
+ * too and only formatted if the message is not a duplicate.
+ */
 #ifdef BVS_LOG_SYSTEM
 #ifdef __ANDROID_API__
-#define LOG(level, ...) { std::stringstream ss; ss << __VA_ARGS__; std::string out = ss.str(); LOGD(out.c_str());};
+#define LOG(level, ...) { if ((level)<=BVS_LOG_MAX_LEVEL && logger.enabled(level)) { std::stringstream ss; ss << __VA_ARGS__; std::string out = ss.str(); LOGD(out.c_str()); } };
 #else
-#define LOG(level, args) { logger.out(level) << args << std::endl; logger.endl(level); };
+#define LOG(level, args) { if ((level)<=BVS_LOG_MAX_LEVEL && logger.enabled(level)) { \
+	static ::BVS::LogSite bvsLogSite{__FILE__, __LINE__, #args}; \
+	if (logger.admit(bvsLogSite, level)) { \
+		if (logger.capture(level)) { logger.record() << args; logger.commit(bvsLogSite, level); } \
+		else { logger.out(level) << args << std::endl; logger.endl(level, bvsLogSite); } } } };
 #endif
 #else
-//TODO rather inefficient, leave for now
-// nirvana is used so args is evaluated in all cases
-#define LOG(level, args) { std::ostream nirvana(0); nirvana << level << args;};
+// args are still compiled (so they stay valid), but never evaluated
+#define LOG(level, args) { if (false) { std::ostream nirvana(0); nirvana << level << args; } };
 #endif
 
 /** BVS namespace, contains all library stuff. */
@@ -31,6 +52,119 @@ namespace BVS
 
 
 
+	/** Number of distinct recent messages a call site remembers for duplicate suppression. */
+	static const int logSiteDuplicates = 4;
+
+
+
+	/** Static descriptor and state of a LOG call site.
+	 * Written to the binary log once, messages only refer to its id. Also
+	 * keeps the site's rate limit window and its recent messages for
+	 * duplicate suppression (see Logger::Limits).
+	 */
+	struct LogSite
+	{
+		/** Describe call site.
+		 * @param[in] file Source file.
+		 * @param[in] line Source line.
+		 * @param[in] expression LOG arguments as written in the source.
+		 */
+		constexpr LogSite(const char* file, int line, const char* expression)
+			: file{file}, line{line}, expression{expression}, id{0}
+			, window{0}, count{0}, suppressed{0}
+			, busy{false}, hashes{}, repeats{}, reported{} {}
+
+		const char* file; /**< Source file. */
+		int line; /**< Source line. */
+		const char* expression; /**< LOG arguments as written in the source. */
+		std::atomic<uint32_t> id; /**< Id in the binary log (0 until registered). */
+
+		std::atomic<int64_t> window; /**< Second of the current rate limit window. */
+		std::atomic<uint32_t> count; /**< Messages in the current window. */
+		std::atomic<uint32_t> suppressed; /**< Messages dropped by the rate limit, not yet reported. */
+
+		std::atomic<bool> busy; /**< Spin lock for the duplicate state. */
+		uint64_t hashes[logSiteDuplicates]; /**< Hashes of recent messages. */
+		uint32_t repeats[logSiteDuplicates]; /**< Suppressed repeats of recent messages. */
+		int64_t reported[logSiteDuplicates]; /**< Time recent messages were last written in ns. */
+
+		LogSite(const LogSite&) = delete; /**< -Weffc++ */
+		LogSite& operator=(const LogSite&) = delete; /**< -Weffc++ */
+	};
+
+
+
+	/** Collects the raw arguments of a binary log message.
+	 * Every argument is stored as a tag and its raw value (see
+	 * bvs/binarylog.h), types without an overload are formatted to a string.
+	 * Stream manipulators (e.g. std::fixed, std::setprecision()) are ignored,
+	 * so values needing a format have to be formatted before logging them.
+	 */
+	class LogRecord
+	{
+		public:
+			/** Construct empty record. */
+			LogRecord() : arguments{} {}
+
+			/** Clear record for the next message.
+			 * @return Reference to object.
+			 */
+			LogRecord& clear() { arguments.clear(); return *this; }
+
+			LogRecord& operator<<(bool value) { return put(binaryLogBool, static_cast<uint8_t>(value)); }
+			LogRecord& operator<<(char value) { return put(binaryLogChar, value); }
+			LogRecord& operator<<(signed char value) { return put(binaryLogChar, static_cast<char>(value)); }
+			LogRecord& operator<<(unsigned char value) { return put(binaryLogChar, static_cast<char>(value)); }
+			LogRecord& operator<<(short value) { return put(binaryLogInt, static_cast<int64_t>(value)); }
+			LogRecord& operator<<(int value) { return put(binaryLogInt, static_cast<int64_t>(value)); }
+			LogRecord& operator<<(long value) { return put(binaryLogInt, static_cast<int64_t>(value)); }
+			LogRecord& operator<<(long long value) { return put(binaryLogInt, static_cast<int64_t>(value)); }
+			LogRecord& operator<<(unsigned short value) { return put(binaryLogUnsigned, static_cast<uint64_t>(value)); }
+			LogRecord& operator<<(unsigned int value) { return put(binaryLogUnsigned, static_cast<uint64_t>(value)); }
+			LogRecord& operator<<(unsigned long value) { return put(binaryLogUnsigned, static_cast<uint64_t>(value)); }
+			LogRecord& operator<<(unsigned long long value) { return put(binaryLogUnsigned, static_cast<uint64_t>(value)); }
+			LogRecord& operator<<(float value) { return put(binaryLogDouble, static_cast<double>(value)); }
+			LogRecord& operator<<(double value) { return put(binaryLogDouble, value); }
+			LogRecord& operator<<(long double value) { return put(binaryLogDouble, static_cast<double>(value)); }
+			LogRecord& operator<<(const void* value) { return put(binaryLogPointer, static_cast<uint64_t>(reinterpret_cast<uintptr_t>(value))); }
+			LogRecord& operator<<(const char* value) { return string(value ? value : "(null)", value ? strlen(value) : 6); }
+			LogRecord& operator<<(const std::string& value) { return string(value.data(), value.size()); }
+			LogRecord& operator<<(std::ostream& (*)(std::ostream&)) { return *this; }
+			LogRecord& operator<<(std::ios_base& (*)(std::ios_base&)) { return *this; }
+
+			/** Fallback for other types, formats the value to a string (nothing is stored for manipulators). */
+			template<typename T> LogRecord& operator<<(const T& value)
+			{
+				std::ostringstream stream;
+				stream.setf(stream.boolalpha);
+				stream << value;
+				if (stream.tellp()==0) return *this;
+				return *this << stream.str();
+			}
+
+			std::string arguments; /**< Tagged argument values. */
+
+		private:
+			/** Append a tagged value. */
+			template<typename T> LogRecord& put(uint8_t tag, T value)
+			{
+				arguments.push_back(static_cast<char>(tag));
+				arguments.append(reinterpret_cast<const char*>(&value), sizeof(value));
+				return *this;
+			}
+
+			/** Append a tagged string. */
+			LogRecord& string(const char* data, size_t size)
+			{
+				uint32_t length = size;
+				put(binaryLogString, length);
+				arguments.append(data, size);
+				return *this;
+			}
+	};
+
+
+
 	/** Provides access to the LogSystem.
 	 * To use this system, just create a Logger object with your desired
 	 * settings. The LogSystem backend will be initialized automatically.
@@ -44,6 +178,24 @@ namespace BVS
 			/** Available logging targets. */
 			enum LogTarget { OFF, TO_CLI, TO_FILE, TO_CLI_AND_FILE};
 
+			/** Per logger limits for message storms, set in the [Logger] section:
+			 * @code
+			 * [Logger]
+			 * Control.rateLimit = 10 # at most 10 messages per second and call site
+			 * Control.suppressDuplicates = ON # write identical messages once per second with a repeat count
+			 * @endcode
+			 * Messages to level 0 are never limited. Duplicates are detected on the
+			 * raw argument values before formatting (like the binary log), so stream
+			 * manipulators are ignored for loggers that suppress duplicates.
+			 */
+			struct Limits
+			{
+				Limits() : rateLimit{bvs_log_rate_limit}, suppressDuplicates{bvs_log_suppress_duplicates} {}
+
+				std::atomic<unsigned int> rateLimit; /**< Messages per second and call site, 0 disables it. */
+				std::atomic<bool> suppressDuplicates; /**< Suppress repeated identical messages. */
+			};
+
 			/** Construct logger metadata.
 			 * Your logging instances' name will be prepended to your output.
 			 * Since this output will be aligned, please dont use too long names.
@@ -59,28 +211,101 @@ namespace BVS
 			 */
 			Logger(const std::string& name, unsigned short verbosity = 3, LogTarget target = TO_CLI_AND_FILE, std::function<void()> errorHandler = [](){ exit(1); });
 
+			/** Write held back duplicates of this logger's messages. */
+			~Logger();
+
 			/** Log to logging system.
 			 * @param[in] level The messages' desired verbosity level.
 			 * @return A stream reference your output will be send to.
 			 */
 			std::ostream& out(const int level);
 
+			/** Check whether a message would be logged.
+			 * Compares against this logger's and the system's verbosity, used by
+			 * LOG before formatting anything.
+			 * @param[in] level The messages' desired verbosity level.
+			 * @return True if messages of this level are logged.
+			 */
+			bool enabled(const int level) const
+			{
+				return level <= verbosity->load(std::memory_order_relaxed)
+					&& level <= systemVerbosity.load(std::memory_order_relaxed);
+			}
+
+			/** Check a call site's rate limit (before formatting).
+			 * @param[in,out] site Call site of the message.
+			 * @param[in] level The messages' desired verbosity level.
+			 * @return True if the message may be logged.
+			 */
+			bool admit(LogSite& site, const int level)
+			{
+				return level==0 || !limits->rateLimit.load(std::memory_order_relaxed) || admitRate(site);
+			}
+
+			/** Check whether LOG captures raw argument values instead of formatting.
+			 * True in binary mode and for loggers that suppress duplicates.
+			 * @param[in] level The messages' desired verbosity level.
+			 * @return True if the message is written with record() and commit().
+			 */
+			bool capture(const int level) const
+			{
+				return binaryFormat.load(std::memory_order_relaxed)
+					|| (level>0 && limits->suppressDuplicates.load(std::memory_order_relaxed));
+			}
+
+			/** Start a captured message.
+			 * @return The calling thread's (cleared) record.
+			 */
+			LogRecord& record();
+
+			/** Write a captured message, must be called after using record.
+			 * Writes to the binary log, or checks for duplicates and formats
+			 * the text only if the message is written.
+			 * @param[in] site Call site of the message.
+			 * @param[in] level The messages' desired verbosity level.
+			 */
+			void commit(LogSite& site, const int level);
+
 			/* Ends a log line and releases the logSystem mutex, must be called after using out.
 			 * @param[in] level The messages' desired verbosity level.
 			*/
 			void endl(const int level);
 
+			/** Ends a log line of a LOG call site, applies duplicate suppression.
+			 * @param[in] level The messages' desired verbosity level.
+			 * @param[in,out] site Call site of the message.
+			 */
+			void endl(const int level, LogSite& site);
+
 			/** This logger instance's name.
 			 * Const to prevent changes later on, which would
 			 * mess with the name padding in the logging system.
 			 * */
 			const std::string name;
 
-			std::shared_ptr<unsigned short> verbosity; /**< This logger's verbosity level. */
+			std::shared_ptr<std::atomic<unsigned short>> verbosity; /**< This logger's verbosity level. */
 			LogTarget target; /**< This logger's output target. */
 			std::function<void()> errorHandler; /**< This logger's error Handler. */
+			std::shared_ptr<Limits> limits; /**< This logger's rate limit and duplicate suppression. */
+
+			std::atomic<uint32_t> binaryId; /**< This logger's id in the binary log (0 until registered). */
+
+			/** The overall system verbosity level, maintained by the LogSystem. */
+			static std::atomic<unsigned short> systemVerbosity;
+
+			/** Whether LOG writes to the binary log, maintained by the LogSystem. */
+			static std::atomic<bool> binaryFormat;
+
+			/** The current round, maintained by Control, tags JSON log records. */
+			static std::atomic<unsigned long long> round;
 
 		private:
+			/** Count a message in its call site's rate limit window.
+			 * @param[in,out] site Call site of the message.
+			 * @return True if the message is within the rate limit.
+			 */
+			bool admitRate(LogSite& site);
+
 #ifdef BVS_LOG_SYSTEM
 			std::shared_ptr<LogSystem> logSystem; /**< Pointer to the logging backend. */
 #endif
@@ -0,0 +1,159 @@
+#ifndef BVS_STATSPAGE_H
+#define BVS_STATSPAGE_H
+
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Statistics page layout version, increased on incompatible changes. */
+	static const uint32_t statsPageVersion = 2;
+
+	/** Maximum name length (including '\0') in the statistics page. */
+	static const uint32_t statsPageNameLength = 64;
+
+	/** Number of duration histogram buckets (the last one is +Inf). */
+	static const uint32_t statsPageBuckets = 12;
+
+	/** Upper bounds of the duration histogram buckets in us. */
+	static const uint64_t statsPageBucketBounds[statsPageBuckets-1] =
+		{ 500, 1000, 2500, 5000, 10000, 25000, 50000, 100000, 250000, 500000, 1000000 };
+
+
+
+	/** Histogram bucket of a duration.
+	 * @param[in] duration Duration in us.
+	 * @return Bucket index.
+	 */
+	inline uint32_t statsPageBucket(uint64_t duration)
+	{
+		uint32_t bucket = 0;
+		while (bucket<statsPageBuckets-1 && duration>statsPageBucketBounds[bucket]) bucket++;
+		return bucket;
+	}
+
+
+
+	/** Statistics page header.
+	 * The statistics page is a memory-mapped file ('/dev/shm/bvs-<pid>')
+	 * the master updates after every round (enable with BVS.statsPage).
+	 * Layout: StatsPageHeader, moduleCapacity*StatsPageModule,
+	 * poolCapacity*StatsPagePool, connectorCapacity*StatsPageConnector.
+	 *
+	 * Entries keep their slot for the lifetime of the process, entries of
+	 * unloaded modules stay (inactive), so totals never go backwards. Totals
+	 * (counters, sums and histograms) accumulate over all published rounds.
+	 *
+	 * It is updated using a seqlock: the sequence is odd while the master
+	 * writes, so readers copy the page and retry if the sequence was odd or
+	 * changed meanwhile, see readStatsPage().
+	 */
+	struct StatsPageHeader
+	{
+		char magic[8]; /**< "BVSSTAT\0". */
+		uint32_t version; /**< Layout version, see statsPageVersion. */
+		uint32_t size; /**< Size of the whole page. */
+		uint32_t moduleCapacity; /**< Number of module entries. */
+		uint32_t poolCapacity; /**< Number of pool entries. */
+		uint32_t connectorCapacity; /**< Number of connector entries. */
+		uint32_t reserved; /**< Padding. */
+		std::atomic<uint64_t> sequence; /**< Seqlock sequence, odd while writing. */
+		uint64_t pid; /**< Process id. */
+		uint64_t round; /**< Last finished round. */
+		uint64_t timestamp; /**< System clock at the end of the round in us. */
+		uint64_t roundDuration; /**< Duration of last round in us. */
+		double roundUtilization; /**< Utilization of all pools in percent. */
+		double poolImbalance; /**< Slowest pool busy time / mean pool busy time. */
+		uint32_t moduleCount; /**< Used module entries. */
+		uint32_t poolCount; /**< Used pool entries. */
+		uint32_t connectorCount; /**< Used connector entries. */
+		uint32_t reserved2; /**< Padding. */
+		uint64_t rounds; /**< Number of published rounds. */
+		uint64_t roundDurationSum; /**< Sum of round durations in us. */
+		uint64_t roundHistogram[statsPageBuckets]; /**< Round duration histogram (not cumulative). */
+	};
+
+
+
+	/** Statistics page module entry. */
+	struct StatsPageModule
+	{
+		char id[statsPageNameLength]; /**< Module id. */
+		char pool[statsPageNameLength]; /**< Pool executing the module. */
+		uint64_t duration; /**< Wall time of last execution in us. */
+		uint64_t cpuDuration; /**< Cpu time of last execution in us. */
+		int32_t status; /**< Last module status, see Status. */
+		uint32_t active; /**< 1 if module is loaded. */
+		uint64_t voluntarySwitches; /**< Voluntary context switches of last execution. */
+		uint64_t involuntarySwitches; /**< Involuntary context switches of last execution. */
+		uint64_t executions; /**< Total number of execute() calls (skipped rounds do not count). */
+		uint64_t durationSum; /**< Total wall time of all executions in us. */
+		uint64_t cpuDurationSum; /**< Total cpu time of all executions in us. */
+		uint64_t noinputCount; /**< Executions ending with Status::NOINPUT. */
+		uint64_t failCount; /**< Executions ending with Status::FAIL. */
+		uint64_t histogram[statsPageBuckets]; /**< Wall time histogram of all executions (not cumulative). */
+	};
+
+
+
+	/** Statistics page pool entry. */
+	struct StatsPagePool
+	{
+		char name[statsPageNameLength]; /**< Pool name. */
+		uint64_t busy; /**< Time spent executing modules in last round in us. */
+		uint64_t idle; /**< Time spent waiting in last round in us. */
+		double utilization; /**< Busy time / round duration in percent. */
+		uint64_t busySum; /**< Total busy time in us. */
+		uint64_t idleSum; /**< Total idle time in us. */
+		uint32_t active; /**< 1 if pool exists. */
+		uint32_t reserved; /**< Padding. */
+	};
+
+
+
+	/** Statistics page connector entry. */
+	struct StatsPageConnector
+	{
+		char name[statsPageNameLength]; /**< Connector name ('module.connector'). */
+		uint32_t output; /**< 1 for outputs, 0 for inputs. */
+		uint32_t active; /**< 1 if module is loaded. */
+		uint64_t sends; /**< Total sends. */
+		uint64_t receives; /**< Total receives. */
+		uint64_t bytes; /**< Total bytes transferred. */
+		uint64_t contended; /**< Total contended lock acquisitions. */
+		uint64_t waitNanoseconds; /**< Total time waited for the lock. */
+	};
+
+
+
+	/** Read a consistent snapshot of a statistics page.
+	 * @param[in] page Mapped statistics page.
+	 * @param[out] buffer Buffer to copy the page to (at least page->size bytes).
+	 * @param[in] size Size of buffer.
+	 * @param[in] retries Number of attempts while the page is being written.
+	 * @return True if a consistent snapshot was copied.
+	 */
+	inline bool readStatsPage(const StatsPageHeader* page, void* buffer, size_t size, int retries = 1000)
+	{
+		if (page->version!=statsPageVersion || page->size>size) return false;
+
+		for (int i=0; i<retries; i++) {
+			uint64_t before = page->sequence.load(std::memory_order_acquire);
+			if (before&1) continue;
+			memcpy(buffer, static_cast<const void*>(page), page->size);
+			std::atomic_thread_fence(std::memory_order_acquire);
+			if (page->sequence.load(std::memory_order_relaxed)==before) return true;
+		}
+
+		return false;
+	}
+} // namespace BVS
+
+
+
+#endif //BVS_STATSPAGE_H
+
@@ -7,6 +7,7 @@
 #define LOG_TAG "BvsAndroidLog/"
 #define LOGD(...) ((void)__android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__))
 #endif
+#include <cstddef>
 #include <string>
 #include <vector>
 
@@ -66,6 +67,29 @@ static const bool bvs_log_to_console = true;
  */
 static const std::string bvs_log_to_logfile = {};
 
+/** Size (in MB) of log file segments.
+ * The log file is written through memory-mapped segments of this size, a
+ * full segment is renamed to '$NAME.1' (older ones to '$NAME.2' etc.) and a
+ * new one is started. 0 lets the log file grow without rotation.
+ *
+ * Possible Values: 0, 1, 2, ...
+ */
+static const size_t bvs_log_file_max_size = 0;
+
+/** Number of log file segments to keep (including the active one).
+ *
+ * Possible Values: 1, 2, ...
+ */
+static const unsigned int bvs_log_file_segments = 4;
+
+/** Whether to write a JSON log (one object per message) or not.
+ * If the name is prepended with a '+' sign, instead of overwriting, append
+ * to given file name. Rotated like the log file.
+ *
+ * Possible Values: "" (NO JSON log), "$NAME", "+$NAME"
+ */
+static const std::string bvs_log_json = {};
+
 /** Whether to use colors in the system log.
  * Currently only Linux Console is supported.
  *
@@ -81,12 +105,89 @@ static const bool bvs_log_colors = true;
  */
 static const unsigned int bvs_log_client_default_verbosity = 3;
 
+/** Log rate limit (messages per second and call site) of log clients.
+ * Set per logger in the [Logger] section ('$logger.rateLimit').
+ *
+ * Possible Values: 0 (off), 1, ...
+ */
+static const unsigned int bvs_log_rate_limit = 0;
+
+/** Whether log clients suppress repeated identical messages.
+ * Set per logger in the [Logger] section ('$logger.suppressDuplicates').
+ * Repeats are written once per bvs_log_duplicate_interval with a count.
+ *
+ * Possible Values: true, false
+ */
+static const bool bvs_log_suppress_duplicates = false;
+
+/** Interval (in ms) in which suppressed duplicate messages are written.
+ *
+ * Possible Values: 1, 2, ...
+ */
+static const unsigned int bvs_log_duplicate_interval = 1000;
+
+/** Whether to log asynchronously.
+ * Messages are queued in per thread ring buffers and written to console and
+ * file by a writer thread, so logging threads never wait for I/O.
+ *
+ * Possible Values: true, false
+ */
+static const bool bvs_log_async = false;
+
+/** Size (in bytes) of each thread's log ring buffer (asynchronous logging).
+ *
+ * Possible Values: 256, 512, ... (rounded up to a power of two)
+ */
+static const size_t bvs_log_buffer_size = 65536;
+
+/** What to do if a thread's log ring buffer is full (asynchronous logging).
+ * BLOCK waits for the writer thread, DROP discards the message, COUNT
+ * discards the message and the writer reports the number of lost messages.
+ *
+ * Possible Values: BLOCK, DROP, COUNT
+ */
+static const std::string bvs_log_overflow = "COUNT";
+
+/** Interval (in ms) in which the log writer thread drains the ring buffers.
+ * The writer is also woken up once a ring buffer is half full.
+ *
+ * Possible Values: 1, 2, ...
+ */
+static const unsigned int bvs_log_writer_interval = 10;
+
+/** Log format.
+ * BINARY writes a timestamp, a call site id and the raw argument values of
+ * every message to a memory-mapped file (see bvs_log_binary_file), decode it
+ * with 'bvs-logdecode'.
+ *
+ * Possible Values: TEXT, BINARY
+ */
+static const std::string bvs_log_format = "TEXT";
+
+/** File the binary log is written to.
+ *
+ * Possible Values: "$NAME"
+ */
+static const std::string bvs_log_binary_file = "bvs-log.bin";
+
+/** Size (in MB) of the binary log, further messages are dropped.
+ *
+ * Possible Values: 1, 2, ...
+ */
+static const size_t bvs_log_binary_size = 64;
+
 /** Whether the system shows statistics after every round.
  *
  * Possible Values: true, false
  */
 static const bool bvs_log_statistics = false;
 
+/** Whether the system shows connection statistics on shutdown.
+ *
+ * Possible Values: true, false
+ */
+static const bool bvs_connector_statistics = false;
+
 /** Whether there should be a minimal round time (in ms).
  * Useful to restrict the system to a maximal frame rate. (fps~1/round_time)
  *
@@ -94,6 +195,123 @@ static const bool bvs_log_statistics = false;
  */
 static const bool bvs_minimal_round_time = 0;
 
+/** Maximum number of started modules.
+ * The hot state of all modules (flags, statuses, timings) is kept in one
+ * preallocated table of this size.
+ *
+ * Possible Values: 1, 2, ...
+ */
+static const unsigned int bvs_module_slots = 256;
+
+/** Number of recent rounds kept by the flight recorder.
+ * The flight recorder keeps module timings, statuses and output sequence
+ * numbers of the most recent rounds, so they can be dumped on a crash, on
+ * request or if a round takes too long (see bvs_stall_threshold).
+ *
+ * Possible Values: 0 (off), 1, ...
+ */
+static const unsigned int bvs_flight_recorder_rounds = 64;
+
+/** Number of module slots of the flight recorder (twice as many outputs).
+ *
+ * Possible Values: 0, 1, ...
+ */
+static const unsigned int bvs_flight_recorder_slots = 256;
+
+/** File the flight recorder is dumped to, '.json' or '.bin' is appended
+ * according to the dump format.
+ *
+ * Possible Values: "$NAME"
+ */
+static const std::string bvs_flight_recorder_file = "bvs-flightrecorder";
+
+/** Round duration (in ms) after which the flight recorder is dumped.
+ *
+ * Possible Values: 0 (off), 1, ...
+ */
+static const unsigned int bvs_stall_threshold = 0;
+
+/** Minimal time (in ms) between two flight recorder dumps after slow rounds.
+ *
+ * Possible Values: 0, 1, ...
+ */
+static const unsigned int bvs_stall_dump_interval = 10000;
+
+/** Publish statistics to the statistics page '/dev/shm/bvs-<pid>'.
+ * See 'bvs/statspage.h' for the layout, 'bvs-top' displays it.
+ *
+ * Possible Values: true, false
+ */
+static const bool bvs_stats_page = false;
+
+/** Number of module and pool entries (4x connectors) of the statistics page.
+ *
+ * Possible Values: 1, 2, ...
+ */
+static const unsigned int bvs_stats_page_slots = 256;
+
+/** Interval (in ms) in which the watchdog checks module time budgets.
+ * Module budgets are set by '<module>.budgetMs', a stall is detected after at
+ * most budget + interval.
+ *
+ * Possible Values: 1, 2, ...
+ */
+static const unsigned int bvs_watchdog_interval = 10;
+
+/** Budgets after which a module execution is considered hung.
+ * Budget actions only apply once execute() returns, so the watchdog calls the
+ * shutdown handler (from its own thread) if an execution runs longer than this
+ * many times its budget.
+ *
+ * Possible Values: 0 (off), 1, ...
+ */
+static const unsigned int bvs_watchdog_shutdown_factor = 10;
+
+/** Whether to watch the loaded config files and apply changes while running.
+ * Changes are applied between rounds: config handles are refreshed,
+ * subscribers notified and logger levels updated (Linux only).
+ *
+ * Possible Values: true, false
+ */
+static const bool bvs_config_watch = false;
+
+/** Number of threads opening module libraries and constructing modules.
+ * Module constructors run concurrently if greater than 1, so they must not
+ * share unsynchronized state.
+ *
+ * Possible Values: 1, 2, ...
+ */
+static const unsigned int bvs_load_threads = 1;
+
+/** Count heap allocations per module and of the framework itself each round.
+ * Counts are shown by logStatistics. Requires a library built with
+ * BVS_ALLOCATION_TRACKING.
+ *
+ * Possible Values: true, false
+ */
+static const bool bvs_allocation_tracking = false;
+
+/** Abort if the framework allocates in a steady-state round.
+ * A round is steady once bvs_allocation_warmup rounds passed since startup,
+ * the last module start/stop or the last config reload.
+ *
+ * Possible Values: true, false
+ */
+static const bool bvs_allocation_strict = false;
+
+/** Number of rounds before allocation tracking considers rounds steady.
+ *
+ * Possible Values: 0, 1, 2, ...
+ */
+static const unsigned int bvs_allocation_warmup = 3;
+
+/** Size (in KB) of the first chunk of each module's arena (ModuleInfo::arena).
+ * Chunks are only allocated once a module uses its arena.
+ *
+ * Possible Values: 1, 2, ...
+ */
+static const size_t bvs_arena_size = 64;
+
 /** Select parallelism level.
  *
  * Possible Values: NONE, THREADS, FORCE, ANY
@@ -16,6 +16,12 @@ namespace BVS
 	 * @return 'errno' from the prctl(...) syscall.
 	 */
 	BVS_PUBLIC int nameThisThread(std::string threadName);
+
+	/** Name of the calling thread as set by nameThisThread().
+	 * Available independent of BVS_THREAD_NAMES.
+	 * @return Thread name (empty if never set).
+	 */
+	BVS_PUBLIC const std::string& getThreadName();
 } // namespace BVS
 
 
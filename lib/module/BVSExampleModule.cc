@@ -16,6 +16,7 @@ BVSExampleModule::BVSExampleModule(BVS::ModuleInfo info, const BVS::Info& bvs)
 
 	// CONFIGURATION RETRIEVAL
 	//, yourSwitch(bvs.config.getValue<bool>(info.conf + ".yourSwitch", false))
+	//, yourThreshold(bvs.config.handle<int>(info.conf + ".yourThreshold", 5)) // use yourThreshold.get() in execute()
 {
 
 }
@@ -48,6 +49,9 @@ BVS::Status BVSExampleModule::execute()
 	//std::string message = "received " + std::to_string(incoming);
 	//output.send(message);
 
+	// TEMPORARIES: use your arena, it is reset after execute() returns
+	//std::vector<int, BVS::ArenaAllocator<int>> scratch{*info.arena};
+
 	return BVS::Status::OK;
 }
 
@@ -0,0 +1,131 @@
+#include <cstdlib>
+#include <new>
+
+#include "allocationtracker.h"
+
+using BVS::AllocationTracker;
+using BVS::Allocations;
+
+
+
+#ifdef BVS_ALLOCATION_TRACKING
+namespace
+{
+	// plain (zero initialized) thread locals, so counting never allocates itself
+	thread_local unsigned long long threadCount = 0; /**< Allocations of the calling thread. */
+	thread_local unsigned long long threadBytes = 0; /**< Allocated bytes of the calling thread. */
+
+	/** Count and perform an allocation. */
+	void* allocate(std::size_t size)
+	{
+		threadCount++;
+		threadBytes += size;
+		return std::malloc(size ? size : 1);
+	}
+}
+
+
+
+BVS_PUBLIC void* operator new(std::size_t size)
+{
+	void* pointer = allocate(size);
+	if (!pointer) throw std::bad_alloc{};
+	return pointer;
+}
+
+
+
+BVS_PUBLIC void* operator new[](std::size_t size)
+{
+	void* pointer = allocate(size);
+	if (!pointer) throw std::bad_alloc{};
+	return pointer;
+}
+
+
+
+BVS_PUBLIC void* operator new(std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+
+
+BVS_PUBLIC void* operator new[](std::size_t size, const std::nothrow_t&) noexcept
+{
+	return allocate(size);
+}
+
+
+
+BVS_PUBLIC void operator delete(void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+
+
+BVS_PUBLIC void operator delete[](void* pointer) noexcept
+{
+	std::free(pointer);
+}
+
+
+
+BVS_PUBLIC void operator delete(void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+
+
+BVS_PUBLIC void operator delete[](void* pointer, std::size_t) noexcept
+{
+	std::free(pointer);
+}
+
+
+
+BVS_PUBLIC void operator delete(void* pointer, const std::nothrow_t&) noexcept
+{
+	std::free(pointer);
+}
+
+
+
+BVS_PUBLIC void operator delete[](void* pointer, const std::nothrow_t&) noexcept
+{
+	std::free(pointer);
+}
+#endif //BVS_ALLOCATION_TRACKING
+
+
+
+bool AllocationTracker::available()
+{
+#ifdef BVS_ALLOCATION_TRACKING
+	return true;
+#else
+	return false;
+#endif //BVS_ALLOCATION_TRACKING
+}
+
+
+
+Allocations AllocationTracker::thread()
+{
+#ifdef BVS_ALLOCATION_TRACKING
+	return {threadCount, threadBytes};
+#else
+	return {0, 0};
+#endif //BVS_ALLOCATION_TRACKING
+}
+
+
+
+Allocations AllocationTracker::since(const Allocations& start)
+{
+	Allocations now = thread();
+	return {now.count - start.count, now.bytes - start.bytes};
+}
+
@@ -0,0 +1,49 @@
+#ifndef BVS_ALLOCATIONTRACKER_H
+#define BVS_ALLOCATIONTRACKER_H
+
+#include "bvs/info.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Counts heap allocations of the calling thread.
+	 * If built with BVS_ALLOCATION_TRACKING, the library replaces the global
+	 * operator new/delete (for the whole process, including all modules) and
+	 * counts every allocation in per thread counters. Read the counters
+	 * before and after a piece of work to get its allocations:
+	 * @code
+	 * Allocations before = AllocationTracker::thread();
+	 * // work
+	 * Allocations work = AllocationTracker::since(before);
+	 * @endcode
+	 *
+	 * Allocations using malloc directly are not counted. Without
+	 * BVS_ALLOCATION_TRACKING all counters stay zero.
+	 */
+	class AllocationTracker
+	{
+		public:
+			/** Check if allocation tracking was built in.
+			 * @return True if allocations are counted.
+			 */
+			static bool available();
+
+			/** Get allocation counters of the calling thread.
+			 * @return Allocations since the thread started.
+			 */
+			static Allocations thread();
+
+			/** Get allocations of the calling thread since an earlier reading.
+			 * @param[in] start Earlier result of thread().
+			 * @return Allocations since start.
+			 */
+			static Allocations since(const Allocations& start);
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_ALLOCATIONTRACKER_H
+
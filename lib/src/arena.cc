@@ -0,0 +1,96 @@
+#include <algorithm>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+#include "bvs/arena.h"
+
+using BVS::Arena;
+
+
+
+Arena::Arena(size_t chunkSize)
+	: chunkSize{std::max<size_t>(chunkSize, 64)},
+	chunks{nullptr},
+	position{nullptr},
+	end{nullptr},
+	allocated{0},
+	last{0},
+	highWater{0},
+	total{0}
+{ }
+
+
+
+Arena::~Arena()
+{
+	release();
+}
+
+
+
+void* Arena::allocate(size_t size, size_t alignment)
+{
+	uintptr_t address = (reinterpret_cast<uintptr_t>(position) + alignment-1) & ~(alignment-1);
+	if (!chunks || address+size > reinterpret_cast<uintptr_t>(end)) {
+		// at least double, so a growing round needs few chunks
+		addChunk(std::max(std::max(chunkSize, 2*total), size+alignment));
+		address = (reinterpret_cast<uintptr_t>(position) + alignment-1) & ~(alignment-1);
+	}
+
+	position = reinterpret_cast<char*>(address + size);
+	allocated += size;
+
+	return reinterpret_cast<void*>(address);
+}
+
+
+
+void Arena::reset()
+{
+	last = allocated;
+	highWater = std::max(highWater, allocated);
+	allocated = 0;
+	if (!chunks) return;
+
+	// merge chunks, the next round then fits into one
+	if (chunks->next) {
+		size_t size = total;
+		release();
+		addChunk(size);
+		return;
+	}
+
+	position = reinterpret_cast<char*>(chunks+1);
+}
+
+
+
+void Arena::addChunk(size_t size)
+{
+	Chunk* chunk = static_cast<Chunk*>(std::malloc(sizeof(Chunk) + size));
+	if (!chunk) throw std::bad_alloc{};
+
+	chunk->next = chunks;
+	chunk->size = size;
+	chunks = chunk;
+	position = reinterpret_cast<char*>(chunk+1);
+	end = position + size;
+	total += size;
+}
+
+
+
+void Arena::release()
+{
+	while (chunks) {
+		Chunk* next = chunks->next;
+		std::free(chunks);
+		chunks = next;
+	}
+
+	position = nullptr;
+	end = nullptr;
+	total = 0;
+}
+
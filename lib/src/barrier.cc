@@ -56,6 +56,9 @@ Barrier& Barrier::enqueue(std::unique_lock<std::mutex>& lock, std::function<bool
 
 Barrier& Barrier::notify()
 {
+	// a party between checking its predicate and waiting holds the mutex,
+	// passing through it makes sure no party misses the notification
+	{ std::lock_guard<std::mutex> lock{mutex}; }
 	cv.notify_all();
 
 	return *this;
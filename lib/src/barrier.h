@@ -70,6 +70,8 @@ namespace BVS
 
 			/** Notify all pool parties.
 			 * This is useful when parties are using self-determined predicates.
+			 * Change the state checked by the predicates before notifying, the
+			 * notification cannot get lost then.
 			 * @return Reference to object.
 			 */
 			Barrier& notify();
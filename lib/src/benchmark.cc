@@ -0,0 +1,94 @@
+#include <iomanip>
+#include <sstream>
+
+#include "bvs/benchmark.h"
+
+using BVS::BenchmarkSummary;
+using BVS::DurationSummary;
+
+
+
+namespace
+{
+	/** Write a duration summary as JSON object. */
+	void appendJSON(std::ostream& out, const DurationSummary& d)
+	{
+		out << "{\"mean_us\":" << d.mean << ",\"p50_us\":" << d.p50 << ",\"p90_us\":" << d.p90
+			<< ",\"p99_us\":" << d.p99 << ",\"max_us\":" << d.max << "}";
+	}
+
+	/** Write a string as quoted and escaped JSON string (pool and module ids are free text). */
+	void appendJSONString(std::ostream& out, const std::string& s)
+	{
+		static const char hex[] = "0123456789abcdef";
+		out << '"';
+		for (char c: s) {
+			if (c=='"' || c=='\\') out << '\\' << c;
+			else if (c=='\n') out << "\\n";
+			else if (c=='\t') out << "\\t";
+			else if (static_cast<unsigned char>(c)<0x20) out << "\\u00" << hex[c>>4] << hex[c&0xf];
+			else out << c;
+		}
+		out << '"';
+	}
+}
+
+
+
+std::string BenchmarkSummary::text() const
+{
+	std::stringstream out;
+	out << std::fixed << std::setprecision(1);
+	out << "Benchmark: " << rounds << " rounds (" << warmupRounds << " warmup) in " << std::setprecision(3) << seconds
+		<< "s, " << std::setprecision(1) << roundsPerSecond << " rounds/s, peak RSS " << peakRSS << " KB" << std::endl;
+	out << "  round          mean " << roundTime.mean << "us  p50 " << roundTime.p50 << "us  p90 " << roundTime.p90
+		<< "us  p99 " << roundTime.p99 << "us  max " << roundTime.max << "us" << std::endl;
+	for (auto& pool: pools) {
+		const DurationSummary& idle = poolIdle.at(pool.first);
+		out << "  [P]" << std::left << std::setw(12) << pool.first << std::right << "mean " << pool.second.mean
+			<< "us  p99 " << pool.second.p99 << "us  idle mean " << idle.mean << "us  idle p99 " << idle.p99 << "us" << std::endl;
+	}
+	for (auto& module: modules)
+		out << "  [M]" << std::left << std::setw(12) << module.first << std::right << "mean " << module.second.mean
+			<< "us  p99 " << module.second.p99 << "us" << std::endl;
+
+	return out.str();
+}
+
+
+
+std::string BenchmarkSummary::json() const
+{
+	std::stringstream out;
+	out << std::fixed << std::setprecision(3);
+	out << "{\"warmup_rounds\":" << warmupRounds << ",\"rounds\":" << rounds << ",\"seconds\":" << seconds
+		<< ",\"rounds_per_second\":" << roundsPerSecond << ",\"peak_rss_kb\":" << peakRSS << ",\"round\":";
+	appendJSON(out, roundTime);
+
+	out << ",\"pools\":{";
+	bool first = true;
+	for (auto& pool: pools) {
+		out << (first ? "" : ",");
+		appendJSONString(out, pool.first);
+		out << ":{\"busy\":";
+		appendJSON(out, pool.second);
+		out << ",\"idle\":";
+		appendJSON(out, poolIdle.at(pool.first));
+		out << "}";
+		first = false;
+	}
+
+	out << "},\"modules\":{";
+	first = true;
+	for (auto& module: modules) {
+		out << (first ? "" : ",");
+		appendJSONString(out, module.first);
+		out << ":";
+		appendJSON(out, module.second);
+		first = false;
+	}
+	out << "}}" << std::endl;
+
+	return out.str();
+}
+
@@ -0,0 +1,110 @@
+#include <algorithm>
+#include <cmath>
+
+#include <sys/resource.h>
+
+#include "benchmarkrecorder.h"
+
+using BVS::BenchmarkRecorder;
+using BVS::BenchmarkSummary;
+using BVS::DurationSummary;
+
+
+
+BenchmarkRecorder::BenchmarkRecorder(unsigned long long warmupRounds, unsigned long long rounds, const PoolPlan& poolPlan)
+	: warmupRounds{warmupRounds},
+	rounds{rounds},
+	recorded{0},
+	start{std::chrono::steady_clock::now()},
+	end{start},
+	roundSamples{},
+	moduleSamples{},
+	poolSamples{},
+	idleSamples{}
+{
+	roundSamples.reserve(rounds);
+	for (auto& pool: poolPlan) {
+		if (pool->plan->empty()) continue;
+		samplesOf(poolSamples, pool->poolName);
+		samplesOf(idleSamples, pool->poolName);
+		for (auto& record: *pool->plan) samplesOf(moduleSamples, record.data->id);
+	}
+}
+
+
+
+BenchmarkRecorder& BenchmarkRecorder::record(const PoolPlan& poolPlan, const ModuleTable& table, unsigned long long round, std::chrono::nanoseconds roundDuration)
+{
+	if (complete()) return *this;
+	if (++recorded<=warmupRounds) {
+		if (recorded==warmupRounds) start = std::chrono::steady_clock::now();
+		return *this;
+	}
+
+	roundSamples.push_back(roundDuration.count());
+	for (auto& pool: poolPlan) {
+		if (pool->round!=round || pool->plan->empty()) continue;
+		std::chrono::nanoseconds busy = std::min(pool->busy, roundDuration);
+		samplesOf(poolSamples, pool->poolName).push_back(busy.count());
+		samplesOf(idleSamples, pool->poolName).push_back((roundDuration-busy).count());
+		for (auto& record: *pool->plan)
+			samplesOf(moduleSamples, record.data->id).push_back(table[record.index].duration.count());
+	}
+
+	if (complete()) end = std::chrono::steady_clock::now();
+
+	return *this;
+}
+
+
+
+BenchmarkSummary BenchmarkRecorder::summarize() const
+{
+	BenchmarkSummary summary{warmupRounds, roundSamples.size(), 0, 0, summarize(roundSamples), {}, {}, {}, 0};
+
+	summary.seconds = std::chrono::duration<double>{end-start}.count();
+	summary.roundsPerSecond = summary.seconds>0 ? summary.rounds/summary.seconds : 0;
+	for (auto& it: moduleSamples) summary.modules[it.first] = summarize(it.second);
+	for (auto& it: poolSamples) summary.pools[it.first] = summarize(it.second);
+	for (auto& it: idleSamples) summary.poolIdle[it.first] = summarize(it.second);
+
+	rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage)==0) summary.peakRSS = usage.ru_maxrss;
+#ifdef __APPLE__
+	summary.peakRSS /= 1024; // bytes on OSX
+#endif
+
+	return summary;
+}
+
+
+
+BenchmarkRecorder::Samples& BenchmarkRecorder::samplesOf(std::map<std::string, Samples>& samples, const std::string& name)
+{
+	auto it = samples.find(name);
+	if (it!=samples.end()) return it->second;
+
+	Samples& created = samples[name];
+	created.reserve(rounds);
+
+	return created;
+}
+
+
+
+DurationSummary BenchmarkRecorder::summarize(Samples samples)
+{
+	if (samples.empty()) return {0, 0, 0, 0, 0};
+
+	// nearest rank percentiles
+	std::sort(samples.begin(), samples.end());
+	auto percentile = [&](double p) {
+		size_t rank = static_cast<size_t>(std::ceil(p*samples.size()));
+		return samples[std::max<size_t>(rank, 1)-1]/1000.0;
+	};
+	double sum = 0;
+	for (auto sample: samples) sum += sample;
+
+	return {sum/samples.size()/1000.0, percentile(0.5), percentile(0.9), percentile(0.99), samples.back()/1000.0};
+}
+
@@ -0,0 +1,84 @@
+#ifndef BVS_BENCHMARKRECORDER_H
+#define BVS_BENCHMARKRECORDER_H
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "bvs/benchmark.h"
+#include "controldata.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Records round, pool and module durations of a benchmark run.
+	 * Control feeds it after every round. The first warmupRounds rounds are
+	 * only counted, the following rounds are kept in full, so percentiles
+	 * are exact. Sample vectors are reserved up front for all modules and
+	 * pools known at construction, recording rounds does not allocate.
+	 */
+	class BenchmarkRecorder
+	{
+		public:
+			/** Create recorder.
+			 * @param[in] warmupRounds Rounds to skip.
+			 * @param[in] rounds Rounds to measure.
+			 * @param[in] poolPlan Pools (and their modules) to reserve samples for.
+			 */
+			BenchmarkRecorder(unsigned long long warmupRounds, unsigned long long rounds, const PoolPlan& poolPlan);
+
+			/** Record the last round (called by master after round sync).
+			 * @param[in] poolPlan Pools of the round.
+			 * @param[in] table Module states, indexed by the plan entries.
+			 * @param[in] round Round number.
+			 * @param[in] roundDuration Duration of the round.
+			 * @return Reference to object.
+			 */
+			BenchmarkRecorder& record(const PoolPlan& poolPlan, const ModuleTable& table, unsigned long long round, std::chrono::nanoseconds roundDuration);
+
+			/** Check if all rounds were recorded.
+			 * @return True if warmup and measured rounds are done.
+			 */
+			bool complete() const { return recorded>=warmupRounds+rounds; }
+
+			/** Summarize the measured rounds.
+			 * @return Summary.
+			 */
+			BenchmarkSummary summarize() const;
+
+		private:
+			/** Samples in nanoseconds. */
+			typedef std::vector<std::chrono::nanoseconds::rep> Samples;
+
+			/** Get samples of a name, creating (and reserving) them on first use.
+			 * @param[in,out] samples Sample map.
+			 * @param[in] name Module or pool name.
+			 * @return Samples.
+			 */
+			Samples& samplesOf(std::map<std::string, Samples>& samples, const std::string& name);
+
+			/** Summarize samples.
+			 * @param[in] samples Samples.
+			 * @return Duration summary in microseconds.
+			 */
+			static DurationSummary summarize(Samples samples);
+
+			unsigned long long warmupRounds; /**< Rounds to skip. */
+			unsigned long long rounds; /**< Rounds to measure. */
+			unsigned long long recorded; /**< Rounds seen so far. */
+			std::chrono::steady_clock::time_point start; /**< End of warmup. */
+			std::chrono::steady_clock::time_point end; /**< End of the last measured round. */
+			Samples roundSamples; /**< Round durations. */
+			std::map<std::string, Samples> moduleSamples; /**< Module durations. */
+			std::map<std::string, Samples> poolSamples; /**< Pool busy times. */
+			std::map<std::string, Samples> idleSamples; /**< Pool idle times. */
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_BENCHMARKRECORDER_H
+
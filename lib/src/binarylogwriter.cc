@@ -0,0 +1,178 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "binarylogwriter.h"
+
+using BVS::BinaryLogWriter;
+
+
+
+namespace
+{
+	thread_local std::string threadRecord; /**< Reused record buffer of the calling thread. */
+	std::atomic<uint32_t> threadCount{0}; /**< Number of threads that wrote messages. */
+	thread_local uint32_t threadIndex = 0; /**< Index of the calling thread (0 until assigned). */
+
+	/** Append a raw value to a record. */
+	template<typename T> void appendValue(std::string& record, T value)
+	{
+		record.append(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	/** Append a string with 16 bit length to a record. */
+	void appendString(std::string& record, const char* value)
+	{
+		uint16_t length = std::min<size_t>(strlen(value), UINT16_MAX);
+		appendValue(record, length);
+		record.append(value, length);
+	}
+}
+
+
+
+BinaryLogWriter::BinaryLogWriter(const std::string& path, size_t capacity)
+	: path{path}
+	, error{}
+	, fd{-1}
+	, capacity{std::max(capacity, sizeof(BinaryLogHeader))}
+	, map{nullptr}
+	, used{sizeof(BinaryLogHeader)}
+	, dropped{0}
+	, registerMutex{}
+	, siteCount{0}
+	, loggerCount{0}
+{
+	fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd<0) {
+		error = "could not create binary log '" + path + "': " + strerror(errno);
+		return;
+	}
+
+	// allocate the blocks, writing to a sparse mapping on a full disk raises SIGBUS
+	int result = posix_fallocate(fd, 0, this->capacity);
+	if (result!=0) {
+		error = "could not allocate binary log '" + path + "': " + strerror(result);
+		return;
+	}
+
+	void* file = mmap(nullptr, this->capacity, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (file==MAP_FAILED) {
+		error = "could not map binary log '" + path + "': " + strerror(errno);
+		return;
+	}
+	map = static_cast<char*>(file);
+
+	// the allocated file reads as zeros, an empty record size marks the end
+	BinaryLogHeader* header = new(map) BinaryLogHeader;
+	memcpy(header->magic, "BVSBLOG", 8);
+	header->version = binaryLogVersion;
+	header->headerSize = sizeof(BinaryLogHeader);
+	header->pid = getpid();
+	header->startTime = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+
+
+BinaryLogWriter::~BinaryLogWriter()
+{
+	if (map) munmap(map, capacity);
+	if (fd>=0) {
+		// drop the unused rest of the file
+		if (map && ftruncate(fd, std::min(used.load(), capacity))!=0)
+			error = "could not truncate binary log '" + path + "': " + strerror(errno);
+		close(fd);
+	}
+}
+
+
+
+bool BinaryLogWriter::write(Logger& logger, LogSite& site, int level, const std::string& arguments)
+{
+	if (!map) return false;
+
+	uint32_t siteId = site.id.load(std::memory_order_acquire);
+	if (!siteId) siteId = registerSite(site);
+	uint32_t loggerId = logger.binaryId.load(std::memory_order_acquire);
+	if (!loggerId) loggerId = registerLogger(logger);
+	if (!threadIndex) threadIndex = ++threadCount;
+
+	std::string& record = threadRecord;
+	record.clear();
+	appendValue(record, uint32_t{0});
+	appendValue(record, binaryLogMessage);
+	appendValue(record, static_cast<uint8_t>(level));
+	appendValue(record, siteId);
+	appendValue(record, loggerId);
+	appendValue(record, threadIndex);
+	appendValue(record, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+					std::chrono::system_clock::now().time_since_epoch()).count()));
+	record += arguments;
+
+	return append(record);
+}
+
+
+
+uint32_t BinaryLogWriter::registerSite(LogSite& site)
+{
+	std::lock_guard<std::mutex> lock{registerMutex};
+	if (site.id) return site.id;
+
+	uint32_t id = ++siteCount;
+	std::string record;
+	appendValue(record, uint32_t{0});
+	appendValue(record, binaryLogSite);
+	appendValue(record, id);
+	appendValue(record, static_cast<uint32_t>(site.line));
+	appendString(record, site.file);
+	appendString(record, site.expression);
+	append(record);
+
+	// publish id after the site record, so messages always follow it
+	site.id.store(id, std::memory_order_release);
+	return id;
+}
+
+
+
+uint32_t BinaryLogWriter::registerLogger(Logger& logger)
+{
+	std::lock_guard<std::mutex> lock{registerMutex};
+	if (logger.binaryId) return logger.binaryId;
+
+	uint32_t id = ++loggerCount;
+	std::string record;
+	appendValue(record, uint32_t{0});
+	appendValue(record, binaryLogLogger);
+	appendValue(record, id);
+	record += logger.name;
+	append(record);
+
+	logger.binaryId.store(id, std::memory_order_release);
+	return id;
+}
+
+
+
+bool BinaryLogWriter::append(std::string& record)
+{
+	uint32_t size = record.size();
+	memcpy(&record[0], &size, sizeof(size));
+
+	size_t offset = used.fetch_add(size, std::memory_order_relaxed);
+	if (offset+size > capacity) {
+		dropped++;
+		return false;
+	}
+
+	memcpy(map+offset, record.data(), size);
+	return true;
+}
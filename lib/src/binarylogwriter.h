@@ -0,0 +1,100 @@
+#ifndef BVS_BINARYLOGWRITER_H
+#define BVS_BINARYLOGWRITER_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+
+#include "bvs/binarylog.h"
+#include "bvs/logger.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Writes the binary log (see BinaryLogHeader).
+	 * Maps a file of fixed size and appends records without locking: every
+	 * message reserves its space with an atomic add and copies the record.
+	 * Call sites and loggers are registered once (locked), messages only
+	 * carry their ids and the raw argument values. Since the file is mapped
+	 * shared, all written records survive a crash of the process.
+	 *
+	 * Once the file is full, further messages are dropped and counted. On
+	 * destruction the file is truncated to the used size.
+	 */
+	class BinaryLogWriter
+	{
+		public:
+			/** Create and map binary log.
+			 * @param[in] path File path.
+			 * @param[in] capacity File size in bytes.
+			 */
+			BinaryLogWriter(const std::string& path, size_t capacity);
+
+			/** Unmap and truncate binary log. */
+			~BinaryLogWriter();
+
+			/** Write a message.
+			 * @param[in,out] logger Logger of the message (registered on first use).
+			 * @param[in,out] site Call site of the message (registered on first use).
+			 * @param[in] level Message level.
+			 * @param[in] arguments Tagged argument values, see LogRecord.
+			 * @return False if the message was dropped.
+			 */
+			bool write(Logger& logger, LogSite& site, int level, const std::string& arguments);
+
+			/** Error message if the log could not be created.
+			 * @return Error message (empty on success).
+			 */
+			const std::string& getError() const { return error; }
+
+			/** Number of dropped messages.
+			 * @return Messages that did not fit into the file.
+			 */
+			unsigned long long getDropped() const { return dropped.load(); }
+
+			/** Path of the binary log.
+			 * @return File path.
+			 */
+			const std::string& getPath() const { return path; }
+
+		private:
+			/** Assign an id to a call site and write its record.
+			 * @param[in,out] site Call site.
+			 * @return Site id.
+			 */
+			uint32_t registerSite(LogSite& site);
+
+			/** Assign an id to a logger and write its record.
+			 * @param[in,out] logger Logger.
+			 * @return Logger id.
+			 */
+			uint32_t registerLogger(Logger& logger);
+
+			/** Reserve space and copy a record (size is patched in).
+			 * @param[in,out] record Record, starting with a placeholder for its size.
+			 * @return False if the record did not fit.
+			 */
+			bool append(std::string& record);
+
+			std::string path; /**< File path. */
+			std::string error; /**< Error message, empty if open. */
+			int fd; /**< File descriptor. */
+			size_t capacity; /**< Mapped size. */
+			char* map; /**< Mapped file (nullptr if not mapped). */
+			std::atomic<size_t> used; /**< Reserved bytes (may exceed capacity). */
+			std::atomic<unsigned long long> dropped; /**< Dropped messages. */
+			std::mutex registerMutex; /**< Serializes site and logger registration. */
+			uint32_t siteCount; /**< Registered call sites. */
+			uint32_t loggerCount; /**< Registered loggers. */
+
+			BinaryLogWriter(const BinaryLogWriter&) = delete; /**< -Weffc++ */
+			BinaryLogWriter& operator=(const BinaryLogWriter&) = delete; /**< -Weffc++ */
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_BINARYLOGWRITER_H
+
@@ -1,4 +1,13 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iomanip>
+#include <sstream>
+#include <thread>
+
 #include "bvs/bvs.h"
+#include "bvs/utils.h"
+#include "configwatcher.h"
 #include "control.h"
 #include "loader.h"
 
@@ -11,15 +20,17 @@
 BVS::BVS::BVS(const int argc, const char** argv, std::function<void()> shutdownHandler)
 	: config{"bvs", argc, argv}
 	, shutdownHandler(shutdownHandler)
-	, info(Info{bvs_version, config, 0, {}, std::map<std::string, std::chrono::duration<unsigned int, std::milli>>{}, std::map<std::string, std::chrono::duration<unsigned int, std::milli>>{}})
+	, info(Info{bvs_version, config, 0, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, 0, 1, {}, {0, 0}})
 #ifdef BVS_LOG_SYSTEM
 	, logSystem{LogSystem::connectToLogSystem()}
 	, logger{"BVS", bvs_log_system_verbosity, Logger::LogTarget::TO_CLI_AND_FILE, shutdownHandler}
 #endif
 	, loader{new Loader{info}}
 	, control{new Control{loader->modules, *this, info, config.getValue<bool>("BVS.logStatistics", bvs_log_statistics), config.getValue<unsigned int>("BVS.minRoundTime", bvs_minimal_round_time)}}
+	, configWatcher{config.getValue<bool>("BVS.configWatch", bvs_config_watch) ? new ConfigWatcher{config} : nullptr}
 	, moduleStack{}
 	, connectorTypeMatching{config.getValue<bool>("BVS.connectorTypeMatching", bvs_connector_type_matching)}
+	, connectorStatistics{config.getValue<bool>("BVS.connectorStatistics", bvs_connector_statistics)}
 	, parallelism{config.getValue<std::string>("BVS.parallelism", bvs_parallelism)}
 {
 #ifdef BVS_LOG_SYSTEM
@@ -45,6 +56,7 @@ BVS::BVS::BVS(const int argc, const char** argv, std::function<void()> shutdownH
 
 BVS::BVS::~BVS()
 {
+	delete configWatcher;
 	delete control;
 	delete loader;
 	LOG(2, "bvs " << info.version);
@@ -65,7 +77,8 @@ BVS::BVS& BVS::BVS::loadModules()
 		return *this;
 	}
 
-	// load all selected modules
+	// parse all selected modules
+	std::vector<ModuleTraits> traits;
 	bool singlePool;
 	for (auto& it : moduleList) {
 		singlePool = false;
@@ -82,8 +95,49 @@ BVS::BVS& BVS::BVS::loadModules()
 			it.erase(0, pos+1);
 		}
 
-		loadModule(it , singlePool, poolName);
+		traits.push_back(parseModuleTraits(it, singlePool, poolName));
+		for (size_t i=0; i<traits.size()-1; i++)
+			if (traits[i].id==traits.back().id)
+				LOG(0, "Duplicate id for module: " << traits.back().id << std::endl << "If you try to load a module more than once, use unique ids and the id(library).options syntax!");
+	}
+
+	// open libraries and construct modules, concurrently if selected
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	size_t threads = std::max(1u, config.getValue<unsigned int>("BVS.loadThreads", bvs_load_threads));
+	threads = std::min(threads, traits.size());
+	auto load = [&](const ModuleTraits& t) { loader->load(t.id, t.library, t.configuration, t.options, t.poolName); };
+	if (threads==1) {
+		for (auto& t: traits) load(t);
+	} else {
+		std::atomic<size_t> next{0};
+		std::vector<std::thread> workers;
+		for (size_t i=0; i<threads; i++)
+			workers.emplace_back([&]() {
+					nameThisThread("loader");
+					for (size_t j=next++; j<traits.size(); j=next++) load(traits[j]);
+					});
+		for (auto& worker: workers) worker.join();
+	}
+
+	// start modules in configuration order, pools are created on the way
+	// formatted before logging, captured log arguments (binary log, duplicate suppression) ignore manipulators
+	auto milliseconds = [](std::chrono::nanoseconds duration) {
+		std::ostringstream out;
+		out << std::fixed << std::setprecision(1) << std::chrono::duration<double, std::milli>{duration}.count() << "ms";
+		return out.str();
+	};
+	for (auto& t: traits) {
+		std::chrono::steady_clock::time_point started = std::chrono::steady_clock::now();
+		control->startModule(t.id);
+		moduleStack.push(t.id);
+
+		const ModuleData& data = *loader->modules[t.id];
+		LOG(2, "Startup '" << t.id << "': library " << milliseconds(data.libraryDuration) << ", constructor "
+				<< milliseconds(data.constructorDuration) << ", start "
+				<< milliseconds(std::chrono::steady_clock::now()-started));
 	}
+	LOG(2, "Loaded " << traits.size() << " modules in " << milliseconds(std::chrono::steady_clock::now()-start)
+			<< " (" << threads << " loader threads)");
 
 	return *this;
 }
@@ -91,6 +145,20 @@ BVS::BVS& BVS::BVS::loadModules()
 
 
 BVS::BVS& BVS::BVS::loadModule(const std::string& moduleTraits, bool singlePool, std::string poolName)
+{
+	ModuleTraits traits = parseModuleTraits(moduleTraits, singlePool, poolName);
+
+	// load
+	loader->load(traits.id, traits.library, traits.configuration, traits.options, traits.poolName);
+	control->startModule(traits.id);
+	moduleStack.push(traits.id);
+
+	return *this;
+}
+
+
+
+BVS::BVS::ModuleTraits BVS::BVS::parseModuleTraits(const std::string& moduleTraits, bool singlePool, std::string poolName)
 {
 	std::string id;
 	std::string library;
@@ -127,12 +195,7 @@ BVS::BVS& BVS::BVS::loadModule(const std::string& moduleTraits, bool singlePool,
 	if (configuration.empty()) configuration = id;
 	if (poolName.empty() && singlePool) poolName = id;
 
-	// load
-	loader->load(id, library, configuration, options, poolName);
-	control->startModule(id);
-	moduleStack.push(id);
-
-	return *this;
+	return ModuleTraits{id, library, configuration, options, poolName};
 }
 
 
@@ -175,6 +238,25 @@ BVS::BVS& BVS::BVS::loadConfigFile(const std::string& configFile)
 	logSystem->updateSettings(config);
 	logSystem->updateLoggerLevels(config);
 #endif
+	if (configWatcher) configWatcher->watch();
+
+	return *this;
+}
+
+
+
+BVS::BVS& BVS::BVS::applyConfigChanges()
+{
+	std::vector<std::string> changed = config.applyReload();
+	if (configWatcher) configWatcher->watch();
+	if (changed.empty()) return *this;
+
+	std::string options;
+	for (auto& option: changed) options += " " + option;
+	LOG(2, "config changed:" << options);
+#ifdef BVS_LOG_SYSTEM
+	logSystem->updateLoggerLevels(config);
+#endif
 
 	return *this;
 }
@@ -307,6 +389,7 @@ BVS::BVS& BVS::BVS::hotSwap(const std::string& id)
 		control->waitUntilInactive(id);
 
 		loader->hotSwapModule(id);
+		control->updateModule(id);
 		control->sendCommand(state);
 	}
 	else
@@ -322,9 +405,46 @@ BVS::BVS& BVS::BVS::hotSwap(const std::string& id)
 
 
 
+BVS::BVS& BVS::BVS::logConnectorStatistics()
+{
+	loader->logConnectorStatistics();
+
+	return *this;
+}
+
+
+
+BVS::BVS& BVS::BVS::dumpFlightRecorder()
+{
+	control->dumpFlightRecorder();
+
+	return *this;
+}
+
+
+
+BVS::BenchmarkSummary BVS::BVS::benchmark(unsigned long long warmupRounds, unsigned long long rounds)
+{
+	return control->benchmark(warmupRounds, rounds);
+}
+
+
+
+BVS::BVS& BVS::BVS::flushLog()
+{
+#ifdef BVS_LOG_SYSTEM
+	if (logSystem) logSystem->flush();
+#endif
+
+	return *this;
+}
+
+
+
 BVS::BVS& BVS::BVS::quit()
 {
 	control->sendCommand(SystemFlag::QUIT);
+	if (connectorStatistics) logConnectorStatistics();
 	unloadModules();
 
 	return *this;
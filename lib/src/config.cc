@@ -5,6 +5,22 @@
 #include "bvs/config.h"
 
 using BVS::Config;
+using BVS::ConfigValueBase;
+
+
+
+ConfigValueBase::~ConfigValueBase()
+{
+	release();
+}
+
+
+
+void ConfigValueBase::release()
+{
+	if (config) config->unregisterHandle(this);
+	config = nullptr;
+}
 
 
 
@@ -13,7 +29,20 @@ Config::Config(const std::string& name, const int argc, const char** argv)
 	mutex{},
 	optionStore{},
 	sections{},
-	fileStack{}
+	fileStack{},
+	handles{},
+	commandLineOptions{},
+	configFiles{},
+	loadedFiles{},
+	stagedOptions{},
+	stagedSections{},
+	stagedFiles{},
+	reloadPending{false},
+	valuesRetired{false},
+	reloading{false},
+	reloadFailed{false},
+	subscribers{},
+	subscriberCount{0}
 {
 	if (argc!=0 && argv!=nullptr) loadCommandLine(argc, argv);
 }
@@ -91,6 +120,7 @@ Config& Config::loadCommandLine(const int argc, const char** argv)
 
 				// add
 				optionStore[option.substr(0, equalPos)] = option.substr(equalPos+1, option.size());
+				commandLineOptions[option.substr(0, equalPos)] = option.substr(equalPos+1, option.size());
 				arg.erase(0, separatorPos+1);
 			}
 		}
@@ -98,6 +128,7 @@ Config& Config::loadCommandLine(const int argc, const char** argv)
 
 	// load config file if given on command line
 	if (!configFile.empty()) loadConfigFile(configFile);
+	else refreshHandles();
 
 	return *this;
 }
@@ -124,6 +155,11 @@ Config& Config::loadConfigFile(const std::string& configFile)
 
 	std::lock_guard<std::recursive_mutex> lock{mutex};
 
+	// remember files for reloading
+	if (fileStack.empty()) configFiles.push_back(configFile);
+	if (std::find(loadedFiles.begin(), loadedFiles.end(), configFile)==loadedFiles.end())
+		loadedFiles.push_back(configFile);
+
 	/* algorithm:
 	 * FOR EACH line in config file
 	 * DO
@@ -226,6 +262,9 @@ Config& Config::loadConfigFile(const std::string& configFile)
 		if (optionStore.find(option)==optionStore.end()) optionStore[option] = tmp;
 	}
 
+	// refresh handles once the outermost file is loaded
+	if (fileStack.empty()) refreshHandles();
+
 	return *this;
 }
 
@@ -263,9 +302,155 @@ std::string Config::searchOption(std::string option) const
 
 
 
+void Config::registerHandle(ConfigValueBase* value) const
+{
+	std::lock_guard<std::recursive_mutex> lock{mutex};
+
+	handles.push_back(value);
+}
+
+
+
+void Config::unregisterHandle(ConfigValueBase* value) const
+{
+	std::lock_guard<std::recursive_mutex> lock{mutex};
+
+	handles.erase(std::remove(handles.begin(), handles.end(), value), handles.end());
+}
+
+
+
+void Config::refreshHandles()
+{
+	std::lock_guard<std::recursive_mutex> lock{mutex};
+
+	for (auto& handle: handles) handle->refresh(*this);
+	if (!handles.empty()) valuesRetired.store(true, std::memory_order_release);
+}
+
+
+
+void Config::reclaim()
+{
+	if (!valuesRetired.load(std::memory_order_acquire)) return;
+
+	std::lock_guard<std::recursive_mutex> lock{mutex};
+	valuesRetired.store(false, std::memory_order_relaxed);
+	for (auto& handle: handles) handle->reclaim();
+}
+
+
+
+unsigned int Config::subscribe(ChangeCallback callback) const
+{
+	std::lock_guard<std::recursive_mutex> lock{mutex};
+
+	subscribers[++subscriberCount] = callback;
+
+	return subscriberCount;
+}
+
+
+
+void Config::unsubscribe(unsigned int id) const
+{
+	std::lock_guard<std::recursive_mutex> lock{mutex};
+
+	subscribers.erase(id);
+}
+
+
+
+std::vector<std::string> Config::getLoadedFiles() const
+{
+	std::lock_guard<std::recursive_mutex> lock{mutex};
+
+	return loadedFiles;
+}
+
+
+
+bool Config::stageReload()
+{
+	std::vector<std::string> files;
+	{
+		std::lock_guard<std::recursive_mutex> lock{mutex};
+		files = configFiles;
+	}
+
+	// parse into a fresh config, command line options still come first
+	Config fresh{name};
+	fresh.reloading = true;
+	fresh.optionStore = commandLineOptions;
+	for (auto& file: files) fresh.loadConfigFile(file);
+	if (fresh.reloadFailed)
+	{
+		std::cerr << "[WARNING|Config] config reload failed, keeping current options" << std::endl;
+		return false;
+	}
+
+	std::lock_guard<std::recursive_mutex> lock{mutex};
+	if (fresh.optionStore==optionStore && fresh.loadedFiles==loadedFiles) return false;
+
+	stagedOptions = std::move(fresh.optionStore);
+	stagedSections = std::move(fresh.sections);
+	stagedFiles = std::move(fresh.loadedFiles);
+	reloadPending.store(true, std::memory_order_release);
+
+	return true;
+}
+
+
+
+std::vector<std::string> Config::applyReload()
+{
+	std::vector<std::string> changed;
+	std::map<unsigned int, ChangeCallback> callbacks;
+	{
+		std::lock_guard<std::recursive_mutex> lock{mutex};
+		if (!reloadPending.exchange(false)) return changed;
+
+		// diff both sorted stores
+		auto current = optionStore.begin();
+		auto staged = stagedOptions.begin();
+		while (current!=optionStore.end() || staged!=stagedOptions.end())
+		{
+			if (staged==stagedOptions.end() || (current!=optionStore.end() && current->first<staged->first))
+				changed.push_back((current++)->first);
+			else if (current==optionStore.end() || staged->first<current->first)
+				changed.push_back((staged++)->first);
+			else
+			{
+				if (current->second!=staged->second) changed.push_back(current->first);
+				++current;
+				++staged;
+			}
+		}
+
+		optionStore.swap(stagedOptions);
+		sections.swap(stagedSections);
+		loadedFiles.swap(stagedFiles);
+		refreshHandles();
+		callbacks = subscribers;
+	}
+
+	// notify outside the lock, so callbacks may (un)subscribe
+	if (!changed.empty())
+		for (auto& callback: callbacks) callback.second(changed);
+
+	return changed;
+}
+
+
+
 inline void Config::error(const std::string& configFile, int lineNumber, const std::string& line, const std::string& message) const
 {
 	std::cerr << "[ERROR|Config] " << configFile << ":" << lineNumber << ": " << line << " <=== " << message <<  std::endl;
+	if (reloading)
+	{
+		reloadFailed = true;
+		return;
+	}
 	exit(1);
 }
 
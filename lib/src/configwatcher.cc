@@ -0,0 +1,130 @@
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+#include "configwatcher.h"
+#include "bvs/utils.h"
+
+using BVS::ConfigWatcher;
+
+
+
+ConfigWatcher::ConfigWatcher(Config& config)
+	: logger{"ConfigWatch"},
+	config(config),
+	fd{-1},
+	mutex{},
+	directories{},
+	files{},
+	running{false},
+	thread{}
+{
+#ifdef __linux__
+	fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (fd<0) {
+		LOG(1, "could not watch config files: " << strerror(errno));
+		return;
+	}
+
+	watch();
+	running = true;
+	thread = std::thread{&ConfigWatcher::run, this};
+#else
+	LOG(1, "watching config files is only supported on Linux!");
+#endif //__linux__
+}
+
+
+
+ConfigWatcher::~ConfigWatcher()
+{
+	running = false;
+	if (thread.joinable()) thread.join();
+#ifdef __linux__
+	if (fd>=0) close(fd);
+#endif //__linux__
+}
+
+
+
+ConfigWatcher& ConfigWatcher::watch()
+{
+#ifdef __linux__
+	if (fd<0) return *this;
+
+	std::lock_guard<std::mutex> lock{mutex};
+	for (auto& file: config.getLoadedFiles()) {
+		size_t slash = file.find_last_of('/');
+		std::string directory = slash==std::string::npos ? "." : file.substr(0, slash);
+		std::string name = slash==std::string::npos ? file : file.substr(slash+1);
+		if (!files.insert(directory + '/' + name).second) continue;
+
+		// adding a directory twice returns the same descriptor
+		int wd = inotify_add_watch(fd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+		if (wd<0) {
+			LOG(1, "could not watch '" << file << "': " << strerror(errno));
+			continue;
+		}
+		directories[wd] = directory;
+		LOG(3, "watching '" << file << "'");
+	}
+#endif //__linux__
+
+	return *this;
+}
+
+
+
+void ConfigWatcher::run()
+{
+#ifdef __linux__
+	nameThisThread("configWatch");
+	bool changed = false;
+
+	while (running) {
+		pollfd request{fd, POLLIN, 0};
+		int ready = poll(&request, 1, interval);
+
+		// wait until the file(s) stopped changing
+		if (ready>0) {
+			if (readEvents()) changed = true;
+			continue;
+		}
+		if (!changed) continue;
+		changed = false;
+
+		// files sourced by the new options are watched once they are applied (see watch())
+		if (config.stageReload())
+			LOG(2, "config changed, applying changes before next round!");
+	}
+#endif //__linux__
+}
+
+
+
+bool ConfigWatcher::readEvents()
+{
+	bool changed = false;
+#ifdef __linux__
+	alignas(inotify_event) char buffer[4096];
+	ssize_t size;
+	std::lock_guard<std::mutex> lock{mutex};
+
+	while ((size = read(fd, buffer, sizeof(buffer)))>0) {
+		for (char* position = buffer; position<buffer+size; ) {
+			inotify_event* event = reinterpret_cast<inotify_event*>(position);
+			position += sizeof(inotify_event) + event->len;
+			if (!event->len || !directories.count(event->wd)) continue;
+			if (files.count(directories[event->wd] + '/' + event->name)) changed = true;
+		}
+	}
+#endif //__linux__
+
+	return changed;
+}
+
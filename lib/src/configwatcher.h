@@ -0,0 +1,72 @@
+#ifndef BVS_CONFIGWATCHER_H
+#define BVS_CONFIGWATCHER_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <set>
+#include <string>
+#include <thread>
+
+#include "bvs/config.h"
+#include "bvs/logger.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Watches all loaded config files and stages changes (Linux only).
+	 * Uses inotify on the directories of the loaded files (editors often
+	 * replace files instead of writing them). Once a watched file changed
+	 * and no further events arrived for one interval, the watcher calls
+	 * Config::stageReload(), the changes are applied between rounds. Call
+	 * watch() after loading a file or applying a reload, so files that are
+	 * sourced now are watched as well.
+	 */
+	class ConfigWatcher
+	{
+		public:
+			/** Create watcher and start its thread.
+			 * @param[in,out] config Config to watch and reload.
+			 */
+			ConfigWatcher(Config& config);
+
+			/** Stop watcher thread. */
+			~ConfigWatcher();
+
+			/** Watch all currently loaded config files (see Config::getLoadedFiles()).
+			 * Already watched files are skipped.
+			 * @return Reference to object.
+			 */
+			ConfigWatcher& watch();
+
+			static const int interval = 100; /**< Poll and debounce interval in ms. */
+
+		private:
+			/** Watcher thread. */
+			void run();
+
+			/** Read pending events.
+			 * @return True if a watched file changed.
+			 */
+			bool readEvents();
+
+			Logger logger; /**< Logger metadata. */
+			Config& config; /**< Watched config. */
+			int fd; /**< Inotify instance (-1 if unavailable). */
+			std::mutex mutex; /**< Protects directories and files. */
+			std::map<int, std::string> directories; /**< Watched directories by watch descriptor. */
+			std::set<std::string> files; /**< Watched files as 'directory/name'. */
+			std::atomic<bool> running; /**< Watcher thread should keep running. */
+			std::thread thread; /**< Watcher thread. */
+
+			ConfigWatcher(const ConfigWatcher&) = delete; /**< -Weffc++ */
+			ConfigWatcher& operator=(const ConfigWatcher&) = delete; /**< -Weffc++ */
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_CONFIGWATCHER_H
+
@@ -0,0 +1,74 @@
+#include "connectiongraph.h"
+
+using BVS::ConnectionGraph;
+
+
+
+ConnectionGraph::ConnectionGraph()
+	: origins{},
+	outputs{},
+	none{}
+{ }
+
+
+
+ConnectionGraph& ConnectionGraph::connect(const Endpoint& input, const Endpoint& output)
+{
+	disconnectInput(input.data);
+	origins.emplace(input.data, output);
+	outputs[output.data].push_back(input);
+
+	return *this;
+}
+
+
+
+ConnectionGraph& ConnectionGraph::disconnectInput(const ConnectorData* input)
+{
+	auto origin = origins.find(input);
+	if (origin==origins.end()) return *this;
+
+	// order of consumers does not matter, swap with last
+	auto consumers = outputs.find(origin->second.data);
+	EndpointVector& inputs = consumers->second;
+	for (size_t i=0; i<inputs.size(); i++) {
+		if (inputs[i].data!=input) continue;
+		inputs[i] = inputs.back();
+		inputs.pop_back();
+		break;
+	}
+	if (inputs.empty()) outputs.erase(consumers);
+	origins.erase(origin);
+
+	return *this;
+}
+
+
+
+ConnectionGraph& ConnectionGraph::disconnectOutput(const ConnectorData* output)
+{
+	auto consumers = outputs.find(output);
+	if (consumers==outputs.end()) return *this;
+
+	for (auto& input: consumers->second) origins.erase(input.data);
+	outputs.erase(consumers);
+
+	return *this;
+}
+
+
+
+const ConnectionGraph::Endpoint* ConnectionGraph::origin(const ConnectorData* input) const
+{
+	auto origin = origins.find(input);
+	return origin==origins.end() ? nullptr : &origin->second;
+}
+
+
+
+const ConnectionGraph::EndpointVector& ConnectionGraph::consumers(const ConnectorData* output) const
+{
+	auto consumers = outputs.find(output);
+	return consumers==outputs.end() ? none : consumers->second;
+}
+
@@ -0,0 +1,87 @@
+#ifndef BVS_CONNECTIONGRAPH_H
+#define BVS_CONNECTIONGRAPH_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "bvs/connectordata.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Index of all connections between module connectors.
+	 * Every connection (edge) is stored in both directions: each input knows
+	 * its origin and each output knows its consumers. Connecting, looking up
+	 * and disconnecting thus only touch the connectors involved, independent
+	 * of the number of loaded modules.
+	 *
+	 * The graph does not own any connector metadata, connectors have to be
+	 * disconnected before their module is unloaded.
+	 */
+	class ConnectionGraph
+	{
+		public:
+			/** One side of a connection. */
+			struct Endpoint
+			{
+				std::string module; /**< Module id. */
+				std::string connector; /**< Connector id. */
+				ConnectorData* data; /**< Connector metadata. */
+			};
+
+			/** Vector of endpoints. */
+			using EndpointVector = std::vector<Endpoint>;
+
+			/** Constructor for connection graph. */
+			ConnectionGraph();
+
+			/** Add a connection, replacing a previous connection of the input.
+			 * @param[in] input Input endpoint.
+			 * @param[in] output Output endpoint the input reads from.
+			 * @return Reference to object.
+			 */
+			ConnectionGraph& connect(const Endpoint& input, const Endpoint& output);
+
+			/** Remove the connection of an input (if any).
+			 * @param[in] input Input connector.
+			 * @return Reference to object.
+			 */
+			ConnectionGraph& disconnectInput(const ConnectorData* input);
+
+			/** Remove all connections of an output (if any).
+			 * @param[in] output Output connector.
+			 * @return Reference to object.
+			 */
+			ConnectionGraph& disconnectOutput(const ConnectorData* output);
+
+			/** Get the output an input reads from.
+			 * @param[in] input Input connector.
+			 * @return Origin endpoint or nullptr if not connected.
+			 */
+			const Endpoint* origin(const ConnectorData* input) const;
+
+			/** Get all inputs reading from an output.
+			 * @param[in] output Output connector.
+			 * @return Consumer endpoints (empty if not connected).
+			 */
+			const EndpointVector& consumers(const ConnectorData* output) const;
+
+			/** Number of connections.
+			 * @return Number of connected inputs.
+			 */
+			size_t size() const { return origins.size(); }
+
+		private:
+			std::unordered_map<const ConnectorData*, Endpoint> origins; /**< Input -> output. */
+			std::unordered_map<const ConnectorData*, EndpointVector> outputs; /**< Output -> inputs. */
+			const EndpointVector none; /**< Consumers of unconnected outputs. */
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_CONNECTIONGRAPH_H
+
@@ -2,5 +2,9 @@
 
 
 
-BVS::ConnectorMap BVS::ConnectorDataCollector::connectors;
+BVS::ConnectorMap& BVS::ConnectorDataCollector::connectors()
+{
+	thread_local ConnectorMap connectors;
+	return connectors;
+}
 
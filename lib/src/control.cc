@@ -1,14 +1,42 @@
 #include <algorithm>
 #include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
 
+#ifdef __linux__
+#include <pthread.h>
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+#include "allocationtracker.h"
 #include "control.h"
 #include "bvs/utils.h"
 
+using BVS::BenchmarkSummary;
 using BVS::Control;
+using BVS::PoolData;
 using BVS::SystemFlag;
 
 
 
+namespace
+{
+	/** Append printf formatted statistics to a line (arguments are checked against the format). */
+	__attribute__ ((format (printf, 2, 3))) void appendStats(std::string& line, const char* format, ...)
+	{
+		char buffer[256];
+		va_list args;
+		va_start(args, format);
+		int length = vsnprintf(buffer, sizeof(buffer), format, args);
+		va_end(args);
+		if (length>0) line.append(buffer, std::min<size_t>(length, sizeof(buffer)-1));
+	}
+}
+
+
+
 Control::Control(ModuleDataMap& modules, BVS& bvs, Info& info, bool logStatistics, unsigned int minRoundTime)
 	: modules{modules},
 	bvs{bvs},
@@ -18,15 +46,84 @@ Control::Control(ModuleDataMap& modules, BVS& bvs, Info& info, bool logStatistic
 	logger{"Control"},
 	activePools{0},
 	pools{},
+	moduleTable{info.config.getValue<unsigned int>("BVS.moduleSlots", bvs_module_slots)},
+	releasedIndices{},
+	masterPool{std::make_shared<PoolData>("master", ControlFlag::WAIT)},
+	poolPlan{},
+	compiledPoolPlan{},
+	planMutex{},
+	planPending{false},
+	statusChecks{},
+	planChanged{false},
+	allocationTracking{info.config.getValue<bool>("BVS.allocationTracking", bvs_allocation_tracking)},
+	allocationStrict{info.config.getValue<bool>("BVS.allocationStrict", bvs_allocation_strict)},
+	allocationWarmup{info.config.getValue<unsigned int>("BVS.allocationWarmup", bvs_allocation_warmup)},
+	steadyRound{allocationWarmup},
+	masterAllocations{0, 0},
+	statsLine{},
 	flag{SystemFlag::PAUSE},
+	recorder{info.config.getValue<unsigned int>("BVS.flightRecorder", bvs_flight_recorder_rounds),
+		info.config.getValue<unsigned int>("BVS.flightRecorderSlots", bvs_flight_recorder_slots),
+		2*info.config.getValue<unsigned int>("BVS.flightRecorderSlots", bvs_flight_recorder_slots)},
+	recorderJSON{info.config.getValue<std::string>("BVS.flightRecorderFormat", "JSON")!="BINARY"},
+	recorderFile{info.config.getValue<std::string>("BVS.flightRecorderFile",
+			bvs_flight_recorder_file + (recorderJSON ? ".json" : ".bin"))},
+	stallThreshold{info.config.getValue<unsigned int>("BVS.stallThreshold", bvs_stall_threshold)},
+	stallDumper{},
+	watchdog{moduleTable, std::chrono::milliseconds{info.config.getValue<unsigned int>("BVS.watchdogInterval", bvs_watchdog_interval)},
+		info.config.getValue<unsigned int>("BVS.watchdogShutdownFactor", bvs_watchdog_shutdown_factor),
+		[this](){ this->bvs.shutdownHandler(); }},
+	statsWriter{},
+	benchmarkRecorder{},
 	barrier{},
 	masterLock{barrier.attachParty()},
 	controlThread{},
+	forked{false},
+	masterThread{},
 	round{0},
+	roundStarted{false},
 	shutdownRequested{false},
 	shutdownRound{0}
 {
-	pools["master"] = std::make_shared<PoolData>("master", ControlFlag::WAIT);
+	pools["master"] = masterPool;
+	compilePool(*masterPool);
+	compilePools();
+	publishPlans();
+
+	std::vector<std::string> perfEvents;
+	info.config.getValue("BVS.perfCounters", perfEvents);
+	if (!perfEvents.empty()) {
+		info.perfCounterEvents = PerfCounters::probe(perfEvents);
+		std::string events;
+		for (auto& event: info.perfCounterEvents) events += " " + event;
+		LOG(2, "performance counters:" << (events.empty() ? " NONE" : events));
+	}
+
+	if (stallThreshold.count()>0) {
+		std::chrono::milliseconds interval{info.config.getValue<unsigned int>("BVS.stallDumpInterval", bvs_stall_dump_interval)};
+		stallDumper.reset(new FlightRecorderDumper{recorder, recorderFile, recorderJSON, interval});
+	}
+
+	if (info.config.getValue<bool>("BVS.statsPage", bvs_stats_page)) {
+		unsigned int slots = info.config.getValue<unsigned int>("BVS.statsPageSlots", bvs_stats_page_slots);
+		statsWriter.reset(new StatsWriter{slots, slots, 4*slots});
+	}
+
+	if (allocationTracking && !AllocationTracker::available()) {
+		LOG(1, "allocationTracking requires a library built with BVS_ALLOCATION_TRACKING, disabled!");
+		allocationTracking = false;
+	}
+}
+
+
+
+Control::~Control()
+{
+	for (auto& pool: pools) pool.second->flag = ControlFlag::QUIT;
+	barrier.notify();
+
+	for (auto& pool: pools)
+		if (pool.second->thread.joinable()) pool.second->thread.join();
 }
 
 
@@ -35,10 +132,13 @@ Control& Control::masterController(const bool forkMasterController)
 {
 	if (forkMasterController) {
 		LOG(3, "master -> FORKED!");
+		// controlThread is assigned after the thread started, the master cannot check it
+		forked = true;
 		controlThread = std::thread{&Control::masterController, this, false};
 		return *this;
 	} else {
 		nameThisThread("master");
+		openPerfCounters(*masterPool);
 
 		// startup sync
 		barrier.notify();
@@ -53,9 +153,40 @@ Control& Control::masterController(const bool forkMasterController)
 		// round sync
 		barrier.enqueue(masterLock, [&](){ return activePools.load()==0; });
 
+		// join pools that ran out of modules
+		{
+			std::lock_guard<std::mutex> lock{planMutex};
+			for (auto it = pools.begin(); it!=pools.end(); ) {
+				if (!it->second->done) { ++it; continue; }
+				if (it->second->thread.joinable()) it->second->thread.join();
+				LOG(3, "POOL(" << it->first << ") JOINED!");
+				it = pools.erase(it);
+				compilePools();
+			}
+		}
+
+		if (allocationTracking) checkAllocations();
+
+		std::chrono::nanoseconds roundDuration = std::chrono::high_resolution_clock::now() - timer;
 		info.lastRoundDuration =
-			std::chrono::duration_cast<std::chrono::milliseconds>
-			(std::chrono::high_resolution_clock::now() - timer);
+			std::chrono::duration_cast<std::chrono::milliseconds>(roundDuration);
+		if (roundStarted) {
+			poolStatistics(roundDuration);
+			recorder.recordRound(info.round, roundDuration);
+			if (statsWriter) statsWriter->publish(info, moduleTable, *poolPlan, roundDuration);
+			if (benchmarkRecorder && benchmarkRecorder->record(*poolPlan, moduleTable, info.round, roundDuration).complete())
+				flag = SystemFlag::PAUSE;
+			if (stallDumper && roundDuration>stallThreshold) {
+				// the dumper thread writes the file, requests within stallDumpInterval are dropped
+				bool dumping = stallDumper->request();
+				LOG(1, "round " << info.round << " took "
+						<< std::chrono::duration_cast<std::chrono::milliseconds>(roundDuration).count()
+						<< "ms (stallThreshold: " << stallThreshold.count() << "ms)"
+						<< (dumping ? ", dumping flight recorder to '" : "") << (dumping ? recorderFile.c_str() : "")
+						<< (dumping ? "'!" : "!"));
+			}
+		}
+		roundStarted = false;
 
 		if (info.lastRoundDuration.count()<minRoundTime) {
 			LOG(3, "waiting for "
@@ -66,13 +197,31 @@ Control& Control::masterController(const bool forkMasterController)
 		}
 
 		if (logStatistics) {
-			std::stringstream stats;
-			stats << "Stats[" << info.round << "]:" << info.lastRoundDuration.count();
+			// reuses the capacity of statsLine, so steady rounds do not allocate
+			statsLine.clear();
+			appendStats(statsLine, "Stats[%llu]:%u|util:%d%%|imbalance:%g", info.round,
+					info.lastRoundDuration.count(), static_cast<int>(info.roundUtilization), info.poolImbalance);
+			if (allocationTracking)
+				appendStats(statsLine, "|alloc:%llu/%lluB", info.frameworkAllocations.count, info.frameworkAllocations.bytes);
 			for (auto& pool: info.poolDurations)
-				stats << " [P]" << pool.first << ":" << pool.second.count();
-			for (auto& mod: info.moduleDurations)
-				stats << " [M]" << mod.first << ":" << mod.second.count();
-			LOG(2, stats.str());
+				appendStats(statsLine, " [P]%s:%u|idle:%u|util:%d%%", pool.first.c_str(), pool.second.count(),
+						info.poolIdleDurations[pool.first].count(), static_cast<int>(info.poolUtilization[pool.first]));
+			for (auto& mod: info.moduleDurations) {
+				appendStats(statsLine, " [M]%s:%u|cpu:%u|csw:%ld/%ld", mod.first.c_str(), mod.second.count(),
+						info.moduleCPUDurations[mod.first].count(), info.moduleContextSwitches[mod.first].voluntary,
+						info.moduleContextSwitches[mod.first].involuntary);
+				if (allocationTracking)
+					appendStats(statsLine, "|alloc:%llu/%lluB", info.moduleAllocations[mod.first].count,
+							info.moduleAllocations[mod.first].bytes);
+				auto module = modules.find(mod.first);
+				if (module!=modules.end() && module->second->arena && module->second->arena->highWaterMark())
+					appendStats(statsLine, "|arena:%zu/%zuB", module->second->arena->lastUsed(),
+							module->second->arena->highWaterMark());
+				auto& counters = info.modulePerfCounters[mod.first];
+				for (size_t i=0; i<info.perfCounterEvents.size() && i<counters.size(); i++)
+					appendStats(statsLine, "|%s:%llu", info.perfCounterEvents[i].c_str(), counters[i]);
+			}
+			LOG(2, statsLine);
 		} else {
 				LOG(2, "ROUND: " << round);
 		}
@@ -82,28 +231,51 @@ Control& Control::masterController(const bool forkMasterController)
 		switch (flag) {
 			case SystemFlag::QUIT: break;
 			case SystemFlag::PAUSE:
-				if (!controlThread.joinable()) return *this;
+				if (!forked) return *this;
 				LOG(3, "PAUSE...");
 				barrier.enqueue(masterLock, [&](){ return flag!=SystemFlag::PAUSE; });
 				timer = std::chrono::high_resolution_clock::now();
 				break;
 			case SystemFlag::RUN:
 			case SystemFlag::STEP:
-				info.round = round++;
-
-				for (auto& module: modules) {
-					if (module.second->status!=Status::OK)
-						checkModuleStatus(module.second);
-					module.second->flag = ControlFlag::RUN;
+				// values replaced in earlier rounds cannot be read anymore
+				bvs.config.reclaim();
+				if (bvs.config.hasPendingReload()) {
+					bvs.applyConfigChanges();
+					planChanged = true;
 				}
-				for (auto& pool: pools) pool.second->flag = ControlFlag::RUN;
-				activePools.fetch_add(pools.size()-1); //exclude "master" pool
+				info.round = round++;
+				Logger::round.store(info.round, std::memory_order_relaxed);
+
+				// plans only change here, pools wait for the round at the barrier
+				publishPlans();
+
+				// check modules afterwards, a finished module is unloaded right away
+				for (auto& pool: *poolPlan)
+					for (auto& record: *pool->plan) {
+						// stopped modules stay in the published plan until the next round
+						ModuleState& state = moduleTable[record.index];
+						if (state.flag==ControlFlag::QUIT) continue;
+						if (state.status!=Status::OK) statusChecks.push_back(&record);
+						ControlFlag waiting = ControlFlag::WAIT;
+						state.flag.compare_exchange_strong(waiting, ControlFlag::RUN);
+					}
+				for (const ModuleRecord* record: statusChecks) checkModuleStatus(*record);
+				statusChecks.clear();
+
+				for (auto& pool: *poolPlan) pool->flag = ControlFlag::RUN;
+				activePools.fetch_add(poolPlan->size()-1); //exclude "master" pool
 
 				barrier.notify();
-				for (auto& it: pools["master"]->modules) moduleController(*(it.get()));
-				info.poolDurations["master"] =
-					std::chrono::duration_cast<std::chrono::milliseconds>
-					(std::chrono::high_resolution_clock::now() - timer);
+				roundStarted = true;
+				if (enterPool(*masterPool)) {
+					for (auto& record: *masterPool->plan) moduleController(record, *masterPool);
+					leavePool(*masterPool);
+				}
+				masterPool->busy = std::chrono::high_resolution_clock::now() - timer;
+				masterPool->round = info.round;
+				*masterPool->duration =
+					std::chrono::duration_cast<std::chrono::milliseconds>(masterPool->busy);
 
 				if (flag==SystemFlag::STEP) flag = SystemFlag::PAUSE;
 				LOG(3, "WAIT FOR THREADS AND POOLS!");
@@ -113,10 +285,25 @@ Control& Control::masterController(const bool forkMasterController)
 
 		if (shutdownRequested && round==shutdownRound) flag = SystemFlag::QUIT;
 
-		if (!controlThread.joinable() && flag!=SystemFlag::RUN) return *this;
+		if (!forked && flag!=SystemFlag::RUN) return *this;
 	}
 
-	for (auto& pool: pools) pool.second->flag = ControlFlag::QUIT;
+	{
+		std::lock_guard<std::mutex> lock{planMutex};
+		for (auto& pool: pools) pool.second->flag = ControlFlag::QUIT;
+	}
+	barrier.notify();
+
+	if (!info.perfCounterEvents.empty())
+		for (auto& mod: info.modulePerfCounterTotals) {
+			std::stringstream totals;
+			for (size_t i=0; i<info.perfCounterEvents.size() && i<mod.second.size(); i++)
+				totals << " " << info.perfCounterEvents[i] << ":" << mod.second[i];
+			LOG(2, "Perf[" << mod.first << "]:" << totals.str() << " ipc:" << info.getIPC(mod.first)
+					<< " cache-misses/ki:" << info.getMissRate(mod.first, "cache-misses")
+					<< " branch-misses/ki:" << info.getMissRate(mod.first, "branch-misses"));
+		}
+
 	if (shutdownRequested && round==shutdownRound) bvs.shutdownHandler();
 
 	return *this;
@@ -129,8 +316,16 @@ Control& Control::sendCommand(const SystemFlag controlFlag)
 	LOG(3, "FLAG: " << (int)controlFlag);
 	flag = controlFlag;
 
-	if (controlThread.joinable()) barrier.notify();
-	else masterController(false);
+	if (controlThread.joinable()) {
+		barrier.notify();
+	} else if (masterThread.load()!=std::thread::id{} && masterThread.load()!=std::this_thread::get_id()) {
+		// the master runs in another thread (e.g. shutdown by the watchdog), it reads the flag at round sync
+		barrier.notify();
+	} else {
+		std::thread::id previous = masterThread.exchange(std::this_thread::get_id());
+		masterController(false);
+		masterThread = previous;
+	}
 
 	if (controlFlag==SystemFlag::QUIT)
 	{
@@ -159,18 +354,58 @@ Control& Control::startModule(std::string id)
 
 	if (data->poolName.empty()) data->poolName = "master";
 
+	{
+		std::lock_guard<std::mutex> lock{planMutex};
+		data->index = moduleTable.acquire(data->module.get(), data->arena.get());
+	}
+	if (data->index<0) {
+		LOG(0, "no free module slot for '" << id << "', increase BVS.moduleSlots!");
+		return *this;
+	}
+
+	// the state is not in any published plan yet, nobody else reads it
+	ModuleState& state = moduleTable[data->index];
+	state.recorderSlot = recorder.addModule(id, data->connectors);
+	if (state.recorderSlot<0) LOG(1, "flight recorder has no free slot for '" << id << "'!");
+
+	state.budget = std::chrono::milliseconds{info.config.getValue<unsigned int>(data->configuration + ".budgetMs", 0)};
+	std::string action = info.config.getValue<std::string>(data->configuration + ".budgetAction", "LOG");
+	if (action=="SKIP") state.budgetAction = BudgetAction::SKIP;
+	else if (action=="FAIL") state.budgetAction = BudgetAction::FAIL;
+	else if (action=="SHUTDOWN") state.budgetAction = BudgetAction::SHUTDOWN;
+	else if (action!="LOG") LOG(1, "unknown budgetAction '" << action << "' for '" << id << "', using LOG!");
+	watchdog.watch(data);
+
 	LOG(3, id << " -> POOL(" << data->poolName << ")");
-	if (pools.find(data->poolName)==pools.end())
+	// create statistics entries now, so pools never insert concurrently
+	info.moduleDurations[id];
+	info.moduleCPUDurations[id];
+	info.moduleContextSwitches[id];
+	info.modulePerfCounters[id].resize(info.perfCounterEvents.size());
+	info.modulePerfCounterTotals[id].resize(info.perfCounterEvents.size());
+	info.moduleAllocations[id];
+
+	std::unique_lock<std::mutex> planLock{planMutex};
+	auto it = pools.find(data->poolName);
+	if (it==pools.end())
 	{
-		pools[data->poolName] = std::make_shared<PoolData>(data->poolName, ControlFlag::WAIT);
-		pools[data->poolName]->thread = std::thread{&Control::poolController, this, pools[data->poolName]};
-		activePools.fetch_add(1);
-		waitUntilInactive(id);
-		pools[data->poolName]->modules.push_back(modules[id]);
+		// the new pool waits for the first round it is published in
+		auto pool = std::make_shared<PoolData>(data->poolName, ControlFlag::WAIT);
+		pool->modules.push_back(data);
+		compilePool(*pool);
+		pools[data->poolName] = pool;
+		compilePools();
+		pool->thread = std::thread{&Control::poolController, this, pool};
 	}
 	else
 	{
-		pools[data->poolName]->modules.push_back(modules[id]);
+		auto pool = it->second;
+		planLock.unlock();
+		std::unique_lock<std::mutex> lock{pool->mutex};
+		pool->stateChanged.wait(lock, [&](){ return !pool->active; });
+		pool->modules.push_back(data);
+		planLock.lock();
+		compilePool(*pool);
 	}
 
 	return *this;
@@ -182,23 +417,34 @@ Control& Control::stopModule(std::string id)
 {
 	// search for pool
 	if (modules.find(id)==modules.end()) return *this;
-	auto poolName = modules[id]->poolName;
-	if (pools.find(poolName)==pools.end()) return *this;
-	auto pool = pools[poolName];
-
-	// stop pool
-	auto flag = pool->flag;
-	pool->flag = ControlFlag::WAIT;
-	waitUntilInactive(id);
-
-	// remove module from pool modules
-	auto& poolModules = pools[poolName]->modules;
-	if (!poolModules.empty())
-		poolModules.erase(std::remove_if (poolModules.begin(), poolModules.end(),
-				 [&](std::shared_ptr<ModuleData> data) { return data->id==id; }));
-
-	pool->flag = flag;
-	barrier.notify();
+	auto data = modules[id];
+	watchdog.unwatch(id);
+	auto pool = findPool(data->poolName);
+
+	// wait for pool, it cannot become active again while locked
+	std::unique_lock<std::mutex> lock;
+	if (pool) {
+		lock = std::unique_lock<std::mutex>{pool->mutex};
+		pool->stateChanged.wait(lock, [&](){ return !pool->active; });
+
+		// remove module from pool modules, an empty pool quits on its next round
+		auto& poolModules = pool->modules;
+		poolModules.erase(std::remove_if(poolModules.begin(), poolModules.end(),
+					[&](std::shared_ptr<ModuleData> data) { return data->id==id; }), poolModules.end());
+	}
+
+	// the published plan keeps the module until the master publishes the new one, it is skipped from now on
+	std::lock_guard<std::mutex> planLock{planMutex};
+	if (data->index>=0) {
+		ModuleState& state = moduleTable[data->index];
+		recorder.removeModule(state.recorderSlot);
+		state.recorderSlot = -1;
+		state.flag = ControlFlag::QUIT;
+		releasedIndices.push_back(data->index);
+		data->index = -1;
+		planPending = true;
+	}
+	if (pool) compilePool(*pool);
 
 	return *this;
 }
@@ -207,11 +453,12 @@ Control& Control::stopModule(std::string id)
 
 Control& Control::waitUntilInactive(const std::string& id)
 {
-	while (isActive(id))
-	{
-		std::this_thread::sleep_for(std::chrono::milliseconds{100});
-		barrier.notify();
-	}
+	if (modules.find(id)==modules.end()) return *this;
+	auto pool = findPool(modules[id]->poolName);
+	if (!pool) return *this;
+
+	std::unique_lock<std::mutex> lock{pool->mutex};
+	pool->stateChanged.wait(lock, [&](){ return !pool->active; });
 
 	return *this;
 }
@@ -220,37 +467,140 @@ Control& Control::waitUntilInactive(const std::string& id)
 
 bool Control::isActive(const std::string& id)
 {
-	if (!modules[id]->poolName.empty())
-	{
-		if (modules.find(id)==modules.end()) return false;
-		if (pools.find(modules[id]->poolName)==pools.end()) return false;
-		if (pools[modules[id]->poolName]->flag!=ControlFlag::WAIT) return true;
-		else return false;
+	if (modules.find(id)==modules.end()) return false;
+	auto pool = findPool(modules[id]->poolName);
+	if (!pool) return false;
+
+	std::lock_guard<std::mutex> lock{pool->mutex};
+	return pool->active;
+}
+
+
+
+Control& Control::updateModule(const std::string& id)
+{
+	auto it = modules.find(id);
+	if (it==modules.end() || it->second->index<0) return *this;
+	moduleTable[it->second->index].module = it->second->module.get();
+
+	return *this;
+}
+
+
+
+bool Control::dumpFlightRecorder(const char* file)
+{
+	return recorder.dump(file ? file : recorderFile.c_str(), recorderJSON);
+}
+
+
+
+BenchmarkSummary Control::benchmark(unsigned long long warmupRounds, unsigned long long rounds)
+{
+	if (controlThread.joinable()) {
+		LOG(1, "benchmark needs an unforked master controller, use start(false)!");
+		return BenchmarkRecorder{warmupRounds, 0, PoolPlan{}}.summarize();
 	}
 
-	return false;
+	LOG(2, "benchmark: " << warmupRounds << " warmup rounds, " << rounds << " measured rounds");
+	unsigned int pacing = minRoundTime;
+	minRoundTime = 0;
+	// the master is not running, plans of modules started since the last round are published now
+	publishPlans();
+	benchmarkRecorder.reset(new BenchmarkRecorder{warmupRounds, rounds, *poolPlan});
+
+	// returns once the recorder is complete (or the system quits)
+	sendCommand(SystemFlag::RUN);
+
+	BenchmarkSummary summary = benchmarkRecorder->summarize();
+	benchmarkRecorder.reset();
+	minRoundTime = pacing;
+
+	return summary;
 }
 
 
 
-Control& Control::moduleController(ModuleData& data)
+Control& Control::moduleController(const ModuleRecord& record, PoolData& pool)
 {
+	ModuleState& state = moduleTable[record.index];
 	std::chrono::time_point<std::chrono::high_resolution_clock> modTimer =
 		std::chrono::high_resolution_clock::now();
 
-	switch (data.flag.load())
+	switch (state.flag.load())
 	{
 		case ControlFlag::QUIT: break;
 		case ControlFlag::WAIT: break;
 		case ControlFlag::RUN:
-			data.status = data.module->execute();
-			data.flag = ControlFlag::WAIT;
+			if (state.skipNext) {
+				state.skipNext = false;
+				state.flag = ControlFlag::WAIT;
+				break;
+			}
+			if (state.budget.count()>0) {
+#ifdef __linux__
+				state.nativeThread = pthread_self();
+#endif
+				state.executionStart.store(std::chrono::duration_cast<std::chrono::nanoseconds>
+						(std::chrono::steady_clock::now().time_since_epoch()).count(), std::memory_order_release);
+			}
+			executeModule(record, state, pool);
+			state.executedRound = info.round;
+			if (state.arena) state.arena->reset();
+			if (state.budget.count()>0) {
+				state.executionStart.store(0, std::memory_order_release);
+				if (state.overrun.exchange(false)) applyBudgetAction(state);
+			}
+			state.flag = ControlFlag::WAIT;
 			break;
 	}
 
-	info.moduleDurations[data.id] =
-		std::chrono::duration_cast<std::chrono::milliseconds>
-		(std::chrono::high_resolution_clock::now() - modTimer);
+	state.duration = std::chrono::high_resolution_clock::now() - modTimer;
+	*record.duration = std::chrono::duration_cast<std::chrono::milliseconds>(state.duration);
+	if (state.executedRound==info.round)
+		recorder.recordModule(state.recorderSlot, info.round, state.duration, state.cpuDuration, state.status);
+
+	return *this;
+}
+
+
+
+Control& Control::executeModule(const ModuleRecord& record, ModuleState& state, PoolData& pool)
+{
+	bool perf = pool.perfCounters && pool.perfCounters->read(pool.perfBefore);
+#ifdef __linux__
+	// thread cpu time and context switches, tells computing from waiting
+	timespec cpuStart, cpuEnd;
+	rusage usageStart, usageEnd;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuStart);
+	getrusage(RUSAGE_THREAD, &usageStart);
+#endif
+
+	if (allocationTracking) {
+		Allocations start = AllocationTracker::thread();
+		state.status = state.module->execute();
+		*record.allocations = AllocationTracker::since(start);
+	} else {
+		state.status = state.module->execute();
+	}
+
+#ifdef __linux__
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpuEnd);
+	getrusage(RUSAGE_THREAD, &usageEnd);
+	state.cpuDuration = std::chrono::seconds{cpuEnd.tv_sec - cpuStart.tv_sec}
+		+ std::chrono::nanoseconds{cpuEnd.tv_nsec - cpuStart.tv_nsec};
+	*record.cpuDuration = std::chrono::duration_cast<std::chrono::milliseconds>(state.cpuDuration);
+	*record.contextSwitches = {
+		usageEnd.ru_nvcsw - usageStart.ru_nvcsw,
+		usageEnd.ru_nivcsw - usageStart.ru_nivcsw };
+#endif
+
+	if (perf && pool.perfCounters->read(pool.perfAfter)) {
+		auto& counters = *record.perfCounters;
+		auto& totals = *record.perfCounterTotals;
+		PerfCounters::difference(pool.perfBefore, pool.perfAfter, counters);
+		for (size_t i=0; i<counters.size() && i<totals.size(); i++) totals[i] += counters[i];
+	}
 
 	return *this;
 }
@@ -260,26 +610,37 @@ Control& Control::moduleController(ModuleData& data)
 Control& Control::poolController(std::shared_ptr<PoolData> data)
 {
 	nameThisThread((data->poolName).c_str());
+	openPerfCounters(*data);
 	LOG(3, "POOL(" << data->poolName << ") STARTED!");
 	std::unique_lock<std::mutex> threadLock{barrier.attachParty()};
 	std::chrono::time_point<std::chrono::high_resolution_clock> poolTimer =
 		std::chrono::high_resolution_clock::now();
+	barrier.enqueue(threadLock, [&](){ return data->flag!=ControlFlag::WAIT; });
 
-	while (bool(data->flag) && !data->modules.empty())
+	while (enterPool(*data))
 	{
+		Allocations allocationStart = AllocationTracker::thread();
 		poolTimer = std::chrono::high_resolution_clock::now();
-		for (auto& module: data->modules) moduleController(*(module.get()));
+		ModulePlan plan = std::atomic_load(&data->plan);
+		for (auto& record: *plan) moduleController(record, *data);
+
+		// publish statistics before leaving the round, master reads them afterwards
+		data->busy = std::chrono::high_resolution_clock::now() - poolTimer;
+		data->round = info.round;
+		*data->duration = std::chrono::duration_cast<std::chrono::milliseconds>(data->busy);
 
 		if (data->flag!=ControlFlag::QUIT) data->flag = ControlFlag::WAIT;
-		activePools.fetch_sub(1);
-		info.poolDurations[data->poolName] =
-			std::chrono::duration_cast<std::chrono::milliseconds>
-			(std::chrono::high_resolution_clock::now() - poolTimer);
+		leavePool(*data);
 		LOG(3, "POOL(" << data->poolName << ") WAIT!");
+		if (allocationTracking) countAllocations(*data, *plan, allocationStart);
+		if (activePools.fetch_sub(1)==1) barrier.notify();
 		barrier.enqueue(threadLock, [&](){ return data->flag!=ControlFlag::WAIT; });
 	}
 
-	pools.erase(pools.find(data->poolName));
+	// the master joins the pool once it checked in, unless everything quits
+	data->done = true;
+	if (data->flag!=ControlFlag::QUIT && activePools.fetch_sub(1)==1) barrier.notify();
+	barrier.detachParty();
 
 	LOG(3, "POOL(" << data->poolName << ") QUITTING!");
 	return *this;
@@ -287,23 +648,214 @@ Control& Control::poolController(std::shared_ptr<PoolData> data)
 
 
 
-Control& Control::checkModuleStatus(std::shared_ptr<ModuleData> data)
+bool Control::enterPool(PoolData& pool)
+{
+	std::lock_guard<std::mutex> lock{pool.mutex};
+	if (pool.flag==ControlFlag::QUIT || pool.modules.empty()) return false;
+	pool.active = true;
+
+	return true;
+}
+
+
+
+Control& Control::leavePool(PoolData& pool)
+{
+	{
+		std::lock_guard<std::mutex> lock{pool.mutex};
+		pool.active = false;
+	}
+	pool.stateChanged.notify_all();
+
+	return *this;
+}
+
+
+
+Control& Control::compilePool(PoolData& pool)
+{
+	auto plan = std::make_shared<ModuleRecordVector>();
+	plan->reserve(pool.modules.size());
+	for (auto& data: pool.modules)
+		plan->push_back({data->index, data,
+				&info.moduleDurations[data->id],
+				&info.moduleCPUDurations[data->id],
+				&info.moduleContextSwitches[data->id],
+				&info.modulePerfCounters[data->id],
+				&info.modulePerfCounterTotals[data->id],
+				&info.moduleAllocations[data->id]});
+
+	// slots never move, they are set before the pool is published
+	if (!pool.duration) {
+		pool.duration = &info.poolDurations[pool.poolName];
+		pool.idleDuration = &info.poolIdleDurations[pool.poolName];
+		pool.utilization = &info.poolUtilization[pool.poolName];
+	}
+	pool.compiledPlan = plan;
+	planPending = true;
+	planChanged = true;
+
+	return *this;
+}
+
+
+
+Control& Control::compilePools()
+{
+	auto plan = std::make_shared<PoolPlan>();
+	plan->push_back(masterPool);
+	for (auto& pool: pools)
+		if (pool.second!=masterPool) plan->push_back(pool.second);
+	compiledPoolPlan = plan;
+	planPending = true;
+
+	return *this;
+}
+
+
+
+Control& Control::publishPlans()
+{
+	if (!planPending) return *this;
+
+	std::lock_guard<std::mutex> lock{planMutex};
+	poolPlan = compiledPoolPlan;
+	for (auto& pool: *poolPlan) std::atomic_store(&pool->plan, pool->compiledPlan);
+	planPending = false;
+
+	// stopped modules are gone from all plans, no pool refers to their states anymore
+	for (int index: releasedIndices) moduleTable.release(index);
+	releasedIndices.clear();
+
+	return *this;
+}
+
+
+
+std::shared_ptr<PoolData> Control::findPool(const std::string& poolName)
+{
+	std::lock_guard<std::mutex> lock{planMutex};
+	auto it = pools.find(poolName);
+
+	return it!=pools.end() ? it->second : nullptr;
+}
+
+
+
+Control& Control::countAllocations(PoolData& pool, const ModuleRecordVector& plan, const Allocations& start)
+{
+	Allocations framework = AllocationTracker::since(start);
+	for (auto& record: plan) {
+		framework.count -= record.allocations->count;
+		framework.bytes -= record.allocations->bytes;
+	}
+	pool.allocations = framework;
+
+	return *this;
+}
+
+
+
+Control& Control::checkAllocations()
+{
+	// the master's round lasts from round sync to round sync
+	countAllocations(*masterPool, *masterPool->plan, masterAllocations);
+
+	info.frameworkAllocations = {0, 0};
+	for (auto& pool: *poolPlan) {
+		if (pool->round!=info.round) continue;
+		info.frameworkAllocations.count += pool->allocations.count;
+		info.frameworkAllocations.bytes += pool->allocations.bytes;
+	}
+
+	if (planChanged.exchange(false)) steadyRound = round + allocationWarmup;
+	if (roundStarted && allocationStrict && info.round>=steadyRound && info.frameworkAllocations.count>0) {
+		LOG(0, "framework allocated " << info.frameworkAllocations.count << " times ("
+				<< info.frameworkAllocations.bytes << " bytes) in steady-state round " << info.round << ", aborting!");
+		bvs.flushLog();
+		std::abort();
+	}
+
+	masterAllocations = AllocationTracker::thread();
+
+	return *this;
+}
+
+
+
+Control& Control::poolStatistics(std::chrono::nanoseconds roundDuration)
+{
+	// busy time of pools that took part in the last round, idle is the rest
+	double roundTime = roundDuration.count();
+	double busySum = 0;
+	double busyMax = 0;
+	int active = 0;
+	for (auto& it: *poolPlan) {
+		PoolData& pool = *it;
+		if (pool.round!=info.round || pool.plan->empty()) continue;
+
+		// busy and round duration are taken by different threads, busy can exceed the round slightly
+		std::chrono::nanoseconds busyDuration = std::min(pool.busy, roundDuration);
+		double busy = busyDuration.count();
+		*pool.idleDuration = std::chrono::duration_cast<std::chrono::milliseconds>(roundDuration - busyDuration);
+		*pool.utilization = roundTime>0 ? 100*busy/roundTime : 0;
+
+		busySum += busy;
+		busyMax = std::max(busyMax, busy);
+		active++;
+	}
+
+	info.roundUtilization = active>0 && roundTime>0 ? 100*busySum/(active*roundTime) : 0;
+	info.poolImbalance = busySum>0 ? busyMax/(busySum/active) : 1;
+
+	return *this;
+}
+
+
+
+Control& Control::openPerfCounters(PoolData& pool)
+{
+	if (!info.perfCounterEvents.empty() && !pool.perfCounters)
+		pool.perfCounters.reset(new PerfCounters{info.perfCounterEvents});
+
+	return *this;
+}
+
+
+
+Control& Control::applyBudgetAction(ModuleState& state)
+{
+	switch (state.budgetAction)
+	{
+		case BudgetAction::LOG: break;
+		case BudgetAction::SKIP: state.skipNext = true; break;
+		case BudgetAction::FAIL: state.status = Status::FAIL; break;
+		case BudgetAction::SHUTDOWN: state.status = Status::SHUTDOWN; break;
+	}
+
+	return *this;
+}
+
+
+
+Control& Control::checkModuleStatus(const ModuleRecord& record)
 {
-	switch (data->status)
+	const ModuleData& data = *record.data;
+	switch (moduleTable[record.index].status)
 	{
 		case Status::OK: break;
-		case Status::NOINPUT: LOG(1, "MODULE " << data->id << " MISSING INPUT!"); break;
+		case Status::NOINPUT: LOG(1, "MODULE " << data.id << " MISSING INPUT!"); break;
 		case Status::FAIL: break;
 		case Status::WAIT: break;
 		case Status::DONE:
-			bvs.unloadModule(data->id);
+			bvs.unloadModule(std::string{data.id});
 			break;
 		case Status::SHUTDOWN:
 			if (!shutdownRequested)
 			{
-				LOG(1, "SHUTDOWN REQUEST BY '" << data->id << "', SHUTTING DOWN IN '" << this->pools.size() << "' ROUNDS!");
+				LOG(1, "SHUTDOWN REQUEST BY '" << data.id << "', SHUTTING DOWN IN '" << poolPlan->size() << "' ROUNDS!");
 				shutdownRequested = true;
-				shutdownRound = round + pools.size();
+				shutdownRound = round + poolPlan->size();
 			}
 			break;
 	}
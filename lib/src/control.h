@@ -2,13 +2,19 @@
 #define BVS_CONTROL_H
 
 #include <atomic>
+#include <chrono>
+#include <mutex>
 #include <thread>
 
 #include "bvs/bvs.h"
 #include "bvs/info.h"
 #include "bvs/logger.h"
 #include "barrier.h"
+#include "benchmarkrecorder.h"
 #include "controldata.h"
+#include "flightrecorder.h"
+#include "statswriter.h"
+#include "watchdog.h"
 
 
 
@@ -31,6 +37,9 @@ namespace BVS
 			*/
 			Control(ModuleDataMap& modules, BVS& bvs, Info& info, bool logStatistics = false, unsigned int minRoundTime = 0);
 
+			/** Destructor, stops and joins all pool threads. */
+			~Control();
+
 			/** The master control function.
 			 * This is the master control function, it forks if desired and can
 			 * be controlled by using sendCommand(...).
@@ -81,8 +90,9 @@ namespace BVS
 			Control& stopModule(std::string id);
 
 			/** Wait until given module is inactive.
-			 * Wait until the given module is inactive. If this never happens,
-			 * this call will loop forever.
+			 * Blocks until the pool of the given module finished executing its
+			 * modules (it is notified by the pool). If this never happens, this
+			 * call will block forever.
 			 * @param[in] id Module id to wait for.
 			 * @return Reference to object.
 			 */
@@ -95,14 +105,113 @@ namespace BVS
 			 */
 			bool isActive(const std::string& id);
 
+			/** Refresh the module state after a module was hot swapped.
+			 * Must only be called while the module's pool is inactive.
+			 * @param[in] id Module id.
+			 * @return Reference to object.
+			 */
+			Control& updateModule(const std::string& id);
+
+			/** Dump the flight recorder (recent round timings).
+			 * Only uses preallocated memory, so this can be called from
+			 * signal handlers.
+			 * @param[in] file File to dump to, uses BVS.flightRecorderFile if nullptr.
+			 * @return True on success.
+			 */
+			bool dumpFlightRecorder(const char* file = nullptr);
+
+			/** Run a benchmark, see BVS::benchmark().
+			 * Runs the master controller in the calling thread, which must
+			 * not have forked it, until all rounds are done. Ignores
+			 * minRoundTime meanwhile.
+			 * @param[in] warmupRounds Rounds to run before measuring.
+			 * @param[in] rounds Rounds to measure.
+			 * @return Summary of the measured rounds.
+			 */
+			BenchmarkSummary benchmark(unsigned long long warmupRounds, unsigned long long rounds);
+
 			ModuleDataMap& modules; /**< Reference to module meta data map. */
 
 		private:
 			/** Controls given module.
-			 * @param[in] data Module meta data.
+			 * @param[in] record Execution plan entry of the module.
+			 * @param[in] pool Pool meta data of the executing pool.
+			 * @return Reference to object.
+			 */
+			Control& moduleController(const ModuleRecord& record, PoolData& pool);
+
+			/** Execute a module, sample its cpu time, context switches and performance counters.
+			 * Only called for modules that run this round, statistics slots of
+			 * waiting or skipped modules keep their last values.
+			 * @param[in] record Execution plan entry of the module.
+			 * @param[in] state Module state.
+			 * @param[in] pool Pool meta data of the executing pool.
+			 * @return Reference to object.
+			 */
+			Control& executeModule(const ModuleRecord& record, ModuleState& state, PoolData& pool);
+
+			/** Compile the execution plan of a pool from its module vector.
+			 * Must hold planMutex, and the pool mutex while the pool is running.
+			 * The plan takes effect once the master publishes it.
+			 * @param[in] pool Pool meta data.
+			 * @return Reference to object.
+			 */
+			Control& compilePool(PoolData& pool);
+
+			/** Compile the pool table used by the master (master pool first).
+			 * Must hold planMutex.
+			 * @return Reference to object.
+			 */
+			Control& compilePools();
+
+			/** Publish compiled plans, called by the master between rounds.
+			 * @return Reference to object.
+			 */
+			Control& publishPlans();
+
+			/** Find a pool in the pool map.
+			 * @param[in] poolName Pool name.
+			 * @return Pool meta data (empty if not found).
+			 */
+			std::shared_ptr<PoolData> findPool(const std::string& poolName);
+
+			/** Count framework allocations of a pool thread (without its modules).
+			 * @param[in] pool Pool meta data of the calling pool.
+			 * @param[in] plan Plan the pool executed.
+			 * @param[in] start Allocations of the calling thread at the start of the round.
+			 * @return Reference to object.
+			 */
+			Control& countAllocations(PoolData& pool, const ModuleRecordVector& plan, const Allocations& start);
+
+			/** Sum framework allocations of the last round, abort if strict and steady.
+			 * @return Reference to object.
+			 */
+			Control& checkAllocations();
+
+			/** Calculate pool idle times, utilization and imbalance of the last round.
+			 * @param[in] roundDuration Duration of the last round.
+			 * @return Reference to object.
+			 */
+			Control& poolStatistics(std::chrono::nanoseconds roundDuration);
+
+			/** Open performance counters for the calling pool thread (if enabled).
+			 * @param[in] pool Pool meta data of the calling pool.
 			 * @return Reference to object.
 			 */
-			Control& moduleController(ModuleData& data);
+			Control& openPerfCounters(PoolData& pool);
+
+			/** Mark pool as active, unless it has to quit.
+			 * Blocks while someone else holds the pool mutex.
+			 * @param[in] pool Pool meta data.
+			 * @return False if the pool is quitting or has no modules left.
+			 */
+			bool enterPool(PoolData& pool);
+
+			/** Mark pool as inactive and notify waiting threads.
+			 * @param[in] pool Pool meta data.
+			 * @return Reference to object.
+			 */
+			Control& leavePool(PoolData& pool);
 
 			/** Control a module pool.
 			 * @param[in] data Pool meta data.
@@ -110,8 +219,17 @@ namespace BVS
 			 */
 			Control& poolController(std::shared_ptr<PoolData> data);
 
-			/** Check module status and act upon it if necessary. */
-			Control& checkModuleStatus(std::shared_ptr<ModuleData> data);
+			/** Apply budget action after an execution exceeded its budget.
+			 * @param[in] state Module state.
+			 * @return Reference to object.
+			 */
+			Control& applyBudgetAction(ModuleState& state);
+
+			/** Check module status and act upon it if necessary.
+			 * @param[in] record Published plan entry of the module (its metadata is gone from modules if it was unloaded).
+			 * @return Reference to object.
+			 */
+			Control& checkModuleStatus(const ModuleRecord& record);
 
 			BVS& bvs; /**< BVS reference. */
 			Info& info; /**< Info reference. */
@@ -119,14 +237,42 @@ namespace BVS
 			unsigned int minRoundTime; /**< Minimal round time. */
 			Logger logger; /**< Logger metadata. */
 			std::atomic<int> activePools; /**< The number of active pools. */
-			PoolMap pools; /**< Map of pools. */
-			SystemFlag flag; /**< The active system flag used by master. */
+			PoolMap pools; /**< Map of pools (guarded by planMutex). */
+			ModuleTable moduleTable; /**< Hot states of all started modules (indices guarded by planMutex). */
+			std::vector<int> releasedIndices; /**< Indices of stopped modules, released once their plans are replaced (guarded by planMutex). */
+			std::shared_ptr<PoolData> masterPool; /**< The pool run by the master itself. */
+			std::shared_ptr<const PoolPlan> poolPlan; /**< Published pools, master pool first (master only). */
+			std::shared_ptr<const PoolPlan> compiledPoolPlan; /**< Pools compiled from the pool map, not yet published. */
+			std::mutex planMutex; /**< Guards pool map and compiled plans. */
+			std::atomic<bool> planPending; /**< Compiled plans wait to be published. */
+			std::vector<const ModuleRecord*> statusChecks; /**< Modules to check before a round (reused). */
+			std::atomic<bool> planChanged; /**< A pool plan was compiled since the last round. */
+
+			bool allocationTracking; /**< Count allocations of modules and framework. */
+			bool allocationStrict; /**< Abort if the framework allocates in a steady-state round. */
+			unsigned int allocationWarmup; /**< Rounds until rounds are steady. */
+			unsigned long long steadyRound; /**< First steady-state round. */
+			Allocations masterAllocations; /**< Master thread allocations at the start of its round. */
+			std::string statsLine; /**< Statistics line of logStatistics (reused). */
+			std::atomic<SystemFlag> flag; /**< The active system flag used by master. */
+
+			FlightRecorder recorder; /**< Recorder of recent rounds. */
+			bool recorderJSON; /**< Dump recorder as JSON (or binary). */
+			std::string recorderFile; /**< File to dump recorder to. */
+			std::chrono::milliseconds stallThreshold; /**< Round duration that triggers a recorder dump (0 = off). */
+			std::unique_ptr<FlightRecorderDumper> stallDumper; /**< Dumps the recorder after slow rounds (if enabled). */
+			Watchdog watchdog; /**< Checks module time budgets. */
+			std::unique_ptr<StatsWriter> statsWriter; /**< Statistics page writer (if enabled). */
+			std::unique_ptr<BenchmarkRecorder> benchmarkRecorder; /**< Recorder of a running benchmark. */
 
 			Barrier barrier; /**< Pool synchronization barrier. */
 			std::unique_lock<std::mutex> masterLock; /**< Lock for masterController. */
 			std::thread controlThread; /**< Thread (if active) of masterController. */
+			std::atomic<bool> forked; /**< The master runs in controlThread (set before it starts). */
+			std::atomic<std::thread::id> masterThread; /**< Thread running an unforked masterController. */
 
 			unsigned long long round; /**< System round counter. */
+			bool roundStarted; /**< True if a round was started since the last round sync. */
 			bool shutdownRequested; /**< True if shutdown was requested. */
 			unsigned long long shutdownRound; /**< System shutdown round. */
 
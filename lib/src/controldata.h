@@ -2,14 +2,19 @@
 #define BVS_CONTROLDATA_H
 
 #include <atomic>
+#include <chrono>
+#include <condition_variable>
 #include <map>
 #include <memory>
+#include <mutex>
 #include <string>
 #include <thread>
 #include <vector>
 
 #include "bvs/connector.h"
+#include "bvs/info.h"
 #include "bvs/module.h"
+#include "perfcounters.h"
 
 
 
@@ -21,12 +26,20 @@ namespace BVS
 
 
 
+	/** Actions when a module exceeds its time budget, applied after execute() returns. */
+	enum class BudgetAction { LOG = 0, SKIP = 1, FAIL = 2, SHUTDOWN = 3 };
+
+
+
 	/** Library handle. */
 	using LibHandle = void*;
 
 
 
-	/** Module metadata. */
+	/** Module metadata.
+	 * Cold data only, everything a round reads or writes is kept in the
+	 * module's ModuleState (see ModuleTable), found by index.
+	 */
 	struct ModuleData
 	{
 		/** Creates Module MetaData.
@@ -37,13 +50,11 @@ namespace BVS
 		 * @param[in] module Pointer to the module.
 		 * @param[in] dlib Dlib handle to module's lib.
 		 * @param[in] poolName The pool name executing this module (if any).
-		 * @param[in] flag System control flag for module.
-		 * @param[in] status Return Status of module functions.
 		 * @param[in] connectors Connector map.
 		 */
 		ModuleData(std::string id, std::string library, std::string configuration,
 				std::string options, Module* module, LibHandle dlib,
-				std::string poolName, ControlFlag flag, Status status, ConnectorMap connectors)
+				std::string poolName, ConnectorMap connectors)
 			: id{id},
 			library{library},
 			configuration{configuration},
@@ -51,9 +62,11 @@ namespace BVS
 			module{module},
 			dlib{dlib},
 			poolName{poolName},
-			flag{flag},
-			status{status},
-			connectors{connectors}
+			connectors{connectors},
+			index{-1},
+			libraryDuration{0},
+			constructorDuration{0},
+			arena{}
 		{}
 
 		std::string id; /**< Name of module. */
@@ -63,9 +76,11 @@ namespace BVS
 		std::shared_ptr<Module> module; /**< Pointer to the module. */
 		LibHandle dlib; /**< Dlib handle to module's lib. */
 		std::string poolName; /** The pool name executing this module (if any). */
-		std::atomic<ControlFlag> flag; /**< System control flag for module. */
-		Status status; /**< Return Status of module functions. */
 		ConnectorMap connectors; /**< Connector map. */
+		int index; /**< Index of the module's state in the module table (-1 if not started). */
+		std::chrono::nanoseconds libraryDuration; /**< Time to open the module's library. */
+		std::chrono::nanoseconds constructorDuration; /**< Time to construct the module. */
+		std::unique_ptr<Arena> arena; /**< Arena of the module (see ModuleInfo::arena). */
 
 		ModuleData(const ModuleData&) = delete; /**< -Weffc++ */
 		ModuleData& operator=(const ModuleData&) = delete; /**< -Weffc++ */
@@ -73,6 +88,135 @@ namespace BVS
 
 
 
+	/** Hot state of a module, read and written every round. */
+	struct ModuleState
+	{
+		/** Creates an unused module state. */
+		ModuleState()
+			: flag{ControlFlag::QUIT},
+			status{Status::OK},
+			module{nullptr},
+			arena{nullptr},
+			duration{0},
+			cpuDuration{0},
+			executedRound{~0ull},
+			recorderSlot{-1},
+			skipNext{false},
+			budget{0},
+			budgetAction{BudgetAction::LOG},
+			executionStart{0},
+			nativeThread{},
+			overrun{false}
+		{}
+
+		std::atomic<ControlFlag> flag; /**< System control flag for module. */
+		Status status; /**< Return Status of module functions. */
+		Module* module; /**< Module to execute (owned by ModuleData). */
+		Arena* arena; /**< Arena reset after each execution (owned by ModuleData, nullptr if none). */
+		std::chrono::nanoseconds duration; /**< Wall time of last execution. */
+		std::chrono::nanoseconds cpuDuration; /**< Cpu time of last execution. */
+		unsigned long long executedRound; /**< Round of the last execute() call (~0 if none). */
+		int recorderSlot; /**< Slot in flight recorder (-1 if not recorded). */
+		bool skipNext; /**< Skip next execution (budget action). */
+		std::chrono::milliseconds budget; /**< Execution time budget (0 = none). */
+		BudgetAction budgetAction; /**< Action when budget is exceeded. */
+		std::atomic<long long> executionStart; /**< Start of running execution (steady clock ns, 0 if none). */
+		std::thread::native_handle_type nativeThread; /**< Thread of running execution. */
+		std::atomic<bool> overrun; /**< Running execution exceeded its budget. */
+
+		ModuleState(const ModuleState&) = delete; /**< -Weffc++ */
+		ModuleState& operator=(const ModuleState&) = delete; /**< -Weffc++ */
+	};
+
+
+
+	/** Module table, the hot states of all modules in one contiguous array.
+	 * A state is found by its index (ModuleData::index). The capacity is
+	 * fixed, so states never move and pools, watchdog and statistics refer
+	 * to them by index alone. Indices are assigned when a module starts and
+	 * released once no published plan refers to them anymore (guarded by
+	 * Control::planMutex).
+	 */
+	class ModuleTable
+	{
+		public:
+			/** Create table, allocates all states up front.
+			 * @param[in] capacity Maximum number of modules.
+			 */
+			ModuleTable(unsigned int capacity)
+				: states{new ModuleState[capacity]},
+				freeIndices{}
+			{
+				freeIndices.reserve(capacity);
+				for (unsigned int i=capacity; i>0; i--) freeIndices.push_back(i-1);
+			}
+
+			/** Assign a state to a module.
+			 * @param[in] module Module to execute.
+			 * @param[in] arena Arena of the module (nullptr if none).
+			 * @return Index of the state or -1 if the table is full.
+			 */
+			int acquire(Module* module, Arena* arena)
+			{
+				if (freeIndices.empty()) return -1;
+				int index = freeIndices.back();
+				freeIndices.pop_back();
+
+				ModuleState& state = states[index];
+				state.flag = ControlFlag::WAIT;
+				state.status = Status::OK;
+				state.module = module;
+				state.arena = arena;
+				state.duration = std::chrono::nanoseconds{0};
+				state.cpuDuration = std::chrono::nanoseconds{0};
+				state.executedRound = ~0ull;
+				state.recorderSlot = -1;
+				state.skipNext = false;
+				state.budget = std::chrono::milliseconds{0};
+				state.budgetAction = BudgetAction::LOG;
+				state.executionStart = 0;
+				state.overrun = false;
+
+				return index;
+			}
+
+			/** Release a state, it must not be referred to anymore.
+			 * @param[in] index Index returned by acquire() (ignored if negative).
+			 * @return Reference to object.
+			 */
+			ModuleTable& release(int index)
+			{
+				if (index<0) return *this;
+				states[index].flag = ControlFlag::QUIT;
+				states[index].module = nullptr;
+				states[index].arena = nullptr;
+				freeIndices.push_back(index);
+
+				return *this;
+			}
+
+			/** Access a state.
+			 * @param[in] index Index returned by acquire().
+			 * @return Module state.
+			 */
+			ModuleState& operator[](int index) { return states[index]; }
+
+			/** Access a state.
+			 * @param[in] index Index returned by acquire().
+			 * @return Module state.
+			 */
+			const ModuleState& operator[](int index) const { return states[index]; }
+
+		private:
+			std::unique_ptr<ModuleState[]> states; /**< Module states. */
+			std::vector<int> freeIndices; /**< Unused indices (reserved for all states). */
+
+			ModuleTable(const ModuleTable&) = delete; /**< -Weffc++ */
+			ModuleTable& operator=(const ModuleTable&) = delete; /**< -Weffc++ */
+	};
+
+
+
 	/** Module Map. */
 	using ModuleDataMap = std::map<std::string, std::shared_ptr<ModuleData>, std::less<std::string>>;
 
@@ -84,7 +228,39 @@ namespace BVS
 
 
 
-	/** Pool metadata. */
+	/** Entry of a pool's execution plan.
+	 * Refers to the module's state in the module table by index and to its
+	 * statistics slots in Info (map nodes never move), so executing a round
+	 * needs no map lookups and never touches the cold metadata.
+	 */
+	struct ModuleRecord
+	{
+		int index; /**< Index of the module state in the module table. */
+		std::shared_ptr<ModuleData> data; /**< Cold module metadata (kept alive while a plan refers to it). */
+		std::chrono::duration<unsigned int, std::milli>* duration; /**< Slot in Info::moduleDurations. */
+		std::chrono::duration<unsigned int, std::milli>* cpuDuration; /**< Slot in Info::moduleCPUDurations. */
+		ContextSwitches* contextSwitches; /**< Slot in Info::moduleContextSwitches. */
+		std::vector<unsigned long long>* perfCounters; /**< Slot in Info::modulePerfCounters. */
+		std::vector<unsigned long long>* perfCounterTotals; /**< Slot in Info::modulePerfCounterTotals. */
+		Allocations* allocations; /**< Slot in Info::moduleAllocations. */
+	};
+
+
+
+	/** Execution plan of a pool, modules in execution order. */
+	using ModuleRecordVector = std::vector<ModuleRecord>;
+
+	/** Compiled execution plan, never changed once published. */
+	using ModulePlan = std::shared_ptr<const ModuleRecordVector>;
+
+
+
+	/** Pool metadata.
+	 * A pool is active while it executes its modules. Its module vector may
+	 * only be changed while holding the pool mutex and the pool is inactive,
+	 * a pool cannot become active while the mutex is held by someone else.
+	 * Changes compile a new plan, the master publishes it between rounds.
+	 */
 	struct PoolData
 	{
 		/** Creates pool metadata.
@@ -95,7 +271,22 @@ namespace BVS
 			: poolName{poolName},
 			flag{flag},
 			thread{},
-			modules{}
+			modules{},
+			plan{std::make_shared<ModuleRecordVector>()},
+			compiledPlan{plan},
+			duration{nullptr},
+			idleDuration{nullptr},
+			utilization{nullptr},
+			allocations{0, 0},
+			mutex{},
+			stateChanged{},
+			active{false},
+			done{false},
+			busy{0},
+			round{0},
+			perfCounters{},
+			perfBefore{0, 0, {}},
+			perfAfter{0, 0, {}}
 		{}
 
 		/** Desctructor. */
@@ -105,9 +296,27 @@ namespace BVS
 		}
 
 		std::string poolName; /**< Pool name. */
-		ControlFlag flag; /**< System control flag for pool. */
+		std::atomic<ControlFlag> flag; /**< System control flag for pool. */
 		std::thread thread; /**< Pool thread handle. */
 		ModuleDataVector modules; /**< Pool module vector. */
+		ModulePlan plan; /**< Published execution plan (std::atomic_load/std::atomic_store, written by master). */
+		ModulePlan compiledPlan; /**< Plan compiled from modules, not yet published (guarded by Control::planMutex). */
+		std::chrono::duration<unsigned int, std::milli>* duration; /**< Slot in Info::poolDurations. */
+		std::chrono::duration<unsigned int, std::milli>* idleDuration; /**< Slot in Info::poolIdleDurations. */
+		double* utilization; /**< Slot in Info::poolUtilization. */
+		Allocations allocations; /**< Framework allocations of the pool thread in last round. */
+		std::mutex mutex; /**< Guards active state and module vector. */
+		std::condition_variable stateChanged; /**< Notified when the pool becomes inactive. */
+		bool active; /**< True while the pool executes its modules. */
+		std::atomic<bool> done; /**< True once the pool thread left its loop (can be joined). */
+		std::chrono::nanoseconds busy; /**< Time spent executing modules in last round. */
+		unsigned long long round; /**< Round the pool last executed. */
+		std::unique_ptr<PerfCounters> perfCounters; /**< Performance counters of pool thread (if any). */
+		PerfCounters::Reading perfBefore; /**< Counter reading before module execution. */
+		PerfCounters::Reading perfAfter; /**< Counter reading after module execution. */
+
+		PoolData(const PoolData&) = delete; /**< -Weffc++ */
+		PoolData& operator=(const PoolData&) = delete; /**< -Weffc++ */
 	};
 
 
@@ -115,6 +324,9 @@ namespace BVS
 	/** Module Pool Map. */
 	typedef std::map<std::string, std::shared_ptr<PoolData>> PoolMap;
 
+	/** Pools of a round, master pool first. */
+	using PoolPlan = std::vector<std::shared_ptr<PoolData>>;
+
 
 
 } // namespace BVS
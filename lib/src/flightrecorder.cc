@@ -0,0 +1,378 @@
+#include <algorithm>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "flightrecorder.h"
+#include "bvs/utils.h"
+
+using BVS::FlightRecorder;
+using BVS::FlightRecorderDumper;
+
+
+
+/** Minimal buffered writer, only uses write(2) so it is usable in signal handlers. */
+class DumpWriter
+{
+	public:
+		/** Create writer.
+		 * @param[in] fd File descriptor to write to.
+		 */
+		DumpWriter(int fd) : fd{fd}, size{0}, ok{true}, buffer{} {}
+
+		/** Append string. */
+		DumpWriter& operator<<(const char* s)
+		{
+			while (*s) put(*s++);
+			return *this;
+		}
+
+		/** Append number. */
+		DumpWriter& operator<<(unsigned long long n)
+		{
+			char digits[24];
+			int i = 0;
+			do { digits[i++] = '0' + n%10; n /= 10; } while (n);
+			while (i) put(digits[--i]);
+			return *this;
+		}
+
+		/** Append quoted string, escapes quotes, backslashes and control characters. */
+		DumpWriter& quote(const char* s)
+		{
+			static const char hex[] = "0123456789abcdef";
+			put('"');
+			for (; *s; s++) {
+				if (*s=='"' || *s=='\\') { put('\\'); put(*s); }
+				else if (*s=='\n') *this << "\\n";
+				else if (*s=='\t') *this << "\\t";
+				else if (static_cast<unsigned char>(*s)<0x20) { *this << "\\u00"; put(hex[*s>>4]); put(hex[*s&0xf]); }
+				else put(*s);
+			}
+			put('"');
+			return *this;
+		}
+
+		/** Write remaining buffer content.
+		 * @return True if everything was written.
+		 */
+		bool flush()
+		{
+			const char* data = buffer;
+			while (ok && size>0) {
+				ssize_t written = write(fd, data, size);
+				if (written<=0) ok = false;
+				else { data += written; size -= written; }
+			}
+			size = 0;
+			return ok;
+		}
+
+	private:
+		/** Append a character. */
+		void put(char c)
+		{
+			if (size==sizeof(buffer)) flush();
+			buffer[size++] = c;
+		}
+
+		int fd; /**< File descriptor. */
+		size_t size; /**< Used buffer size. */
+		bool ok; /**< False after a write error. */
+		char buffer[4096]; /**< Write buffer. */
+};
+
+
+
+/** Convert status to string (no allocation). */
+static const char* statusName(int status)
+{
+	switch (static_cast<BVS::Status>(status))
+	{
+		case BVS::Status::OK: return "OK";
+		case BVS::Status::NOINPUT: return "NOINPUT";
+		case BVS::Status::FAIL: return "FAIL";
+		case BVS::Status::WAIT: return "WAIT";
+		case BVS::Status::DONE: return "DONE";
+		case BVS::Status::SHUTDOWN: return "SHUTDOWN";
+	}
+	return "UNKNOWN";
+}
+
+
+
+FlightRecorder::FlightRecorder(unsigned int rounds, unsigned int modules, unsigned int connectors)
+	: rounds{rounds},
+	modules{modules},
+	connectors{connectors},
+	next{0},
+	mutex{},
+	moduleNames(modules*nameLength, '\0'),
+	connectorNames(connectors*nameLength, '\0'),
+	connectorOwners(connectors, -1),
+	connectorData(connectors),
+	roundRecords(rounds, RoundRecord{~0ull, 0, 0}),
+	moduleRecords(rounds*modules, ModuleRecord{~0ull, 0, 0, 0, 0}),
+	sequences(rounds*connectors, 0)
+{ }
+
+
+
+int FlightRecorder::addModule(const std::string& id, const ConnectorMap& moduleConnectors)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+
+	int slot = -1;
+	for (unsigned int i=0; i<modules && slot<0; i++)
+		if (moduleNames[i*nameLength]=='\0') slot = i;
+	if (slot<0) return slot;
+	strncpy(&moduleNames[slot*nameLength], id.c_str(), nameLength-1);
+
+	unsigned int c = 0;
+	for (auto& connector: moduleConnectors) {
+		if (connector.second->type!=ConnectorType::OUTPUT) continue;
+		while (c<connectors && connectorOwners[c]>=0) c++;
+		if (c==connectors) break;
+		connectorOwners[c] = slot;
+		connectorData[c] = connector.second;
+		strncpy(&connectorNames[c*nameLength], (id + "." + connector.first).c_str(), nameLength-1);
+	}
+
+	return slot;
+}
+
+
+
+FlightRecorder& FlightRecorder::removeModule(int slot)
+{
+	if (slot<0) return *this;
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	moduleNames[slot*nameLength] = '\0';
+	for (unsigned int c=0; c<connectors; c++) {
+		if (connectorOwners[c]!=slot) continue;
+		connectorOwners[c] = -1;
+		connectorData[c].reset();
+		connectorNames[c*nameLength] = '\0';
+	}
+
+	return *this;
+}
+
+
+
+void FlightRecorder::recordRound(unsigned long long round, std::chrono::nanoseconds duration)
+{
+	if (rounds==0) return;
+
+	std::lock_guard<std::mutex> lock{mutex};
+
+	unsigned long long slot = round%rounds;
+	roundRecords[slot].round = round;
+	roundRecords[slot].timestamp = std::chrono::duration_cast<std::chrono::microseconds>
+		(std::chrono::system_clock::now().time_since_epoch()).count();
+	roundRecords[slot].duration = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+
+	for (unsigned int c=0; c<connectors; c++)
+		sequences[slot*connectors + c] = connectorData[c] ? connectorData[c]->statistics.sends.load(std::memory_order_relaxed) : 0;
+
+	next = (slot+1)%rounds;
+}
+
+
+
+bool FlightRecorder::dump(const char* file, bool json) const
+{
+	int fd = open(file, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+	if (fd<0) return false;
+
+	bool ok = json ? dumpJSON(fd) : dumpBinary(fd);
+	close(fd);
+
+	return ok;
+}
+
+
+
+bool FlightRecorder::copy(const FlightRecorder& other)
+{
+	if (other.rounds!=rounds || other.modules!=modules || other.connectors!=connectors) return false;
+
+	std::lock(mutex, other.mutex);
+	std::lock_guard<std::mutex> lock{mutex, std::adopt_lock};
+	std::lock_guard<std::mutex> otherLock{other.mutex, std::adopt_lock};
+
+	// element wise, so no memory is allocated (connector data is not needed for dumping)
+	next = other.next;
+	std::copy(other.moduleNames.begin(), other.moduleNames.end(), moduleNames.begin());
+	std::copy(other.connectorNames.begin(), other.connectorNames.end(), connectorNames.begin());
+	std::copy(other.connectorOwners.begin(), other.connectorOwners.end(), connectorOwners.begin());
+	std::copy(other.roundRecords.begin(), other.roundRecords.end(), roundRecords.begin());
+	std::copy(other.moduleRecords.begin(), other.moduleRecords.end(), moduleRecords.begin());
+	std::copy(other.sequences.begin(), other.sequences.end(), sequences.begin());
+
+	return true;
+}
+
+
+
+bool FlightRecorder::dumpJSON(int fd) const
+{
+	DumpWriter out{fd};
+	out << "{\"version\":1,\"rounds\":[";
+
+	// oldest to newest round
+	bool firstRound = true;
+	for (unsigned int i=0; i<rounds; i++) {
+		unsigned long long slot = (next+i)%rounds;
+		const RoundRecord& round = roundRecords[slot];
+		if (round.round==~0ull) continue;
+
+		out << (firstRound ? "\n" : ",\n") << "{\"round\":" << round.round
+			<< ",\"timestamp_us\":" << round.timestamp
+			<< ",\"duration_us\":" << round.duration << ",\"modules\":{";
+		firstRound = false;
+
+		bool first = true;
+		for (unsigned int m=0; m<modules; m++) {
+			const ModuleRecord& module = moduleRecords[slot*modules + m];
+			if (moduleNames[m*nameLength]=='\0' || module.round!=round.round) continue;
+			out << (first ? "" : ",");
+			out.quote(&moduleNames[m*nameLength]);
+			out << ":{\"duration_us\":" << static_cast<unsigned long long>(module.duration)
+				<< ",\"cpu_us\":" << static_cast<unsigned long long>(module.cpuDuration)
+				<< ",\"status\":\"" << statusName(module.status) << "\"}";
+			first = false;
+		}
+
+		out << "},\"connectors\":{";
+		first = true;
+		for (unsigned int c=0; c<connectors; c++) {
+			if (connectorOwners[c]<0) continue;
+			out << (first ? "" : ",");
+			out.quote(&connectorNames[c*nameLength]);
+			out << ":" << sequences[slot*connectors + c];
+			first = false;
+		}
+		out << "}}";
+	}
+
+	out << "\n]}\n";
+
+	return out.flush();
+}
+
+
+
+bool FlightRecorder::dumpBinary(int fd) const
+{
+	FileHeader header;
+	memset(&header, 0, sizeof(header));
+	memcpy(header.magic, "BVSFR", 5);
+	header.version = 1;
+	header.rounds = rounds;
+	header.modules = modules;
+	header.connectors = connectors;
+	header.next = next;
+
+	auto writeAll = [fd](const void* data, size_t size) {
+		const char* p = static_cast<const char*>(data);
+		while (size>0) {
+			ssize_t written = write(fd, p, size);
+			if (written<=0) return false;
+			p += written;
+			size -= written;
+		}
+		return true;
+	};
+
+	return writeAll(&header, sizeof(header))
+		&& writeAll(moduleNames.data(), moduleNames.size())
+		&& writeAll(connectorNames.data(), connectorNames.size())
+		&& writeAll(roundRecords.data(), roundRecords.size()*sizeof(RoundRecord))
+		&& writeAll(moduleRecords.data(), moduleRecords.size()*sizeof(ModuleRecord))
+		&& writeAll(sequences.data(), sequences.size()*sizeof(unsigned long long));
+}
+FlightRecorderDumper::FlightRecorderDumper(const FlightRecorder& recorder, std::string file, bool json, std::chrono::milliseconds interval)
+	: recorder(recorder),
+	snapshot{recorder.rounds, recorder.modules, recorder.connectors},
+	file{file},
+	json{json},
+	interval{interval},
+	last{},
+	first{true},
+	pending{false},
+	running{true},
+	ok{true},
+	mutex{},
+	condition{},
+	thread{}
+{
+	thread = std::thread{&FlightRecorderDumper::run, this};
+}
+
+
+
+FlightRecorderDumper::~FlightRecorderDumper()
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		running = false;
+	}
+	condition.notify_all();
+	if (thread.joinable()) thread.join();
+}
+
+
+
+bool FlightRecorderDumper::request()
+{
+	auto now = std::chrono::steady_clock::now();
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		if (pending || (!first && now-last<interval)) return false;
+		// the thread only touches the snapshot while pending
+		snapshot.copy(recorder);
+		pending = true;
+		first = false;
+		last = now;
+	}
+	condition.notify_all();
+
+	return true;
+}
+
+
+
+bool FlightRecorderDumper::wait()
+{
+	std::unique_lock<std::mutex> lock{mutex};
+	condition.wait(lock, [&](){ return !pending; });
+
+	return ok;
+}
+
+
+
+void FlightRecorderDumper::run()
+{
+	nameThisThread("frdump");
+
+	std::unique_lock<std::mutex> lock{mutex};
+	while (true) {
+		condition.wait(lock, [&](){ return pending || !running; });
+		if (!pending) break;
+
+		lock.unlock();
+		bool dumped = snapshot.dump(file.c_str(), json);
+		lock.lock();
+
+		ok = dumped;
+		pending = false;
+		condition.notify_all();
+	}
+}
+
+
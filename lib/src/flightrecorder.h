@@ -0,0 +1,217 @@
+#ifndef BVS_FLIGHTRECORDER_H
+#define BVS_FLIGHTRECORDER_H
+
+#include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bvs/connectordata.h"
+#include "bvs/module.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Always-on recorder of the last rounds.
+	 * Keeps the timings and statuses of all modules as well as the sequence
+	 * numbers (number of sends) of all outputs for the last N rounds in a
+	 * preallocated ring buffer. Recording only stores a few values into
+	 * fixed slots, so it can stay enabled in production.
+	 *
+	 * The recording can be dumped as JSON or in a binary format (layout:
+	 * FileHeader, names of modules and connectors (each nameLength chars),
+	 * rounds*RoundRecord, rounds*modules*ModuleRecord,
+	 * rounds*connectors*sequence number (uint64)). Dumping only uses
+	 * open/write/close, so it can be used from signal handlers, e.g. on
+	 * SIGSEGV.
+	 */
+	class FlightRecorder
+	{
+		public:
+			/** Maximum name length (including '\0') of modules and connectors. */
+			static const unsigned int nameLength = 64;
+
+			/** Binary dump file header. */
+			struct FileHeader
+			{
+				char magic[8]; /**< "BVSFR\0\0\0". */
+				unsigned int version; /**< Format version. */
+				unsigned int rounds; /**< Number of round slots. */
+				unsigned int modules; /**< Number of module slots. */
+				unsigned int connectors; /**< Number of connector slots. */
+				unsigned long long next; /**< Round slot to be written next (oldest round). */
+			};
+
+			/** Round record. */
+			struct RoundRecord
+			{
+				unsigned long long round; /**< Round number (~0 if slot unused). */
+				unsigned long long timestamp; /**< System clock at the end of the round in us. */
+				unsigned long long duration; /**< Round duration in us. */
+			};
+
+			/** Module record. */
+			struct ModuleRecord
+			{
+				unsigned long long round; /**< Round number (~0 if slot unused). */
+				unsigned int duration; /**< Wall time in us. */
+				unsigned int cpuDuration; /**< Cpu time in us. */
+				int status; /**< Module status, see Status. */
+				int reserved; /**< Padding. */
+			};
+
+			/** Create recorder, allocates all memory up front.
+			 * @param[in] rounds Number of rounds to keep.
+			 * @param[in] modules Maximum number of modules.
+			 * @param[in] connectors Maximum number of output connectors.
+			 */
+			FlightRecorder(unsigned int rounds, unsigned int modules, unsigned int connectors);
+
+			/** Add a module and its outputs.
+			 * @param[in] id Module id.
+			 * @param[in] connectors Module connectors (only outputs are recorded).
+			 * @return Module slot or -1 if all slots are in use.
+			 */
+			int addModule(const std::string& id, const ConnectorMap& connectors);
+
+			/** Remove a module and its outputs.
+			 * @param[in] slot Module slot returned by addModule().
+			 * @return Reference to object.
+			 */
+			FlightRecorder& removeModule(int slot);
+
+			/** Record a module execution (called by pools).
+			 * @param[in] slot Module slot returned by addModule().
+			 * @param[in] round Round number.
+			 * @param[in] duration Wall time.
+			 * @param[in] cpuDuration Cpu time.
+			 * @param[in] status Module status.
+			 */
+			void recordModule(int slot, unsigned long long round, std::chrono::nanoseconds duration, std::chrono::nanoseconds cpuDuration, Status status)
+			{
+				if (slot<0 || rounds==0) return;
+				ModuleRecord& record = moduleRecords[(round%rounds)*modules + slot];
+				record.round = round;
+				record.duration = std::chrono::duration_cast<std::chrono::microseconds>(duration).count();
+				record.cpuDuration = std::chrono::duration_cast<std::chrono::microseconds>(cpuDuration).count();
+				record.status = static_cast<int>(status);
+			}
+
+			/** Record the end of a round (called by master after all pools finished).
+			 * @param[in] round Round number.
+			 * @param[in] duration Round duration.
+			 */
+			void recordRound(unsigned long long round, std::chrono::nanoseconds duration);
+
+			/** Dump recording to file.
+			 * @param[in] file File to dump to.
+			 * @param[in] json Dump as JSON instead of binary.
+			 * @return True on success.
+			 */
+			bool dump(const char* file, bool json) const;
+
+			/** Copy the recording of another recorder, does not allocate.
+			 * Modules must not record meanwhile (e.g. call it at round sync).
+			 * @param[in] other Recorder with the same number of slots.
+			 * @return False if the number of slots differs.
+			 */
+			bool copy(const FlightRecorder& other);
+
+		private:
+			/** Write JSON representation.
+			 * @param[in] fd File descriptor.
+			 * @return True on success.
+			 */
+			bool dumpJSON(int fd) const;
+
+			/** Write binary representation.
+			 * @param[in] fd File descriptor.
+			 * @return True on success.
+			 */
+			bool dumpBinary(int fd) const;
+
+			const unsigned int rounds; /**< Number of round slots. */
+			const unsigned int modules; /**< Number of module slots. */
+			const unsigned int connectors; /**< Number of connector slots. */
+			unsigned long long next; /**< Next round slot. */
+
+			mutable std::mutex mutex; /**< Protects slot assignment and round records. */
+			std::vector<char> moduleNames; /**< Module names, empty if slot unused. */
+			std::vector<char> connectorNames; /**< Connector names, empty if slot unused. */
+			std::vector<int> connectorOwners; /**< Module slot owning connector slot. */
+			std::vector<std::shared_ptr<ConnectorData>> connectorData; /**< Recorded outputs. */
+			std::vector<RoundRecord> roundRecords; /**< Round records. */
+			std::vector<ModuleRecord> moduleRecords; /**< Module records, rounds*modules. */
+			std::vector<unsigned long long> sequences; /**< Output sequence numbers, rounds*connectors. */
+
+			friend class FlightRecorderDumper;
+
+			FlightRecorder(const FlightRecorder&) = delete; /**< -Weffc++ */
+			FlightRecorder& operator=(const FlightRecorder&) = delete; /**< -Weffc++ */
+	};
+
+
+
+	/** Dumps a flight recorder from a background thread.
+	 * A request copies the recording into a preallocated snapshot, the
+	 * file is written by the dumper thread, so the requesting thread (the
+	 * master on a slow round) does no file I/O. Requests are rate limited,
+	 * requests within the interval of the last dump or while a dump is
+	 * being written are dropped.
+	 */
+	class FlightRecorderDumper
+	{
+		public:
+			/** Create dumper and start its thread.
+			 * @param[in] recorder Recorder to dump.
+			 * @param[in] file File to dump to.
+			 * @param[in] json Dump as JSON instead of binary.
+			 * @param[in] interval Minimal time between two dumps.
+			 */
+			FlightRecorderDumper(const FlightRecorder& recorder, std::string file, bool json, std::chrono::milliseconds interval);
+
+			/** Write pending dump and stop thread. */
+			~FlightRecorderDumper();
+
+			/** Request a dump, must not run concurrently with recording modules.
+			 * @return True if the dump was scheduled, false if it was dropped.
+			 */
+			bool request();
+
+			/** Wait until no dump is pending (or being written).
+			 * @return True if the last dump succeeded.
+			 */
+			bool wait();
+
+		private:
+			/** Dumper thread. */
+			void run();
+
+			const FlightRecorder& recorder; /**< Recorder to dump. */
+			FlightRecorder snapshot; /**< Copy of the recording to dump. */
+			std::string file; /**< File to dump to. */
+			bool json; /**< Dump as JSON. */
+			std::chrono::milliseconds interval; /**< Minimal time between two dumps. */
+			std::chrono::steady_clock::time_point last; /**< Time of the last accepted request. */
+			bool first; /**< No request accepted yet. */
+			bool pending; /**< Snapshot waits to be written. */
+			bool running; /**< Dumper thread should keep running. */
+			bool ok; /**< Last dump succeeded. */
+			std::mutex mutex; /**< Protects pending, running and ok. */
+			std::condition_variable condition; /**< Notified on requests and finished dumps. */
+			std::thread thread; /**< Dumper thread. */
+
+			FlightRecorderDumper(const FlightRecorderDumper&) = delete; /**< -Weffc++ */
+			FlightRecorderDumper& operator=(const FlightRecorderDumper&) = delete; /**< -Weffc++ */
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_FLIGHTRECORDER_H
+
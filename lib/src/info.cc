@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <limits>
 
 #include "bvs/info.h"
@@ -19,3 +20,37 @@ std::string BVS::Info::getFPS() const
 	return fps;
 }
 
+
+
+
+double BVS::Info::getIPC(const std::string& id) const
+{
+	auto totals = modulePerfCounterTotals.find(id);
+	if (totals==modulePerfCounterTotals.end()) return 0;
+
+	auto cycles = std::find(perfCounterEvents.begin(), perfCounterEvents.end(), "cycles");
+	auto instructions = std::find(perfCounterEvents.begin(), perfCounterEvents.end(), "instructions");
+	if (cycles==perfCounterEvents.end() || instructions==perfCounterEvents.end()) return 0;
+
+	double c = totals->second.at(cycles-perfCounterEvents.begin());
+	double i = totals->second.at(instructions-perfCounterEvents.begin());
+
+	return c==0 ? 0 : i/c;
+}
+
+
+
+double BVS::Info::getMissRate(const std::string& id, const std::string& event) const
+{
+	auto totals = modulePerfCounterTotals.find(id);
+	if (totals==modulePerfCounterTotals.end()) return 0;
+
+	auto misses = std::find(perfCounterEvents.begin(), perfCounterEvents.end(), event);
+	auto instructions = std::find(perfCounterEvents.begin(), perfCounterEvents.end(), "instructions");
+	if (misses==perfCounterEvents.end() || instructions==perfCounterEvents.end()) return 0;
+
+	double m = totals->second.at(misses-perfCounterEvents.begin());
+	double i = totals->second.at(instructions-perfCounterEvents.begin());
+
+	return i==0 ? 0 : 1000*m/i;
+}
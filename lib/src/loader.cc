@@ -1,7 +1,6 @@
 #include <dlfcn.h>
 
 #include <functional>
-#include <regex>
 #include <sstream>
 
 #include "loader.h"
@@ -17,13 +16,18 @@ ModuleDataMap Loader::modules;
 
 
 
+std::mutex Loader::modulesMutex;
+
+
+
 ModuleVector* Loader::hotSwapGraveYard = nullptr;
 
 
 
 Loader::Loader(const Info& info)
 	: logger{"Loader"},
-	info(info)
+	info(info),
+	connections{}
 { }
 
 
@@ -44,8 +48,9 @@ void Loader::registerModule(const std::string& id, Module* module, bool hotSwap)
 	}
 	else
 	{
+		std::lock_guard<std::mutex> lock{modulesMutex};
 		modules[id] = std::shared_ptr<ModuleData>{new ModuleData{id, {}, {}, {},
-			module, nullptr, {}, ControlFlag::WAIT, Status::OK, std::map<std::string, std::shared_ptr<ConnectorData>, std::less<std::string>>{}}};
+			module, nullptr, {}, std::map<std::string, std::shared_ptr<ConnectorData>, std::less<std::string>>{}}};
 	}
 }
 
@@ -53,8 +58,12 @@ void Loader::registerModule(const std::string& id, Module* module, bool hotSwap)
 
 Loader& Loader::load(const std::string& id, const std::string& library, const std::string& configuration, const std::string& options, const std::string& poolName)
 {
-	if (modules.find(id)!=modules.end())
-		LOG(0, "Duplicate id for module: " << id << std::endl << "If you try to load a module more than once, use unique ids and the id(library).options syntax!");
+	{
+		std::lock_guard<std::mutex> lock{modulesMutex};
+		if (modules.find(id)!=modules.end())
+			LOG(0, "Duplicate id for module: " << id << std::endl << "If you try to load a module more than once, use unique ids and the id(library).options syntax!");
+	}
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
 
 	std::string function = "bvsRegisterModule_" + library;
 	std::string tmpLibrary = library;
@@ -83,17 +92,26 @@ Loader& Loader::load(const std::string& id, const std::string& library, const st
 	if (dlerr && bvsRegisterModule==nullptr)
 		LOG(0, "Loading function " << function << " from '" << tmpLibrary << "' resulted in: " << dlerr);
 
-	ModuleInfo moduleInfo{id, configuration};
+	std::chrono::steady_clock::time_point loaded = std::chrono::steady_clock::now();
+	std::unique_ptr<Arena> arena{new Arena{1024*info.config.getValue<size_t>("BVS.arenaSize", bvs_arena_size)}};
+	ModuleInfo moduleInfo{id, configuration, arena.get()};
+	ConnectorDataCollector::connectors().clear();
 	bvsRegisterModule(moduleInfo, info);
 
-	modules[id]->configuration = configuration;
-	modules[id]->dlib = dlib;
-	modules[id]->library = tmpLibrary;
-	modules[id]->options = options;
-
-	// get connectors
-	modules[id]->connectors = std::move(ConnectorDataCollector::connectors);
-	modules[id]->poolName = poolName;
+	std::lock_guard<std::mutex> lock{modulesMutex};
+	ModuleData& data = *modules[id];
+	data.configuration = configuration;
+	data.dlib = dlib;
+	data.library = tmpLibrary;
+	data.options = options;
+	data.libraryDuration = loaded - start;
+	data.constructorDuration = std::chrono::steady_clock::now() - loaded;
+	data.arena = std::move(arena);
+
+	// get connectors registered by the module's constructor on this thread
+	data.connectors = std::move(ConnectorDataCollector::connectors());
+	ConnectorDataCollector::connectors().clear();
+	data.poolName = poolName;
 
 	LOG(2, "Loading '" << id << "' successfull!");
 
@@ -107,6 +125,9 @@ Loader& Loader::unload(const std::string& id)
 	disconnectModule(id);
 	modules[id]->connectors.clear();
 	modules[id]->module.reset();
+	if (modules[id]->arena && modules[id]->arena->highWaterMark())
+		LOG(2, "Arena of '" << id << "': high water mark " << modules[id]->arena->highWaterMark()
+				<< " bytes, capacity " << modules[id]->arena->capacity() << " bytes");
 	unloadLibrary(id);
 	modules.erase(id);
 
@@ -134,17 +155,20 @@ Loader& Loader::connectModule(const std::string& id, const bool connectorTypeMat
 	std::string input;
 	std::string targetModule;
 	std::string targetOutput;
-	std::regex regex("(.+?)\\((.+?)\\.(.+?)\\).*");
-	std::smatch match;
 
 	while (!options.empty()) {
-		// try to match 'input(targetModule.targetOutput).*'
-		std::regex_match(options, match, regex);
-		connection = match[0].str().empty() ? options : match[0];
-		if (match.size()!=4) LOG(0, "Error matching connector settings: " << connection);
-		input = match[1];
-		targetModule = match[2];
-		targetOutput = match[3];
+		// split 'input(targetModule.targetOutput).*'
+		size_t open = options.find('(');
+		size_t dot = open==std::string::npos ? open : options.find('.', open+1);
+		size_t close = dot==std::string::npos ? dot : options.find(')', dot+1);
+		if (close==std::string::npos || open==0 || dot==open+1 || close==dot+1) {
+			LOG(0, "Error matching connector settings: " << options);
+			break;
+		}
+		connection = options.substr(0, close+1);
+		input = options.substr(0, open);
+		targetModule = options.substr(open+1, dot-open-1);
+		targetOutput = options.substr(dot+1, close-dot-1);
 
 		// check input connector
 		std::function<void(const ModuleData*)> connectionError = [&](const ModuleData* data){
@@ -173,10 +197,11 @@ Loader& Loader::connectModule(const std::string& id, const bool connectorTypeMat
 		in->lock = std::unique_lock<std::mutex>{out->mutex, std::defer_lock};
 		in->pointer = out->pointer;
 		out->active = true;
+		connections.connect({module->id, input, in.get()}, {targetModule, targetOutput, out.get()});
 		LOG(2, "Connected: " << module->id << "." << input << " <- " << targetModule << "." << targetOutput);
 
 		// remove connection from option string
-		options.erase(0, options.find(")")+1);
+		options.erase(0, close+1);
 		if (options[0]=='.') options.erase(0, 1);
 	}
 
@@ -188,32 +213,24 @@ Loader& Loader::connectModule(const std::string& id, const bool connectorTypeMat
 Loader& Loader::disconnectModule(const std::string& id)
 {
 	for (auto& disconnect: modules[id]->connectors) {
-		if (!disconnect.second->active) continue;
-		switch (disconnect.second->type) {
+		ConnectorData* data = disconnect.second.get();
+		switch (data->type) {
 			case ConnectorType::INPUT:
 				{
-					bool onlyConnection = true;
-					std::shared_ptr<ConnectorData> origin;
-					for (auto& module: modules) {
-						for (auto& test: module.second->connectors) {
-							if (test.second->pointer==disconnect.second->pointer) {
-								if (test.second->type==ConnectorType::OUTPUT) origin = test.second;
-								if (test.second->type==ConnectorType::INPUT && &test!=&disconnect) onlyConnection = false;
-							}
-						}
-					}
-					if (onlyConnection && origin) origin->active = false;
+					// an output without consumers is inactive again
+					const ConnectionGraph::Endpoint* origin = connections.origin(data);
+					if (!origin) break;
+					ConnectorData* out = origin->data;
+					connections.disconnectInput(data);
+					if (connections.consumers(out).empty()) out->active = false;
 					break;
 				}
 			case ConnectorType::OUTPUT:
-				for (auto& module: modules) {
-					for (auto& targetConnector: module.second->connectors) {
-						if (disconnect.second->pointer==targetConnector.second->pointer) {
-							targetConnector.second->active = false;
-							targetConnector.second->pointer = nullptr;
-						}
-					}
+				for (auto& consumer: connections.consumers(data)) {
+					consumer.data->active = false;
+					consumer.data->pointer = nullptr;
 				}
+				connections.disconnectOutput(data);
 				break;
 			case ConnectorType::NOOP:
 				break;
@@ -226,6 +243,33 @@ Loader& Loader::disconnectModule(const std::string& id)
 
 
 
+Loader& Loader::logConnectorStatistics()
+{
+	auto milliseconds = [](const ConnectorStatistics& s) { return s.waitNanoseconds.load()/1000000.0; };
+
+	for (auto& module: modules) {
+		for (auto& connector: module.second->connectors) {
+			if (connector.second->type!=ConnectorType::INPUT || !connector.second->active) continue;
+			const ConnectionGraph::Endpoint* origin = connections.origin(connector.second.get());
+			if (!origin) continue;
+
+			const ConnectorStatistics& out = origin->data->statistics;
+			const ConnectorStatistics& in = connector.second->statistics;
+			LOG(2, "Connection " << module.first << "." << connector.first << " <- " << origin->module << "." << origin->connector
+					<< ": sends:" << out.sends.load()
+					<< " receives:" << in.receives.load()
+					<< " bytes(out/in):" << out.bytes.load() << "/" << in.bytes.load()
+					<< " locks(out/in):" << out.acquisitions.load() << "/" << in.acquisitions.load()
+					<< " contended(out/in):" << out.contended.load() << "/" << in.contended.load()
+					<< " wait(out/in):" << milliseconds(out) << "/" << milliseconds(in) << "ms");
+		}
+	}
+
+	return *this;
+}
+
+
+
 #ifdef BVS_MODULE_HOTSWAP
 Loader& Loader::hotSwapModule(const std::string& id)
 {
@@ -1,11 +1,13 @@
 #ifndef BVS_LOADER_H
 #define BVS_LOADER_H
 
+#include <mutex>
 #include <string>
 
 #include "bvs/config.h"
 #include "bvs/info.h"
 #include "bvs/logger.h"
+#include "connectiongraph.h"
 #include "controldata.h"
 
 
@@ -31,7 +33,8 @@ namespace BVS
 
 			/** Load the given module.
 			 * Executes bvsRegisterModule function in module to register it with the
-			 * system.
+			 * system. Several modules can be loaded concurrently, only the
+			 * module map is accessed under modulesMutex.
 			 * @param[in] id The module id to give to the new loaded module.
 			 * @param[in] library The library to load the module from.
 			 * @param[in] configuration The configuration to pass to the module.
@@ -66,12 +69,21 @@ namespace BVS
 
 			/** Disconnect selected module.
 			 * Disconnects the selected module by disconnecting its connectors one
-			 * by one.
+			 * by one, the connected peers are looked up in the connection graph.
 			 * @param[in] id Module id.
 			 * @return Reference to object.
 			 */
 			Loader& disconnectModule(const std::string& id);
 
+			/** Log traffic and contention statistics of all connections.
+			 * Logs one line per connection (input <- output) containing
+			 * sends, receives, transferred bytes, lock acquisitions,
+			 * contended acquisitions and the time spent waiting for the lock
+			 * for both the output and the input side.
+			 * @return Reference to object.
+			 */
+			Loader& logConnectorStatistics();
+
 #ifdef BVS_MODULE_HOTSWAP
 			/** HotSwap a module.
 			 * This will reload/hotswap an already existing module.
@@ -111,9 +123,17 @@ namespace BVS
 			 */
 			Loader& unloadLibrary(const std::string& id);
 
+			/** Get the connection graph.
+			 * @return All connections between module connectors.
+			 */
+			const ConnectionGraph& getConnections() const { return connections; }
+
 			/** Map of registered modules and their metadata. */
 			static ModuleDataMap modules;
 
+			/** Protects modules while modules are loaded concurrently. */
+			static std::mutex modulesMutex;
+
 		private:
 			/** Print Connector list.
 			 * Prints a list of all Connectors defined by given module.
@@ -125,6 +145,7 @@ namespace BVS
 			Logger logger; /**< Logger metadata. */
 			const Info& info; /**< Info reference. */
 			static ModuleVector* hotSwapGraveYard; /** GraveYard for hotswapped module pointers. */
+			ConnectionGraph connections; /**< Connections between module connectors. */
 
 			Loader(const Loader&) = delete; /**< -Weffc++ */
 			Loader& operator=(const Loader&) = delete; /**< -Weffc++ */
@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "logfilesink.h"
+
+using BVS::LogFileSink;
+
+
+
+LogFileSink::LogFileSink(const std::string& path, bool append, size_t maxSize, unsigned int segments)
+	: path{path}
+	, error{}
+	, maxSize{maxSize}
+	, segments{std::max(segments, 1u)}
+	, fd{-1}
+	, map{nullptr}
+	, capacity{0}
+	, used{0}
+	, synced{0}
+{
+	open(append);
+}
+
+
+
+LogFileSink::~LogFileSink()
+{
+	close();
+}
+
+
+
+bool LogFileSink::write(const char* data, size_t size)
+{
+	if (fd<0) return false;
+
+	if (maxSize && used && used+size > maxSize && !rotate()) return false;
+	if (used+size > capacity && !reserve(used+size)) return false;
+
+	memcpy(map+used, data, size);
+	used += size;
+
+	return true;
+}
+
+
+
+void LogFileSink::sync()
+{
+	if (!map || used==synced) return;
+
+	// msync needs a page aligned start
+	size_t page = sysconf(_SC_PAGESIZE);
+	size_t start = synced & ~(page-1);
+	msync(map+start, used-start, MS_ASYNC);
+	synced = used;
+}
+
+
+
+bool LogFileSink::open(bool append)
+{
+	fd = ::open(path.c_str(), O_RDWR | O_CREAT | (append ? 0 : O_TRUNC), 0644);
+	if (fd<0) return fail("open");
+
+	struct stat status;
+	if (fstat(fd, &status)!=0) return fail("stat");
+	used = status.st_size;
+	synced = used;
+	if (!used) return reserve(0);
+
+	// skip zero bytes left by a process that did not close the file
+	if (!reserve(used)) return false;
+	while (used && map[used-1]=='\0') used--;
+	synced = used;
+
+	return true;
+}
+
+
+
+void LogFileSink::close()
+{
+	if (fd<0) return;
+
+	sync();
+	if (map) munmap(map, capacity);
+	if (ftruncate(fd, used)!=0 && error.empty())
+		error = "could not truncate log file '" + path + "': " + strerror(errno);
+	::close(fd);
+
+	fd = -1;
+	map = nullptr;
+	capacity = 0;
+}
+
+
+
+bool LogFileSink::reserve(size_t size)
+{
+	size_t target = maxSize ? std::max(maxSize, size) : (size/growthSize+1)*growthSize;
+	if (target<=capacity && map) return true;
+
+	sync();
+	if (map) munmap(map, capacity);
+	map = nullptr;
+	capacity = 0;
+
+	// allocate the blocks, writing to a sparse mapping on a full disk raises SIGBUS
+	int result = posix_fallocate(fd, 0, target);
+	if (result!=0) {
+		errno = result;
+		return fail("allocate space for");
+	}
+	void* file = mmap(nullptr, target, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if (file==MAP_FAILED) return fail("map");
+	map = static_cast<char*>(file);
+	capacity = target;
+
+	return true;
+}
+
+
+
+bool LogFileSink::rotate()
+{
+	close();
+
+	// shift old segments, the oldest one gets overwritten
+	for (unsigned int i=segments-1; i>0; i--) {
+		std::string from = i==1 ? path : path + '.' + std::to_string(i-1);
+		std::string to = path + '.' + std::to_string(i);
+		if (std::rename(from.c_str(), to.c_str())!=0 && errno!=ENOENT) return fail("rotate");
+	}
+
+	used = 0;
+	synced = 0;
+	return open(false);
+}
+
+
+
+bool LogFileSink::fail(const std::string& action)
+{
+	error = "could not " + action + " log file '" + path + "': " + strerror(errno);
+	if (map) munmap(map, capacity);
+	if (fd>=0) ::close(fd);
+
+	fd = -1;
+	map = nullptr;
+	capacity = 0;
+
+	return false;
+}
+
@@ -0,0 +1,110 @@
+#ifndef BVS_LOGFILESINK_H
+#define BVS_LOGFILESINK_H
+
+#include <cstddef>
+#include <string>
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Writes the text log file through memory-mapped segments.
+	 * Messages are copied into a preallocated, shared mapping of the file,
+	 * so writing never blocks on the file system. Space is allocated with
+	 * posix_fallocate() before it is mapped, if that fails (e.g. full disk)
+	 * the file is closed with an error instead of faulting on a later write. Written pages are handed
+	 * to the kernel with msync(MS_ASYNC) whenever a segment is remapped or
+	 * rotated and on sync().
+	 *
+	 * With a maximum size, every segment is preallocated to that size and
+	 * rotated once full: 'file' becomes 'file.1', 'file.1' becomes 'file.2'
+	 * and so on, keeping at most the given number of segments (including the
+	 * active one). Without a maximum size, the file grows in steps of
+	 * growthSize. The active segment is truncated to its used size whenever
+	 * it is closed, until then its unused rest reads as zero bytes.
+	 *
+	 * Not thread safe, the LogSystem serializes all calls.
+	 */
+	class LogFileSink
+	{
+		public:
+			/** Open log file.
+			 * @param[in] path File path.
+			 * @param[in] append Continue existing file instead of overwriting it.
+			 * @param[in] maxSize Segment size in bytes (0 disables rotation).
+			 * @param[in] segments Number of segments to keep (including the active one).
+			 */
+			LogFileSink(const std::string& path, bool append, size_t maxSize, unsigned int segments);
+
+			/** Sync, unmap and truncate log file. */
+			~LogFileSink();
+
+			/** Append data, rotating and growing the file as needed.
+			 * @param[in] data Data to append.
+			 * @param[in] size Size of data.
+			 * @return False if the file failed (see getError()), it is closed then.
+			 */
+			bool write(const char* data, size_t size);
+
+			/** Schedule writeback of all written pages (does not wait). */
+			void sync();
+
+			/** Error message if the log file failed.
+			 * @return Error message (empty on success).
+			 */
+			const std::string& getError() const { return error; }
+
+			/** Path of the log file.
+			 * @return File path.
+			 */
+			const std::string& getPath() const { return path; }
+
+			static const size_t growthSize = 1<<20; /**< Growth step without maximum size. */
+
+		private:
+			/** Open and map the active segment.
+			 * @param[in] append Continue existing content.
+			 * @return False on error.
+			 */
+			bool open(bool append);
+
+			/** Sync, unmap and truncate the active segment. */
+			void close();
+
+			/** Grow the mapping so that it holds at least the given size.
+			 * @param[in] size Required size in bytes.
+			 * @return False on error.
+			 */
+			bool reserve(size_t size);
+
+			/** Close the active segment, shift old segments and open a new one.
+			 * @return False on error.
+			 */
+			bool rotate();
+
+			/** Set error message and close file.
+			 * @param[in] action Failed action.
+			 * @return Always false.
+			 */
+			bool fail(const std::string& action);
+
+			std::string path; /**< File path. */
+			std::string error; /**< Error message, empty if open. */
+			size_t maxSize; /**< Segment size (0 disables rotation). */
+			unsigned int segments; /**< Number of segments to keep. */
+			int fd; /**< File descriptor of the active segment. */
+			char* map; /**< Mapped active segment (nullptr if not mapped). */
+			size_t capacity; /**< Mapped size. */
+			size_t used; /**< Written bytes. */
+			size_t synced; /**< Bytes already handed to msync. */
+
+			LogFileSink(const LogFileSink&) = delete; /**< -Weffc++ */
+			LogFileSink& operator=(const LogFileSink&) = delete; /**< -Weffc++ */
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_LOGFILESINK_H
+
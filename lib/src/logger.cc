@@ -1,18 +1,37 @@
+#include <chrono>
+
 #include "bvs/logger.h"
 
 #ifdef BVS_LOG_SYSTEM
 #include "logsystem.h"
 #endif
 
+using BVS::LogRecord;
+using BVS::LogSite;
 using BVS::Logger;
 
 
 
+std::atomic<unsigned short> Logger::systemVerbosity{bvs_log_system_verbosity};
+std::atomic<bool> Logger::binaryFormat{false};
+std::atomic<unsigned long long> Logger::round{0};
+
+
+
+namespace
+{
+	thread_local LogRecord threadRecord; /**< Binary log record of the calling thread. */
+}
+
+
+
 Logger::Logger(const std::string& name, unsigned short verbosity, LogTarget target, std::function<void()> errorHandler)
 	: name{name}
-	, verbosity{std::make_shared<unsigned short>(verbosity)}
+	, verbosity{std::make_shared<std::atomic<unsigned short>>(verbosity)}
 	, target{target}
 	, errorHandler{errorHandler}
+	, limits{std::make_shared<Limits>()}
+	, binaryId{0}
 #ifdef BVS_LOG_SYSTEM
 	, logSystem{LogSystem::connectToLogSystem()}
 #endif
@@ -24,6 +43,15 @@ Logger::Logger(const std::string& name, unsigned short verbosity, LogTarget targ
 
 
 
+Logger::~Logger()
+{
+#ifdef BVS_LOG_SYSTEM
+	logSystem->retire(*this);
+#endif
+}
+
+
+
 std::ostream& Logger::out(const int level)
 {
 #ifdef BVS_LOG_SYSTEM
@@ -45,3 +73,53 @@ void Logger::endl(const int level)
 #endif
 }
 
+
+
+LogRecord& Logger::record()
+{
+	return threadRecord.clear();
+}
+
+
+
+void Logger::commit(LogSite& site, const int level)
+{
+#ifdef BVS_LOG_SYSTEM
+	logSystem->commit(*this, site, level, threadRecord);
+#else
+	(void) site;
+	(void) level;
+#endif
+}
+
+
+
+void Logger::endl(const int level, LogSite& site)
+{
+#ifdef BVS_LOG_SYSTEM
+	logSystem->endl(*this, level, &site);
+#else
+	(void) level;
+	(void) site;
+#endif
+}
+
+
+
+bool Logger::admitRate(LogSite& site)
+{
+	int64_t second = std::chrono::duration_cast<std::chrono::seconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+
+	// fixed one second windows, a racing reset only admits a few more messages
+	if (site.window.load(std::memory_order_relaxed)!=second) {
+		site.window.store(second, std::memory_order_relaxed);
+		site.count.store(0, std::memory_order_relaxed);
+	}
+
+	if (site.count.fetch_add(1, std::memory_order_relaxed) < limits->rateLimit.load(std::memory_order_relaxed))
+		return true;
+
+	site.suppressed.fetch_add(1, std::memory_order_relaxed);
+	return false;
+}
@@ -1,11 +1,167 @@
 #include <algorithm>
+#include <chrono>
+#include <cstring>
 #include <iomanip>
 
 #include "logsystem.h"
 #include "bvs/traits.h"
+#include "bvs/utils.h"
 
+using BVS::LogRing;
 using BVS::LogSystem;
 using BVS::NullStream;
+using BVS::RecordBuffer;
+
+
+
+namespace
+{
+	/** Per thread logging state, messages are formatted without locking. */
+	struct ThreadState
+	{
+		ThreadState() : buffer{}, stream{&buffer}, null{}, target{0}, active{false}, messageStart{0}, json{}, ring{}, writer{false} {}
+
+		/** Mark the thread's ring closed, so the writer removes it once empty. */
+		~ThreadState() { if (ring) ring->closed = true; }
+
+		RecordBuffer buffer; /**< Message being formatted. */
+		std::ostream stream; /**< Stream writing to buffer. */
+		NullStream null; /**< Stream for filtered messages. */
+		uint8_t target; /**< Outputs of the message being formatted. */
+		bool active; /**< Whether a message is being formatted. */
+		size_t messageStart; /**< Start of the message text (after colors and prefix). */
+		std::string json; /**< Packed JSON record of the message. */
+		std::shared_ptr<LogRing> ring; /**< Ring of this thread (asynchronous mode). */
+		bool writer; /**< Whether this is the writer thread (must not wait for itself). */
+	};
+
+	thread_local ThreadState threadState;
+
+	/** Append a raw value to a packed record. */
+	template<typename T> void pack(std::string& record, T value)
+	{
+		record.append(reinterpret_cast<const char*>(&value), sizeof(value));
+	}
+
+	/** Append a string with 8 bit length to a packed record. */
+	void pack(std::string& record, const std::string& value)
+	{
+		uint8_t length = std::min<size_t>(value.size(), UINT8_MAX);
+		pack(record, length);
+		record.append(value, 0, length);
+	}
+
+	/** Read a raw value from a packed record. */
+	template<typename T> T unpack(const char*& position)
+	{
+		T value;
+		memcpy(&value, position, sizeof(value));
+		position += sizeof(value);
+		return value;
+	}
+
+	/** Append a string as quoted and escaped JSON string. */
+	void appendJSONString(std::string& out, const char* data, size_t size)
+	{
+		static const char hex[] = "0123456789abcdef";
+		out += '"';
+		for (size_t i=0; i<size; i++) {
+			char c = data[i];
+			if (c=='"' || c=='\\') { out += '\\'; out += c; }
+			else if (c=='\n') out += "\\n";
+			else if (c=='\t') out += "\\t";
+			else if (static_cast<unsigned char>(c)<0x20) { out += "\\u00"; out += hex[c>>4]; out += hex[c&0xf]; }
+			else out += c;
+		}
+		out += '"';
+	}
+}
+
+
+
+LogRing::LogRing(size_t capacity)
+	: closed{false}
+	, buffer{}
+	, mask{}
+	, head{0}
+	, tail{0}
+	, record{}
+{
+	size_t size = 256;
+	while (size<capacity) size <<= 1;
+	buffer.resize(size);
+	mask = size-1;
+}
+
+
+
+bool LogRing::push(const char* data, uint32_t size, uint8_t target)
+{
+	size_t h = head.load(std::memory_order_relaxed);
+	size_t t = tail.load(std::memory_order_acquire);
+	size_t needed = sizeof(size) + sizeof(target) + size;
+	if (buffer.size()-(h-t) < needed) return false;
+
+	write(h, &size, sizeof(size));
+	write(h+sizeof(size), &target, sizeof(target));
+	write(h+sizeof(size)+sizeof(target), data, size);
+	head.store(h+needed, std::memory_order_release);
+
+	return true;
+}
+
+
+
+size_t LogRing::drain(const std::function<void(uint8_t target, const char* data, size_t size)>& sink)
+{
+	size_t t = tail.load(std::memory_order_relaxed);
+	size_t h = head.load(std::memory_order_acquire);
+	size_t count = 0;
+
+	while (t!=h) {
+		uint32_t size;
+		uint8_t target;
+		read(t, &size, sizeof(size));
+		read(t+sizeof(size), &target, sizeof(target));
+		size_t position = (t+sizeof(size)+sizeof(target))&mask;
+
+		// pass record in place, copy only if it wraps around
+		if (position+size<=buffer.size()) {
+			sink(target, &buffer[position], size);
+		} else {
+			record.resize(size);
+			read(position, &record[0], size);
+			sink(target, record.data(), size);
+		}
+
+		t += sizeof(size) + sizeof(target) + size;
+		tail.store(t, std::memory_order_release);
+		count++;
+	}
+
+	return count;
+}
+
+
+
+void LogRing::write(size_t position, const void* data, size_t size)
+{
+	position &= mask;
+	size_t first = std::min(size, buffer.size()-position);
+	memcpy(&buffer[position], data, first);
+	memcpy(&buffer[0], static_cast<const char*>(data)+first, size-first);
+}
+
+
+
+void LogRing::read(size_t position, void* data, size_t size) const
+{
+	position &= mask;
+	size_t first = std::min(size, buffer.size()-position);
+	memcpy(data, &buffer[position], first);
+	memcpy(static_cast<char*>(data)+first, &buffer[0], size-first);
+}
+
 
 
 NullStream LogSystem::nullStream;
@@ -28,78 +184,206 @@ std::shared_ptr<LogSystem> LogSystem::connectToLogSystem()
 
 LogSystem::LogSystem()
 	: loggerLevels{}
+	, loggerLimits{}
 	, tmpName{}
 	, namePadding{0}
 	, logColors{}
-	, systemVerbosity{3}
+	, systemVerbosity(Logger::systemVerbosity)
 	, outMutex{}
 	, outCLI{std::clog.rdbuf()}
 	, outFile{}
-	, outBoth{outCLI, outFile}
+	, fileOpen{false}
+	, fileMaxSize{bvs_log_file_max_size<<20}
+	, fileSegments{bvs_log_file_segments}
+	, outJSON{}
+	, jsonOpen{false}
+	, async{false}
+	, bufferSize{bvs_log_buffer_size}
+	, overflow{Overflow::COUNT}
+	, rings{}
+	, ringsMutex{}
+	, drainMutex{}
+	, batchCLI{}
+	, batchFile{}
+	, batchJSON{}
+	, dropped{0}
+	, writerRunning{false}
+	, writerMutex{}
+	, writerCondition{}
+	, writerThread{}
+	, binaryLog{}
+	, pendingRepeats{}
+	, pendingMutex{}
+	, duplicates{false}
 {
 	// show bools as "true"/"false" instead of "0"/"1"
 	outCLI.setf(outCLI.boolalpha);
-	outFile.setf(outFile.boolalpha);
-	outBoth.setf(outBoth.boolalpha);
 }
 
 
 
-std::ostream& LogSystem::out(const Logger& logger, int level)
+LogSystem::~LogSystem()
 {
-	outMutex.lock();
+	stopWriter();
 
-	// convert name to lowercase
-	tmpName = logger.name;
-	std::transform(tmpName.begin(), tmpName.end(), tmpName.begin(), ::tolower);
+	Logger::binaryFormat = false;
+	if (binaryLog && binaryLog->getDropped()) {
+		std::string line = systemMessage("binary log '" + binaryLog->getPath() + "' was full, "
+				+ std::to_string(binaryLog->getDropped()) + " messages dropped");
+		write(line.data(), line.size(), OUT_CLI | OUT_FILE);
+	}
+}
 
-	// check verbosity of system and logger
-	if (level > systemVerbosity) return nullStream;
-	if (level > *(logger.verbosity)) return nullStream;
 
-	// select (enabled/open) output stream according to selected target
-	std::ostream* out;
+
+std::ostream& LogSystem::out(const Logger& logger, int level)
+{
+	ThreadState& state = threadState;
+	state.active = false;
+
+	// check verbosity of system and logger
+	if (level > systemVerbosity.load(std::memory_order_relaxed)) return state.null;
+	if (level > *(logger.verbosity)) return state.null;
+
+	// select (enabled/open) outputs according to selected target
+	bool cli = outCLI.rdbuf() != nullStream.rdbuf();
+	bool file = fileOpen.load(std::memory_order_relaxed);
+	bool json = jsonOpen.load(std::memory_order_relaxed);
+	uint8_t target = 0;
 	switch (logger.target)
 	{
 		case Logger::OFF:
-			out = &nullStream;
 			break;
 		case Logger::TO_CLI:
-			if (outCLI.rdbuf() != nullStream.rdbuf()) out = &outCLI;
-			else out = &nullStream;
+			if (cli) target = OUT_CLI;
 			break;
 		case Logger::TO_FILE:
-			if (outFile.is_open()) out = &outFile;
-			else out = &nullStream;
+			if (file) target = OUT_FILE;
 			break;
 		case Logger::TO_CLI_AND_FILE:
-			if (outFile.is_open() && outCLI.rdbuf() != nullStream.rdbuf()) out = &outBoth;
-			else if (outFile.is_open()) out = &outFile;
-			else if (outCLI.rdbuf() != nullStream.rdbuf()) out = &outCLI;
-			else out = &nullStream;
+			target = (cli ? OUT_CLI : 0) | (file ? OUT_FILE : 0);
 			break;
 	}
+	if (json && logger.target!=Logger::OFF) target |= OUT_JSON;
+	if (!target) return state.null;
+
+	// reset buffer and formatting of the previous message
+	state.target = target;
+	state.active = true;
+	state.buffer.record.clear();
+	std::ostream& out = state.stream;
+	out.clear();
+	out.flags(std::ios_base::boolalpha | std::ios_base::dec | std::ios_base::skipws);
+	out.precision(6);
+	out.fill(' ');
 
 	// colorize
 	if (logColors) {
-		*out << "\033[0m";
-		if (level==0) *out << "\033[31m";
-		else if (level==1) *out << "\033[33m";
+		out << "\033[0m";
+		if (level==0) out << "\033[31m";
+		else if (level==1) out << "\033[33m";
 	}
-	//
+
 	// prepare log output
-	*out << "[" << level << "|" << std::setw(namePadding) << std::left << logger.name << "] ";
+	out << "[" << level << "|" << std::setw(namePadding.load(std::memory_order_relaxed)) << std::left << logger.name << "] ";
+	state.messageStart = state.buffer.record.size();
+
+	return out;
+}
+
+
+
+void LogSystem::endl(const Logger& logger, const int level, LogSite* site)
+{
+	ThreadState& state = threadState;
+
+	if (state.active && site && level>0) {
+		// annotate before the line break
+		std::string& record = state.buffer.record;
+		std::string note;
+		annotate(*site, note);
+		if (!note.empty()) record.insert(record.empty() || record.back()!='\n' ? record.size() : record.size()-1, note);
+	}
+
+	if (state.active) {
+		state.active = false;
+		const std::string& record = state.buffer.record;
+
+		uint8_t text = state.target & (OUT_CLI | OUT_FILE);
+		if (text && !async.load(std::memory_order_relaxed)) write(record.data(), record.size(), text);
+		else if (text) enqueue(record.data(), record.size(), text);
+
+		// JSON records are always formatted and written by the writer thread
+		if (state.target & OUT_JSON) {
+			size_t end = record.size() - (record.size()>state.messageStart && record.back()=='\n');
+			std::string& json = state.json;
+			json.clear();
+			pack(json, static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+							std::chrono::steady_clock::now().time_since_epoch()).count()));
+			pack(json, static_cast<uint64_t>(Logger::round.load(std::memory_order_relaxed)));
+			pack(json, static_cast<uint16_t>(level));
+			pack(json, getThreadName());
+			pack(json, logger.name);
+			json.append(record, state.messageStart, end-state.messageStart);
+			enqueue(json.data(), json.size(), OUT_JSON);
+		}
+	}
+
+	if (level==0) {
+		flush();
+		logger.errorHandler();
+	}
+}
+
+
+
+void LogSystem::commit(Logger& logger, LogSite& site, const int level, LogRecord& record)
+{
+	std::string note;
+	if (logger.target!=Logger::OFF && level>0) {
+		if (logger.limits->suppressDuplicates.load(std::memory_order_relaxed)
+				&& !admitDuplicate(logger, site, level, record.arguments, note)) return;
+		annotate(site, note);
+	}
+
+	// captured for duplicate suppression only, format the admitted message now
+	if (!binaryLog || !Logger::binaryFormat.load(std::memory_order_relaxed)) {
+		std::ostream& out = this->out(logger, level);
+		formatBinaryLogArguments(record.arguments.data(), record.arguments.data()+record.arguments.size(), out);
+		out << note << std::endl;
+		endl(logger, level);
+		return;
+	}
 
-	// return stream selected by caller given the systems constraints
-	return *out;
+	if (logger.target!=Logger::OFF)
+		binaryLog->write(logger, site, level, (note.empty() ? record : record << note).arguments);
+
+	if (level==0) {
+		flush();
+		logger.errorHandler();
+	}
+}
+
+
+
+void LogSystem::retire(const Logger& logger)
+{
+	flushRepeats(&logger);
 }
 
 
 
-void LogSystem::endl(const Logger& logger, const int level)
+LogSystem& LogSystem::flush()
 {
-	outMutex.unlock();
-	if (level==0) logger.errorHandler();
+	drain(true);
+
+	std::unique_lock<std::mutex> lock{outMutex, std::defer_lock};
+	if (acquire(lock, true)) {
+		if (outFile) outFile->sync();
+		if (outJSON) outJSON->sync();
+	}
+
+	return *this;
 }
 
 
@@ -130,6 +414,12 @@ LogSystem& LogSystem::announce(Logger& logger)
 	else
 		logger.verbosity = loggerLevels[tmpName];
 
+	// same for rate limit and duplicate suppression
+	if (loggerLimits.find(tmpName)==loggerLimits.end())
+		loggerLimits[tmpName] = logger.limits;
+	else
+		logger.limits = loggerLimits[tmpName];
+
 	return *this;
 }
 
@@ -137,13 +427,7 @@ LogSystem& LogSystem::announce(Logger& logger)
 
 LogSystem& LogSystem::enableLogFile(const std::string& file, bool append)
 {
-	if (outFile.is_open()) outFile.close();
-
-	// check append flag
-	if(append)
-		outFile.open(file, std::ios_base::app);
-	else
-		outFile.open(file);
+	openFile(outFile, fileOpen, file, append);
 
 	return *this;
 }
@@ -152,13 +436,51 @@ LogSystem& LogSystem::enableLogFile(const std::string& file, bool append)
 
 LogSystem& LogSystem::disableLogFile()
 {
-	outFile.close();
+	std::lock_guard<std::mutex> lock{outMutex};
+	fileOpen = false;
+	outFile.reset();
+
+	return *this;
+}
+
+
+
+LogSystem& LogSystem::enableLogJSON(const std::string& file, bool append)
+{
+	if (openFile(outJSON, jsonOpen, file, append)) startWriter();
 
 	return *this;
 }
 
 
 
+LogSystem& LogSystem::disableLogJSON()
+{
+	std::lock_guard<std::mutex> lock{outMutex};
+	jsonOpen = false;
+	outJSON.reset();
+
+	return *this;
+}
+
+
+
+bool LogSystem::openFile(std::unique_ptr<LogFileSink>& file, std::atomic<bool>& open, const std::string& path, bool append)
+{
+	std::lock_guard<std::mutex> lock{outMutex};
+	file.reset(new LogFileSink{path, append, fileMaxSize, fileSegments});
+	open = file->getError().empty();
+	if (!open) {
+		std::string line = systemMessage(file->getError());
+		if (outCLI.rdbuf() != nullStream.rdbuf()) outCLI.write(line.data(), line.size()).flush();
+		file.reset();
+	}
+
+	return open;
+}
+
+
+
 LogSystem& LogSystem::enableLogConsole(const std::ostream& out)
 {
 	// set internals to use given stream's buffer
@@ -186,6 +508,7 @@ LogSystem& LogSystem::updateSettings(const Config& config)
 		systemVerbosity = 0;
 		disableLogConsole();
 		disableLogFile();
+		disableLogJSON();
 
 		return *this;
 	}
@@ -194,7 +517,9 @@ LogSystem& LogSystem::updateSettings(const Config& config)
 	if(config.getValue<bool>("BVS.logConsole", bvs_log_to_console)==false)
 		disableLogConsole();
 
-	// enable log file, append if selected
+	// enable log file, append if selected, rotate segments if limited
+	fileMaxSize = config.getValue<size_t>("BVS.logFileMaxSize", bvs_log_file_max_size)<<20;
+	fileSegments = config.getValue<unsigned int>("BVS.logFileSegments", bvs_log_file_segments);
 	std::string configFile = config.getValue<std::string>("BVS.logFile", bvs_log_to_logfile);
 	bool append = false;
 	if(!configFile.empty()) {
@@ -205,11 +530,47 @@ LogSystem& LogSystem::updateSettings(const Config& config)
 		enableLogFile(configFile, append);
 	}
 
+	// structured log, same rotation as the log file
+	std::string jsonFile = config.getValue<std::string>("BVS.logJSON", bvs_log_json);
+	if(!jsonFile.empty()) {
+		bool appendJSON = jsonFile[0]=='+';
+		if (appendJSON) jsonFile.erase(0, 1);
+		enableLogJSON(jsonFile, appendJSON);
+	}
+
 	logColors = config.getValue<bool>("BVS.logColors", bvs_log_colors);
 
 	// check log system verbosity
 	systemVerbosity = config.getValue<unsigned short>("BVS.logVerbosity", bvs_log_system_verbosity);
 
+	// asynchronous backend, ring size applies to rings created afterwards
+	bufferSize = config.getValue<size_t>("BVS.logBufferSize", bvs_log_buffer_size);
+	std::string policy = config.getValue<std::string>("BVS.logOverflow", bvs_log_overflow);
+	if (policy=="BLOCK") overflow = Overflow::BLOCK;
+	else if (policy=="DROP") overflow = Overflow::DROP;
+	else overflow = Overflow::COUNT;
+
+	// binary log, opened once and kept until shutdown
+	bool binary = config.getValue<std::string>("BVS.logFormat", bvs_log_format)=="BINARY";
+	if (binary && !binaryLog) {
+		binaryLog.reset(new BinaryLogWriter{config.getValue<std::string>("BVS.logBinaryFile", bvs_log_binary_file),
+				config.getValue<size_t>("BVS.logBinarySize", bvs_log_binary_size)<<20});
+		if (!binaryLog->getError().empty()) {
+			std::string line = systemMessage(binaryLog->getError() + ", using text log");
+			write(line.data(), line.size(), OUT_CLI | OUT_FILE);
+			binaryLog.reset();
+		}
+	}
+	Logger::binaryFormat = binary && binaryLog;
+
+	if (config.getValue<bool>("BVS.logAsync", bvs_log_async)) {
+		startWriter();
+		async = true;
+	} else if (async) {
+		async = false;
+		if (!jsonOpen && !duplicates) stopWriter();
+	}
+
 	return *this;
 }
 
@@ -222,14 +583,356 @@ LogSystem& LogSystem::updateLoggerLevels(const Config& config)
 		std::string section = "logger.";
 		if (opt.first.substr(0, section.length())==section) {
 			std::string logger = opt.first.substr(section.length(), std::string::npos);
+
+			// LOGGER.option sets the logger's limits
+			size_t dot = logger.find('.');
+			if (dot!=std::string::npos) {
+				std::string option = logger.substr(dot+1);
+				logger.erase(dot);
+				if (loggerLimits.find(logger)==loggerLimits.end())
+					loggerLimits[logger] = std::make_shared<Logger::Limits>();
+				Logger::Limits& limits = *loggerLimits[logger];
+				if (option=="ratelimit")
+					limits.rateLimit = config.getValue<unsigned int>(opt.first, limits.rateLimit);
+				else if (option=="suppressduplicates") {
+					limits.suppressDuplicates = config.getValue<bool>(opt.first, limits.suppressDuplicates);
+					// the writer reports repeats of held back duplicates
+					if (limits.suppressDuplicates && !duplicates.exchange(true)) startWriter();
+				}
+				continue;
+			}
 			// if logger exists in map, update from config, else create new entry
 			if (loggerLevels.find(logger)!=loggerLevels.end())
 				*loggerLevels[logger] = config.getValue<unsigned short>(opt.first, *loggerLevels[logger]);
 			else
-				loggerLevels[logger] = std::make_shared<unsigned short>(config.getValue<unsigned short>(opt.first, bvs_log_client_default_verbosity));
+				loggerLevels[logger] = std::make_shared<std::atomic<unsigned short>>(config.getValue<unsigned short>(opt.first, bvs_log_client_default_verbosity));
 		}
 	}
 
 	return *this;
 }
 
+
+
+
+LogRing& LogSystem::threadRing()
+{
+	ThreadState& state = threadState;
+
+	if (!state.ring) {
+		state.ring = std::make_shared<LogRing>(bufferSize);
+		std::lock_guard<std::mutex> lock{ringsMutex};
+		rings.push_back(state.ring);
+	}
+
+	return *state.ring;
+}
+
+
+
+void LogSystem::write(const char* data, size_t size, uint8_t target)
+{
+	std::lock_guard<std::mutex> lock{outMutex};
+	if ((target & OUT_CLI) && outCLI.rdbuf() != nullStream.rdbuf()) outCLI.write(data, size).flush();
+	if (target & OUT_FILE) writeFile(outFile, fileOpen, data, size);
+	if (target & OUT_JSON) {
+		std::string line;
+		formatJSON(line, data, size);
+		writeFile(outJSON, jsonOpen, line.data(), line.size());
+	}
+}
+
+
+
+void LogSystem::writeFile(std::unique_ptr<LogFileSink>& file, std::atomic<bool>& open, const char* data, size_t size)
+{
+	if (!file || file->write(data, size)) return;
+
+	// report failure on the console and stop writing to the file
+	std::string line = systemMessage(file->getError() + ", log file disabled");
+	if (outCLI.rdbuf() != nullStream.rdbuf()) outCLI.write(line.data(), line.size()).flush();
+	open = false;
+	file.reset();
+}
+
+
+
+void LogSystem::enqueue(const char* data, size_t size, uint8_t target)
+{
+	LogRing& ring = threadRing();
+	bool pushed = ring.push(data, size, target);
+
+	// ring full: wake writer and wait (unless it can never fit), drop or count
+	while (!pushed && overflow==Overflow::BLOCK && writerRunning && ring.fits(size) && !threadState.writer) {
+		writerCondition.notify_one();
+		std::this_thread::yield();
+		pushed = ring.push(data, size, target);
+	}
+	if (!pushed) {
+		if (overflow==Overflow::BLOCK) {
+			flush();
+			write(data, size, target);
+		}
+		else if (overflow==Overflow::COUNT) dropped++;
+	}
+
+	if (ring.fill() > ring.capacity()/2) writerCondition.notify_one();
+}
+
+
+
+void LogSystem::formatJSON(std::string& out, const char* data, size_t size)
+{
+	const char* position = data;
+	const char* end = data + size;
+	uint64_t time = unpack<uint64_t>(position);
+	uint64_t round = unpack<uint64_t>(position);
+	uint16_t level = unpack<uint16_t>(position);
+	uint8_t threadLength = unpack<uint8_t>(position);
+	const char* thread = position;
+	position += threadLength;
+	uint8_t loggerLength = unpack<uint8_t>(position);
+	const char* logger = position;
+	position += loggerLength;
+
+	out += "{\"ts\":";
+	out += std::to_string(time);
+	out += ",\"thread\":";
+	appendJSONString(out, thread, threadLength);
+	out += ",\"logger\":";
+	appendJSONString(out, logger, loggerLength);
+	out += ",\"level\":";
+	out += std::to_string(level);
+	out += ",\"round\":";
+	out += std::to_string(round);
+	out += ",\"msg\":";
+	appendJSONString(out, position, end-position);
+	out += "}\n";
+}
+
+
+
+bool LogSystem::admitDuplicate(Logger& logger, LogSite& site, const int level, const std::string& arguments, std::string& note)
+{
+	uint64_t hash = 14695981039346656037ull;
+	for (char c: arguments) hash = (hash ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+	int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::milliseconds{bvs_log_duplicate_interval}).count();
+
+	while (site.busy.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+	int slot = 0;
+	for (int i=0; i<logSiteDuplicates; i++) {
+		if (site.hashes[i]==hash) { slot = i; break; }
+		if (site.reported[i]<site.reported[slot]) slot = i;
+	}
+
+	uint64_t evicted = site.hashes[slot];
+	uint32_t evictedRepeats = 0;
+	uint32_t repeats = 0;
+	bool suppress = false;
+	bool first = false;
+	if (site.hashes[slot]!=hash) {
+		// new message, replaces the least recently written one
+		evictedRepeats = site.repeats[slot];
+		site.hashes[slot] = hash;
+		site.repeats[slot] = 0;
+		site.reported[slot] = now;
+	} else if (now-site.reported[slot] < interval) {
+		first = site.repeats[slot]++==0;
+		suppress = true;
+	} else {
+		repeats = site.repeats[slot];
+		site.repeats[slot] = 0;
+		site.reported[slot] = now;
+	}
+	site.busy.store(false, std::memory_order_release);
+
+	if (first || evictedRepeats) {
+		std::lock_guard<std::mutex> lock{pendingMutex};
+		auto pending = std::find_if(pendingRepeats.begin(), pendingRepeats.end(), [&](const PendingRepeat& p) {
+				return p.site==&site && p.slot==slot && p.hash==evicted; });
+		if (evictedRepeats && pending!=pendingRepeats.end()) {
+			writeRepeats(*pending, evictedRepeats);
+			pendingRepeats.erase(pending);
+		}
+		// held back, the writer reports the repeats if the message does not come back in time
+		if (first) pendingRepeats.push_back(PendingRepeat{&logger, &site, slot, hash, level, arguments});
+	}
+
+	if (suppress) return false;
+	if (repeats) note += " (repeated " + std::to_string(repeats) + " times)";
+	return true;
+}
+
+
+
+void LogSystem::annotate(LogSite& site, std::string& note)
+{
+	uint32_t suppressed = site.suppressed.exchange(0, std::memory_order_relaxed);
+	if (suppressed) note += " (" + std::to_string(suppressed) + " messages suppressed by rate limit)";
+}
+
+
+
+void LogSystem::flushRepeats(const Logger* logger)
+{
+	int64_t now = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::steady_clock::now().time_since_epoch()).count();
+	int64_t interval = std::chrono::duration_cast<std::chrono::nanoseconds>(
+			std::chrono::milliseconds{bvs_log_duplicate_interval}).count();
+
+	std::lock_guard<std::mutex> lock{pendingMutex};
+	for (auto pending = pendingRepeats.begin(); pending!=pendingRepeats.end(); ) {
+		if (logger && pending->logger!=logger) {
+			++pending;
+			continue;
+		}
+
+		// done once the message came back (its note reported the repeats) or was evicted
+		LogSite& site = *pending->site;
+		uint32_t repeats = 0;
+		bool done = true;
+		while (site.busy.exchange(true, std::memory_order_acquire)) std::this_thread::yield();
+		if (site.hashes[pending->slot]==pending->hash && site.repeats[pending->slot]) {
+			if (logger || now-site.reported[pending->slot] >= interval) {
+				repeats = site.repeats[pending->slot];
+				site.repeats[pending->slot] = 0;
+				site.reported[pending->slot] = now;
+			} else done = false;
+		}
+		site.busy.store(false, std::memory_order_release);
+
+		if (repeats) writeRepeats(*pending, repeats);
+		if (done) pending = pendingRepeats.erase(pending);
+		else ++pending;
+	}
+}
+
+
+
+void LogSystem::writeRepeats(const PendingRepeat& pending, uint32_t repeats)
+{
+	std::string note = " (repeated " + std::to_string(repeats) + " times)";
+	const std::string& arguments = pending.arguments;
+
+	if (binaryLog && Logger::binaryFormat.load(std::memory_order_relaxed)) {
+		LogRecord record;
+		record.arguments = arguments;
+		binaryLog->write(*pending.logger, *pending.site, pending.level, (record << note).arguments);
+		return;
+	}
+
+	std::ostream& out = this->out(*pending.logger, pending.level);
+	formatBinaryLogArguments(arguments.data(), arguments.data()+arguments.size(), out);
+	out << note << std::endl;
+	endl(*pending.logger, pending.level);
+}
+
+
+
+std::string LogSystem::systemMessage(const std::string& message) const
+{
+	return std::string{logColors ? "\033[0m\033[33m" : ""} + "[1|LogSystem] " + message + "\n";
+}
+
+
+
+void LogSystem::startWriter()
+{
+	if (writerThread.joinable()) return;
+
+	writerRunning = true;
+	writerThread = std::thread{&LogSystem::writer, this};
+}
+
+
+
+void LogSystem::stopWriter()
+{
+	if (writerThread.joinable()) {
+		writerRunning = false;
+		writerCondition.notify_one();
+		writerThread.join();
+	}
+
+	drain();
+}
+
+
+
+void LogSystem::writer()
+{
+	threadState.writer = true;
+	while (writerRunning) {
+		{
+			std::unique_lock<std::mutex> lock{writerMutex};
+			writerCondition.wait_for(lock, std::chrono::milliseconds{bvs_log_writer_interval});
+		}
+		drain();
+		flushRepeats();
+	}
+}
+
+
+
+size_t LogSystem::drain(bool bounded)
+{
+	std::unique_lock<std::mutex> drainLock{drainMutex, std::defer_lock};
+	if (!acquire(drainLock, bounded)) return 0;
+
+	// collect messages of all rings, remove rings of exited threads
+	size_t count = 0;
+	batchCLI.clear();
+	batchFile.clear();
+	batchJSON.clear();
+	{
+		std::lock_guard<std::mutex> lock{ringsMutex};
+		for (auto& ring: rings)
+			count += ring->drain([&](uint8_t target, const char* data, size_t size) {
+					if (target & OUT_CLI) batchCLI.append(data, size);
+					if (target & OUT_FILE) batchFile.append(data, size);
+					if (target & OUT_JSON) formatJSON(batchJSON, data, size);
+					});
+		rings.erase(std::remove_if(rings.begin(), rings.end(),
+					[](const std::shared_ptr<LogRing>& ring) { return ring->closed && ring->fill()==0; }),
+				rings.end());
+	}
+
+	unsigned long long lost = dropped.exchange(0);
+	if (lost) {
+		std::string message = systemMessage(std::to_string(lost) + " messages dropped (log ring full)");
+		batchCLI += message;
+		batchFile += message;
+	}
+
+	if (batchCLI.empty() && batchFile.empty() && batchJSON.empty()) return count;
+
+	std::unique_lock<std::mutex> outLock{outMutex, std::defer_lock};
+	if (!acquire(outLock, bounded)) return 0;
+	if (!batchCLI.empty() && outCLI.rdbuf() != nullStream.rdbuf()) outCLI.write(batchCLI.data(), batchCLI.size()).flush();
+	if (!batchFile.empty()) writeFile(outFile, fileOpen, batchFile.data(), batchFile.size());
+	if (!batchJSON.empty()) writeFile(outJSON, jsonOpen, batchJSON.data(), batchJSON.size());
+	if (outFile) outFile->sync();
+	if (outJSON) outJSON->sync();
+
+	return count;
+}
+
+
+
+bool LogSystem::acquire(std::unique_lock<std::mutex>& lock, bool bounded)
+{
+	if (!bounded) {
+		lock.lock();
+		return true;
+	}
+
+	for (int i=0; i<100; i++) {
+		if (lock.try_lock()) return true;
+		std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	}
+
+	return false;
+}
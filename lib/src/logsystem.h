@@ -1,12 +1,18 @@
 #ifndef BVS_LOGSYSTEM_H
 #define BVS_LOGSYSTEM_H
 
-#include <fstream>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <mutex>
+#include <thread>
+#include <vector>
 
 #include "bvs/config.h"
+#include "binarylogwriter.h"
+#include "logfilesink.h"
 #include "streams.h"
 #include "bvs/logger.h"
 
@@ -15,6 +21,71 @@
 /** BVS namespace, contains all library stuff. */
 namespace BVS
 {
+	/** Single producer/single consumer ring buffer of log records.
+	 * Every logging thread owns one ring (producer), the writer thread of the
+	 * LogSystem drains all rings (consumer). Records are stored as
+	 * [uint32_t size][uint8_t target][size bytes], they may wrap around the
+	 * end of the buffer.
+	 */
+	class LogRing
+	{
+		public:
+			/** Create ring.
+			 * @param[in] capacity Capacity in bytes, rounded up to a power of two.
+			 */
+			LogRing(size_t capacity);
+
+			/** Append a record (producer only).
+			 * @param[in] data Record data.
+			 * @param[in] size Record size.
+			 * @param[in] target Record target (bit mask of LogSystem::Output).
+			 * @return False if there was not enough space.
+			 */
+			bool push(const char* data, uint32_t size, uint8_t target);
+
+			/** Check if a record fits into the (empty) ring at all.
+			 * @param[in] size Record size.
+			 * @return False if push() can never succeed for this size.
+			 */
+			bool fits(size_t size) const { return sizeof(uint32_t) + sizeof(uint8_t) + size <= buffer.size(); }
+
+			/** Remove all records (consumer only).
+			 * @param[in] sink Function called for every record.
+			 * @return Number of drained records.
+			 */
+			size_t drain(const std::function<void(uint8_t target, const char* data, size_t size)>& sink);
+
+			/** Used bytes.
+			 * @return Number of bytes waiting to be drained.
+			 */
+			size_t fill() const { return head.load(std::memory_order_acquire)-tail.load(std::memory_order_acquire); }
+
+			/** Capacity.
+			 * @return Capacity in bytes.
+			 */
+			size_t capacity() const { return buffer.size(); }
+
+			std::atomic<bool> closed; /**< Producer thread exited, remove once empty. */
+
+		private:
+			/** Copy into the ring, wrapping around if needed. */
+			void write(size_t position, const void* data, size_t size);
+
+			/** Copy out of the ring, wrapping around if needed. */
+			void read(size_t position, void* data, size_t size) const;
+
+			std::vector<char> buffer; /**< Record storage. */
+			size_t mask; /**< Capacity-1, used to wrap positions. */
+			std::atomic<size_t> head; /**< Write position (producer). */
+			std::atomic<size_t> tail; /**< Read position (consumer). */
+			std::string record; /**< Reused buffer for wrapped records (consumer). */
+
+			LogRing(const LogRing&) = delete; /**< -Weffc++ */
+			LogRing& operator=(const LogRing&) = delete; /**< -Weffc++ */
+	};
+
+
+
 	/** A logging system using std::ostream.
 	 * This creates a logging mechanism. It builds the backend for Logger. Each
 	 * Logger instance shares the output streams with all other instances.
@@ -26,27 +97,75 @@ namespace BVS
 	 * 2 INFO
 	 * 3 DEBUG
 	 * 4 and beyond are CUSTOM logging levels.
+	 *
+	 * Messages are formatted into a per thread buffer without holding any
+	 * lock. In synchronous mode (default) endl() writes the finished line
+	 * to the outputs under the output mutex. In asynchronous mode
+	 * (BVS.logAsync) endl() only copies the line into the thread's LogRing and
+	 * a writer thread drains all rings and writes them in batches, so logging
+	 * from module threads never waits for console or file I/O. If a ring is
+	 * full, BVS.logOverflow selects whether to block until the writer caught
+	 * up, drop the message or drop and count it (reported by the writer).
+	 * Messages to level 0 and flush() write all pending messages immediately.
+	 *
+	 * The JSON log (BVS.logJSON) receives every message of a logger that is
+	 * not OFF as one JSON object per line with a monotonic timestamp (ns),
+	 * thread name, logger, level, round and message text. endl() only packs
+	 * these fields into the thread's ring, the writer thread formats and
+	 * writes them (also in synchronous mode).
+	 *
+	 * In binary mode (BVS.logFormat) LOG bypasses the text path entirely and
+	 * writes raw arguments to a memory-mapped file, see BinaryLogWriter.
+	 * Loggers that suppress duplicates capture raw arguments as well, they
+	 * are only formatted once the message passed the duplicate check. The
+	 * writer thread (started for such loggers) writes the repeat count of a
+	 * held back message once its interval expired.
 	 */
 	class LogSystem
 	{
 		public:
+			/** Output bits of a record's target. */
+			enum Output : uint8_t { OUT_CLI = 1, OUT_FILE = 2, OUT_JSON = 4 };
+
+			/** Policies for full log rings. */
+			enum class Overflow { BLOCK, DROP, COUNT };
+
+			/** Stop writer thread and write pending messages. */
+			~LogSystem();
+
 			/** Connect to logging System.
 			 * @return Pointer to logging instance.
 			 */
 			static std::shared_ptr<LogSystem> connectToLogSystem();
 
-			/** Log to output. End this by calling endl() to release the log mutex.
+			/** Log to output. End this by calling endl() to emit the message.
 			 * @param[in] logger Logger metadata from caller.
 			 * @param[in] level The desired output verbosity of this message.
 			 * @return Outstream to log to.
 			 */
 			std::ostream& out(const Logger& logger, int level);
 
-			/** Ends output log by appending std::endl and releasing the log mutex.
+			/** Ends output log, writes or queues the formatted message.
 			 * @param[in] logger Logger metadata from caller.
 			 * @param[in] level The desired output verbosity of this message.
+			 * @param[in,out] site Call site of the message (for duplicate suppression).
 			*/
-			void endl(const Logger& logger, const int level);
+			void endl(const Logger& logger, const int level, LogSite* site = nullptr);
+
+			/** Write a captured message (see Logger::capture()).
+			 * Checks for duplicates, then writes the message to the binary log
+			 * (see BVS.logFormat) or formats it to the text outputs.
+			 * @param[in,out] logger Logger metadata from caller.
+			 * @param[in,out] site Call site of the message.
+			 * @param[in] level The desired output verbosity of this message.
+			 * @param[in,out] record Tagged argument values.
+			 */
+			void commit(Logger& logger, LogSite& site, const int level, LogRecord& record);
+
+			/** Write held back duplicates of a logger before it is destroyed.
+			 * @param[in] logger Logger metadata from caller.
+			 */
+			void retire(const Logger& logger);
 
 			/** Set the system verbosity level.
 			 * @param[in] verbosity The desired verbosity level.
@@ -68,6 +187,18 @@ namespace BVS
 			 */
 			LogSystem& disableLogFile();
 
+			/** Open and enable JSON log (starts the writer thread).
+			 * @param[in] file Path to file to log to.
+			 * @param[in] append Select, whether to append or overwrite.
+			 * @return Reference to object.
+			 */
+			LogSystem& enableLogJSON(const std::string& file, bool append = false);
+
+			/** Close and disable JSON log.
+			 * @return Reference to object.
+			 */
+			LogSystem& disableLogJSON();
+
 			/** Enable log console/command line interface.
 			 * @param out Stream to log to (default = std::cout).
 			 * @return Reference to object.
@@ -79,6 +210,13 @@ namespace BVS
 			 */
 			LogSystem& disableLogConsole();
 
+			/** Write all pending messages of the asynchronous backend.
+			 * Waits only a bounded time for the output locks, so it can be
+			 * used from signal handlers (e.g. on SIGSEGV).
+			 * @return Reference to object.
+			 */
+			LogSystem& flush();
+
 			/** Announces a logger instance to the backend.
 			 * @param[in] logger Logger metadata from caller.
 			 */
@@ -91,6 +229,12 @@ namespace BVS
 			 * logSystem = true/false
 			 * logConsole = true/false
 			 * logFile = $logFile # a '+' in front of the file name will append to the file
+			 * logAsync = true/false
+			 * logBufferSize = $bytes # per thread
+			 * logOverflow = BLOCK/DROP/COUNT
+			 * logFormat = TEXT/BINARY
+			 * logBinaryFile = $binaryLogFile
+			 * logBinarySize = $megabytes
 			 * @endcode
 			 * @param[in] config Config object.
 			 * @return Reference to object.
@@ -99,11 +243,13 @@ namespace BVS
 
 			/** Check config for client levels.
 			 * Checks the given config object for occurences of Logger.*.
-			 * This way one can specify verbosity levels in a config file:
+			 * This way one can specify verbosity levels and limits in a config file:
 			 * @code
 			 * [Logger]
 			 * LoggerOne = 0
 			 * LoggerTwo = 1
+			 * LoggerTwo.rateLimit = 10
+			 * LoggerTwo.suppressDuplicates = ON
 			 * @endcode
 			 * @param[in] config Config object.
 			 * @return Reference to object.
@@ -115,14 +261,132 @@ namespace BVS
 			*/
 			LogSystem();
 
+			/** Get the calling thread's ring, create and register it if needed.
+			 * @return Ring of the calling thread.
+			 */
+			LogRing& threadRing();
+
+			/** Write a formatted message to the selected outputs (locks output mutex).
+			 * @param[in] data Message.
+			 * @param[in] size Message size.
+			 * @param[in] target Bit mask of Output.
+			 */
+			void write(const char* data, size_t size, uint8_t target);
+
+			/** Append to a log file (caller holds outMutex).
+			 * Disables the log file if it fails.
+			 * @param[in,out] file Log file.
+			 * @param[in,out] open Flag of the log file, cleared if it fails.
+			 * @param[in] data Data to append.
+			 * @param[in] size Size of data.
+			 */
+			void writeFile(std::unique_ptr<LogFileSink>& file, std::atomic<bool>& open, const char* data, size_t size);
+
+			/** Open a log file (locks output mutex), report errors on the console.
+			 * @param[out] file Log file.
+			 * @param[out] open Flag of the log file.
+			 * @param[in] path Path to file.
+			 * @param[in] append Select, whether to append or overwrite.
+			 * @return False if the file could not be opened.
+			 */
+			bool openFile(std::unique_ptr<LogFileSink>& file, std::atomic<bool>& open, const std::string& path, bool append);
+
+			/** Queue a record in the calling thread's ring, apply overflow policy if full.
+			 * With BLOCK, records larger than the whole ring and records of the
+			 * writer thread itself are written directly (after all queued
+			 * records) instead of waiting, other policies drop them.
+			 * @param[in] data Record.
+			 * @param[in] size Record size.
+			 * @param[in] target Bit mask of Output.
+			 */
+			void enqueue(const char* data, size_t size, uint8_t target);
+
+			/** Format a packed JSON record (see endl()) as one line of JSON.
+			 * @param[in,out] out String to append to.
+			 * @param[in] data Packed record.
+			 * @param[in] size Record size.
+			 */
+			static void formatJSON(std::string& out, const char* data, size_t size);
+
+			/** Message whose duplicates are held back by its call site. */
+			struct PendingRepeat
+			{
+				Logger* logger; /**< Logger of the message (retired before destruction). */
+				LogSite* site; /**< Call site of the message. */
+				int slot; /**< Duplicate slot of the site. */
+				uint64_t hash; /**< Hash of the message. */
+				int level; /**< Level of the message. */
+				std::string arguments; /**< Tagged argument values. */
+			};
+
+			/** Apply duplicate suppression to a captured message (before formatting).
+			 * The first held back duplicate registers the message, so the writer
+			 * thread reports its repeats once the interval expired.
+			 * @param[in,out] logger Logger metadata from caller.
+			 * @param[in,out] site Call site of the message.
+			 * @param[in] level The desired output verbosity of this message.
+			 * @param[in] arguments Tagged argument values.
+			 * @param[out] note Note to append to the message (repeats).
+			 * @return False if the message is a suppressed duplicate.
+			 */
+			bool admitDuplicate(Logger& logger, LogSite& site, const int level, const std::string& arguments, std::string& note);
+
+			/** Report messages dropped by a call site's rate limit.
+			 * @param[in,out] site Call site of the message.
+			 * @param[out] note Note to append to the message.
+			 */
+			static void annotate(LogSite& site, std::string& note);
+
+			/** Write repeats of held back duplicates whose interval expired.
+			 * @param[in] logger Only write repeats of this logger and ignore the interval (nullptr: all loggers).
+			 */
+			void flushRepeats(const Logger* logger = nullptr);
+
+			/** Write a held back message with its repeat count.
+			 * @param[in] pending Held back message.
+			 * @param[in] repeats Number of held back duplicates.
+			 */
+			void writeRepeats(const PendingRepeat& pending, uint32_t repeats);
+
+			/** Format a message of the log system itself.
+			 * @param[in] message Message.
+			 * @return Formatted line.
+			 */
+			std::string systemMessage(const std::string& message) const;
+
+			/** Start writer thread. */
+			void startWriter();
+
+			/** Stop writer thread and write pending messages. */
+			void stopWriter();
+
+			/** Writer thread, drains all rings periodically or when notified and writes repeats of held back duplicates. */
+			void writer();
+
+			/** Drain all rings and write collected messages in one batch per output.
+			 * @param[in] bounded Give up if the locks can not be acquired in time.
+			 * @return Number of written messages.
+			 */
+			size_t drain(bool bounded = false);
+
+			/** Lock a mutex, optionally giving up after a short time.
+			 * @param[in,out] lock Deferred lock to acquire.
+			 * @param[in] bounded Give up after about 100ms.
+			 * @return True if the lock was acquired.
+			 */
+			static bool acquire(std::unique_lock<std::mutex>& lock, bool bounded);
+
 			/** Logger clients' verbosity levels with lowercase identifiers. */
-			std::map<std::string, std::shared_ptr<unsigned short>, std::less<std::string>> loggerLevels;
+			std::map<std::string, std::shared_ptr<std::atomic<unsigned short>>, std::less<std::string>> loggerLevels;
+
+			/** Logger clients' limits with lowercase identifiers. */
+			std::map<std::string, std::shared_ptr<Logger::Limits>> loggerLimits;
 
-			/** Temp object needed for output and announce function. */
+			/** Temp object needed for announce function. */
 			std::string tmpName;
 
 			/** Name padding size for fancy output, updated in announce function. */
-			unsigned int namePadding;
+			std::atomic<unsigned int> namePadding;
 
 			/** Whether to output colors in the log output.
 			 * Messages to level 0 (ERROR) are red, messages to level 1 (INFO)
@@ -138,16 +402,42 @@ namespace BVS
 			 * [BVS]
 			 * logVerbosity = 0 # your desired level
 			 * @endcode
+			 * Refers to Logger::systemVerbosity, so LOG can check it inline.
 			 * */
-			unsigned short systemVerbosity;
+			std::atomic<unsigned short>& systemVerbosity;
 
 			static std::shared_ptr<LogSystem> instance; /**< Logging system instance. */
 			std::mutex outMutex; /**< Output mutex, needed for threaded scenarios. */
 
 			static NullStream nullStream; /**< Stream pointing to nirvana */
 			std::ostream outCLI; /**< Stream pointing to Command Line Interface. */
-			std::ofstream outFile; /**< Stream pointing to file. */
-			StreamDup outBoth; /**< Stream duplicator pointing to CLI and file. */
+			std::unique_ptr<LogFileSink> outFile; /**< Memory-mapped log file (nullptr if disabled). */
+			std::atomic<bool> fileOpen; /**< Whether outFile is set, checked without outMutex. */
+			size_t fileMaxSize; /**< Log file segment size in bytes (0 disables rotation). */
+			unsigned int fileSegments; /**< Number of log file segments to keep. */
+			std::unique_ptr<LogFileSink> outJSON; /**< JSON log (nullptr if disabled). */
+			std::atomic<bool> jsonOpen; /**< Whether outJSON is set, checked without outMutex. */
+
+			std::atomic<bool> async; /**< Queue messages for the writer thread. */
+			size_t bufferSize; /**< Capacity of new rings. */
+			Overflow overflow; /**< Policy for full rings. */
+			std::vector<std::shared_ptr<LogRing>> rings; /**< Rings of all logging threads. */
+			std::mutex ringsMutex; /**< Protects rings. */
+			std::mutex drainMutex; /**< Serializes draining (writer and flush). */
+			std::string batchCLI; /**< Reused batch for CLI output. */
+			std::string batchFile; /**< Reused batch for file output. */
+			std::string batchJSON; /**< Reused batch for JSON output. */
+			std::atomic<unsigned long long> dropped; /**< Dropped messages (not yet reported). */
+			std::atomic<bool> writerRunning; /**< Writer thread should keep running. */
+			std::mutex writerMutex; /**< Mutex for writerCondition. */
+			std::condition_variable writerCondition; /**< Wakes up the writer thread. */
+			std::thread writerThread; /**< Writer thread. */
+
+			std::unique_ptr<BinaryLogWriter> binaryLog; /**< Binary log (once BVS.logFormat was BINARY). */
+
+			std::vector<PendingRepeat> pendingRepeats; /**< Messages with held back duplicates. */
+			std::mutex pendingMutex; /**< Protects pendingRepeats. */
+			std::atomic<bool> duplicates; /**< A logger suppresses duplicates (keeps the writer running). */
 
 			LogSystem(const LogSystem&) = delete; /**< -Weffc++ */
 			LogSystem& operator=(const LogSystem&) = delete; /**< -Weffc++ */
@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+#include "perfcounters.h"
+
+using BVS::PerfCounters;
+
+
+
+#ifdef __linux__
+/** Known events, name -> (perf type, perf config). */
+static const struct { const char* name; unsigned int type; unsigned long long config; } perfEvents[] = {
+	{ "cycles", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ "instructions", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ "cache-references", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_REFERENCES },
+	{ "cache-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ "branches", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_INSTRUCTIONS },
+	{ "branch-misses", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+	{ "task-clock", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_TASK_CLOCK },
+	{ "page-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+	{ "minor-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MIN },
+	{ "major-faults", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS_MAJ },
+	{ "context-switches", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+	{ "cpu-migrations", PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CPU_MIGRATIONS },
+};
+
+
+
+/** Open a counter for the calling thread.
+ * @param[in] name Event name.
+ * @param[in] groupFd Group leader or -1 to create a new group.
+ * @return File descriptor or -1 on error (unknown events set errno to EINVAL).
+ */
+static int openPerfEvent(const std::string& name, int groupFd)
+{
+	for (auto& event: perfEvents) {
+		if (name!=event.name) continue;
+
+		perf_event_attr attr;
+		memset(&attr, 0, sizeof(attr));
+		attr.size = sizeof(attr);
+		attr.type = event.type;
+		attr.config = event.config;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		attr.read_format = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+		return syscall(__NR_perf_event_open, &attr, 0, -1, groupFd, 0);
+	}
+
+	errno = EINVAL;
+	return -1;
+}
+#endif //__linux__
+
+
+
+PerfCounters::PerfCounters(const std::vector<std::string>& events)
+	: logger{"PerfCounters"},
+	fds{},
+	buffer(3 + events.size())
+{
+#ifdef __linux__
+	for (auto& event: events) {
+		int fd = openPerfEvent(event, fds.empty() ? -1 : fds.front());
+		if (fd<0) {
+			LOG(1, "could not open counter '" << event << "': " << strerror(errno));
+			for (auto& it: fds) close(it);
+			fds.clear();
+			return;
+		}
+		fds.push_back(fd);
+	}
+#else
+	(void) events;
+#endif //__linux__
+}
+
+
+
+PerfCounters::~PerfCounters()
+{
+#ifdef __linux__
+	for (auto& fd: fds) close(fd);
+#endif //__linux__
+}
+
+
+
+bool PerfCounters::read(Reading& reading)
+{
+#ifdef __linux__
+	if (fds.empty()) return false;
+
+	// group layout: nr, time_enabled, time_running, value[nr]
+	ssize_t size = ::read(fds.front(), buffer.data(), buffer.size()*sizeof(unsigned long long));
+	if (size<=0 || buffer[0]!=fds.size()) return false;
+
+	reading.enabled = buffer[1];
+	reading.running = buffer[2];
+	reading.values.assign(buffer.begin()+3, buffer.begin()+3+fds.size());
+
+	return true;
+#else
+	(void) reading;
+	return false;
+#endif //__linux__
+}
+
+
+
+void PerfCounters::difference(const Reading& before, const Reading& after, std::vector<unsigned long long>& counters)
+{
+	// scale the difference, not the readings, their ratios differ when multiplexing changed in between
+	unsigned long long enabled = after.enabled>before.enabled ? after.enabled-before.enabled : 0;
+	unsigned long long running = after.running>before.running ? after.running-before.running : 0;
+	double scale = running!=0 && running<enabled ? static_cast<double>(enabled)/running : 1.0;
+
+	for (size_t i=0; i<counters.size(); i++) {
+		if (i>=before.values.size() || i>=after.values.size() || after.values[i]<=before.values[i]) {
+			counters[i] = 0;
+			continue;
+		}
+		unsigned long long raw = after.values[i]-before.values[i];
+		counters[i] = scale==1.0 ? raw : static_cast<unsigned long long>(raw*scale);
+	}
+}
+
+
+
+std::vector<std::string> PerfCounters::probe(const std::vector<std::string>& events)
+{
+	Logger logger{"PerfCounters"};
+	std::vector<std::string> available;
+
+#ifdef __linux__
+	bool hardwareMissing = false;
+	for (auto& event: events) {
+		int fd = openPerfEvent(event, -1);
+		if (fd>=0) {
+			close(fd);
+			if (std::find(available.begin(), available.end(), event)==available.end())
+				available.push_back(event);
+			continue;
+		}
+
+		if (errno==EINVAL) {
+			LOG(1, "unknown counter '" << event << "', ignoring it!");
+		} else {
+			LOG(1, "counter '" << event << "' not supported: " << strerror(errno));
+			hardwareMissing = true;
+		}
+	}
+
+	// fall back to software events, e.g. if there is no PMU available
+	if (hardwareMissing) {
+		for (std::string event: {"task-clock", "page-faults"}) {
+			if (std::find(available.begin(), available.end(), event)!=available.end()) continue;
+			int fd = openPerfEvent(event, -1);
+			if (fd<0) continue;
+			close(fd);
+			available.push_back(event);
+			LOG(1, "using software counter '" << event << "' instead!");
+		}
+	}
+#else
+	if (!events.empty()) LOG(1, "performance counters are only available on Linux!");
+#endif //__linux__
+
+	return available;
+}
@@ -0,0 +1,92 @@
+#ifndef BVS_PERFCOUNTERS_H
+#define BVS_PERFCOUNTERS_H
+
+#include <string>
+#include <vector>
+
+#include "bvs/logger.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Hardware/software performance counters of the calling thread.
+	 * This opens a group of performance counters (using Linux'
+	 * perf_event_open) that only counts events of the thread that
+	 * constructed it. Read the counters before and after a piece of work to
+	 * get the number of events it caused:
+	 * @code
+	 * std::vector<std::string> events = PerfCounters::probe({"cycles", "instructions"});
+	 * PerfCounters counters{events};
+	 * counters.read(before);
+	 * // work
+	 * counters.read(after);
+	 * PerfCounters::difference(before, after, values);
+	 * @endcode
+	 *
+	 * Known events: cycles, instructions, cache-references, cache-misses,
+	 * branches, branch-misses, task-clock, page-faults, minor-faults,
+	 * major-faults, context-switches, cpu-migrations.
+	 *
+	 * NOTE: this only works on Linux, on other systems no counters are
+	 * available.
+	 */
+	class PerfCounters
+	{
+		public:
+			/** Raw (unscaled) counter values and group times. */
+			struct Reading
+			{
+				unsigned long long enabled; /**< Time the group was enabled (ns). */
+				unsigned long long running; /**< Time the group was counting (ns). */
+				std::vector<unsigned long long> values; /**< Raw counter values. */
+			};
+
+			/** Open counter group for the calling thread.
+			 * @param[in] events Event names, should be checked by probe() first.
+			 */
+			PerfCounters(const std::vector<std::string>& events);
+
+			/** Close counter group. */
+			~PerfCounters();
+
+			/** Read current raw counter values.
+			 * @param[out] reading Counter values, ordered as the events given to the constructor.
+			 * @return True if the counters could be read.
+			 */
+			bool read(Reading& reading);
+
+			/** Calculate the events counted between two readings.
+			 * The raw difference is scaled by the enabled/running ratio of
+			 * the interval if the kernel had to multiplex the group. Values
+			 * that went backwards count as 0.
+			 * @param[in] before Reading at the start of the interval.
+			 * @param[in] after Reading at the end of the interval.
+			 * @param[out] counters Events per counter (not resized).
+			 */
+			static void difference(const Reading& before, const Reading& after, std::vector<unsigned long long>& counters);
+
+			/** Check which of the requested events can be counted.
+			 * Unknown or unsupported events are dropped, if hardware events
+			 * are not supported at all (e.g. inside a VM without PMU), the
+			 * software events 'task-clock' and 'page-faults' are used instead.
+			 * @param[in] events Requested event names.
+			 * @return Usable event names.
+			 */
+			static std::vector<std::string> probe(const std::vector<std::string>& events);
+
+		private:
+			Logger logger; /**< Logger metadata. */
+			std::vector<int> fds; /**< Counter file descriptors, first one is the group leader. */
+			std::vector<unsigned long long> buffer; /**< Read buffer for group reads. */
+
+			PerfCounters(const PerfCounters&) = delete; /**< -Weffc++ */
+			PerfCounters& operator=(const PerfCounters&) = delete; /**< -Weffc++ */
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_PERFCOUNTERS_H
+
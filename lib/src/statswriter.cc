@@ -0,0 +1,187 @@
+#include <cerrno>
+#include <cstring>
+#include <new>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "statswriter.h"
+
+using BVS::StatsWriter;
+
+
+
+/** Copy a name into a fixed size entry field. */
+static void copyName(char* target, const std::string& name)
+{
+	strncpy(target, name.c_str(), BVS::statsPageNameLength-1);
+	target[BVS::statsPageNameLength-1] = '\0';
+}
+
+
+
+StatsWriter::StatsWriter(unsigned int moduleCapacity, unsigned int poolCapacity, unsigned int connectorCapacity)
+	: logger{"StatsWriter"},
+	path{"/dev/shm/bvs-" + std::to_string(getpid())},
+	size{sizeof(StatsPageHeader) + moduleCapacity*sizeof(StatsPageModule)
+		+ poolCapacity*sizeof(StatsPagePool) + connectorCapacity*sizeof(StatsPageConnector)},
+	header{nullptr},
+	moduleEntries{nullptr},
+	poolEntries{nullptr},
+	connectorEntries{nullptr},
+	moduleSlots{},
+	poolSlots{},
+	connectorSlots{},
+	name{}
+{
+	int fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+	if (fd<0 || ftruncate(fd, size)!=0) {
+		LOG(1, "could not create statistics page '" << path << "': " << strerror(errno));
+		if (fd>=0) close(fd);
+		path.clear();
+		return;
+	}
+
+	void* page = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	close(fd);
+	if (page==MAP_FAILED) {
+		LOG(1, "could not map statistics page '" << path << "': " << strerror(errno));
+		unlink(path.c_str());
+		path.clear();
+		return;
+	}
+
+	// ftruncate zero-fills the page, so only the non-zero fields need to be set
+	header = new(page) StatsPageHeader;
+	memcpy(header->magic, "BVSSTAT", 8);
+	header->version = statsPageVersion;
+	header->size = size;
+	header->moduleCapacity = moduleCapacity;
+	header->poolCapacity = poolCapacity;
+	header->connectorCapacity = connectorCapacity;
+	header->sequence.store(0, std::memory_order_release);
+	header->pid = getpid();
+	moduleEntries = reinterpret_cast<StatsPageModule*>(header + 1);
+	poolEntries = reinterpret_cast<StatsPagePool*>(moduleEntries + moduleCapacity);
+	connectorEntries = reinterpret_cast<StatsPageConnector*>(poolEntries + poolCapacity);
+
+	LOG(2, "publishing statistics to '" << path << "'!");
+}
+
+
+
+StatsWriter::~StatsWriter()
+{
+	if (!header) return;
+	munmap(header, size);
+	unlink(path.c_str());
+}
+
+
+
+StatsWriter& StatsWriter::publish(const Info& info, const ModuleTable& table,
+		const PoolPlan& pools, std::chrono::nanoseconds roundDuration)
+{
+	if (!header) return *this;
+
+	using std::chrono::duration_cast;
+	using std::chrono::microseconds;
+
+	uint64_t sequence = header->sequence.load(std::memory_order_relaxed);
+	header->sequence.store(sequence+1, std::memory_order_relaxed);
+	std::atomic_thread_fence(std::memory_order_release);
+
+	header->round = info.round;
+	header->timestamp = duration_cast<microseconds>(std::chrono::system_clock::now().time_since_epoch()).count();
+	header->roundDuration = duration_cast<microseconds>(roundDuration).count();
+	header->roundUtilization = info.roundUtilization;
+	header->poolImbalance = info.poolImbalance;
+	header->rounds++;
+	header->roundDurationSum += header->roundDuration;
+	header->roundHistogram[statsPageBucket(header->roundDuration)]++;
+
+	for (uint32_t i=0; i<header->moduleCount; i++) moduleEntries[i].active = 0;
+	for (uint32_t i=0; i<header->poolCount; i++) poolEntries[i].active = 0;
+	for (uint32_t i=0; i<header->connectorCount; i++) connectorEntries[i].active = 0;
+
+	for (auto& pool: pools) {
+		for (auto& record: *pool->plan) {
+			const ModuleData& data = *record.data;
+			const ModuleState& state = table[record.index];
+			if (state.flag==ControlFlag::QUIT) continue;
+			int moduleSlot = slot(moduleSlots, data.id, header->moduleCount, header->moduleCapacity);
+			if (moduleSlot<0) continue;
+
+			StatsPageModule& entry = moduleEntries[moduleSlot];
+			copyName(entry.id, data.id);
+			copyName(entry.pool, data.poolName);
+			entry.active = 1;
+			entry.duration = duration_cast<microseconds>(state.duration).count();
+			entry.cpuDuration = duration_cast<microseconds>(state.cpuDuration).count();
+			entry.status = static_cast<int32_t>(state.status);
+			auto switches = info.moduleContextSwitches.find(data.id);
+			entry.voluntarySwitches = switches!=info.moduleContextSwitches.end() ? switches->second.voluntary : 0;
+			entry.involuntarySwitches = switches!=info.moduleContextSwitches.end() ? switches->second.involuntary : 0;
+			// totals only count rounds in which execute() was called (not waiting or skipped modules)
+			if (state.executedRound==info.round) {
+				entry.executions++;
+				entry.durationSum += entry.duration;
+				entry.cpuDurationSum += entry.cpuDuration;
+				if (state.status==Status::NOINPUT) entry.noinputCount++;
+				if (state.status==Status::FAIL) entry.failCount++;
+				entry.histogram[statsPageBucket(entry.duration)]++;
+			}
+
+			for (auto& connector: data.connectors) {
+				name.assign(data.id).append(".").append(connector.first);
+				int connectorSlot = slot(connectorSlots, name, header->connectorCount, header->connectorCapacity);
+				if (connectorSlot<0) continue;
+
+				const ConnectorStatistics& statistics = connector.second->statistics;
+				StatsPageConnector& entry = connectorEntries[connectorSlot];
+				copyName(entry.name, name);
+				entry.output = connector.second->type==ConnectorType::OUTPUT;
+				entry.active = 1;
+				entry.sends = statistics.sends.load(std::memory_order_relaxed);
+				entry.receives = statistics.receives.load(std::memory_order_relaxed);
+				entry.bytes = statistics.bytes.load(std::memory_order_relaxed);
+				entry.contended = statistics.contended.load(std::memory_order_relaxed);
+				entry.waitNanoseconds = statistics.waitNanoseconds.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+	for (auto& pool: pools) {
+		const PoolData& data = *pool;
+		int poolSlot = slot(poolSlots, data.poolName, header->poolCount, header->poolCapacity);
+		if (poolSlot<0) continue;
+
+		StatsPagePool& entry = poolEntries[poolSlot];
+		std::chrono::nanoseconds busy = data.round==info.round ? data.busy : std::chrono::nanoseconds{0};
+		copyName(entry.name, data.poolName);
+		entry.active = 1;
+		entry.busy = duration_cast<microseconds>(busy).count();
+		entry.idle = busy<roundDuration ? duration_cast<microseconds>(roundDuration - busy).count() : 0;
+		auto utilization = info.poolUtilization.find(data.poolName);
+		entry.utilization = utilization!=info.poolUtilization.end() ? utilization->second : 0;
+		entry.busySum += entry.busy;
+		entry.idleSum += entry.idle;
+	}
+
+	header->sequence.store(sequence+2, std::memory_order_release);
+
+	return *this;
+}
+
+
+
+int StatsWriter::slot(std::map<std::string, uint32_t>& slots, const std::string& name, uint32_t& count, uint32_t capacity)
+{
+	auto it = slots.find(name);
+	if (it!=slots.end()) return it->second;
+	if (count==capacity) return -1;
+
+	slots[name] = count;
+	return count++;
+}
@@ -0,0 +1,85 @@
+#ifndef BVS_STATSWRITER_H
+#define BVS_STATSWRITER_H
+
+#include <chrono>
+#include <map>
+#include <string>
+
+#include "bvs/info.h"
+#include "bvs/logger.h"
+#include "bvs/statspage.h"
+#include "controldata.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Writes the statistics page (see StatsPageHeader).
+	 * Creates '/dev/shm/bvs-<pid>' and publishes round, module and pool
+	 * statistics after each round, so external tools (e.g. bvs-top) can
+	 * read them without any IPC. The file is removed on destruction.
+	 *
+	 * Slots are assigned on first sight and kept, so totals of a module,
+	 * pool or connector always stay in the same entry.
+	 */
+	class StatsWriter
+	{
+		public:
+			/** Create and map statistics page.
+			 * @param[in] moduleCapacity Maximum number of modules.
+			 * @param[in] poolCapacity Maximum number of pools.
+			 * @param[in] connectorCapacity Maximum number of connectors.
+			 */
+			StatsWriter(unsigned int moduleCapacity, unsigned int poolCapacity, unsigned int connectorCapacity);
+
+			/** Unmap and remove statistics page. */
+			~StatsWriter();
+
+			/** Publish statistics of the last round (called by master).
+			 * Modules are taken from the published plans of the pools.
+			 * @param[in] info Info struct.
+			 * @param[in] table Module states, indexed by the plan entries.
+			 * @param[in] pools Pool meta data.
+			 * @param[in] roundDuration Duration of the last round.
+			 * @return Reference to object.
+			 */
+			StatsWriter& publish(const Info& info, const ModuleTable& table,
+					const PoolPlan& pools, std::chrono::nanoseconds roundDuration);
+
+			/** Path of the statistics page.
+			 * @return File path (empty if the page could not be created).
+			 */
+			const std::string& getPath() const { return path; }
+
+		private:
+			/** Find or assign the slot of a name.
+			 * @param[in,out] slots Slot map.
+			 * @param[in] name Name.
+			 * @param[in,out] count Used slots.
+			 * @param[in] capacity Available slots.
+			 * @return Slot or -1 if no slot is left.
+			 */
+			int slot(std::map<std::string, uint32_t>& slots, const std::string& name, uint32_t& count, uint32_t capacity);
+
+			Logger logger; /**< Logger metadata. */
+			std::string path; /**< Page file path. */
+			size_t size; /**< Page size. */
+			StatsPageHeader* header; /**< Mapped page (nullptr if not mapped). */
+			StatsPageModule* moduleEntries; /**< Module entries. */
+			StatsPagePool* poolEntries; /**< Pool entries. */
+			StatsPageConnector* connectorEntries; /**< Connector entries. */
+			std::map<std::string, uint32_t> moduleSlots; /**< Module id -> slot. */
+			std::map<std::string, uint32_t> poolSlots; /**< Pool name -> slot. */
+			std::map<std::string, uint32_t> connectorSlots; /**< Connector name -> slot. */
+			std::string name; /**< Reused buffer for connector names. */
+
+			StatsWriter(const StatsWriter&) = delete; /**< -Weffc++ */
+			StatsWriter& operator=(const StatsWriter&) = delete; /**< -Weffc++ */
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_STATSWRITER_H
+
@@ -2,6 +2,7 @@
 #define BVS_STREAMS_H
 
 #include <iostream>
+#include <string>
 
 
 
@@ -67,6 +68,41 @@ namespace BVS
 
 
 
+	/** A streambuffer collecting its input in a string. */
+	class RecordBuffer: public std::streambuf
+	{
+		public:
+			/** Construct empty record buffer. */
+			RecordBuffer() : record{} {}
+
+			std::string record; /**< Collected characters. */
+
+		protected:
+			/** Append a character to the record.
+			 * @param[in] c Character to append.
+			 * @return Character or EOF.
+			 */
+			virtual int overflow(int c)
+			{
+				if (c == EOF) return !EOF;
+				record.push_back(static_cast<char>(c));
+				return c;
+			}
+
+			/** Append characters to the record.
+			 * @param[in] s Characters to append.
+			 * @param[in] n Number of characters.
+			 * @return Number of appended characters.
+			 */
+			virtual std::streamsize xsputn(const char* s, std::streamsize n)
+			{
+				record.append(s, n);
+				return n;
+			}
+	};
+
+
+
 	/** A Stream pointing to nirvana. */
 	class NullStream : public std::ostream
 	{
@@ -15,8 +15,17 @@
 
 
 
+namespace
+{
+	thread_local std::string currentThreadName; /**< Name set by nameThisThread(). */
+}
+
+
+
 int BVS::nameThisThread(std::string threadName)
 {
+	currentThreadName = threadName;
+
 #if (defined __unix__ && defined BVS_THREAD_NAMES)
 	prctl(PR_SET_NAME, ("bvs:"+threadName).c_str());
 	if (errno)
@@ -32,3 +41,10 @@ int BVS::nameThisThread(std::string threadName)
 
 	return 0;
 }
+
+
+
+const std::string& BVS::getThreadName()
+{
+	return currentThreadName;
+}
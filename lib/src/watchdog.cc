@@ -0,0 +1,236 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <mutex>
+
+#if defined(__linux__) && !defined(__ANDROID__)
+#include <execinfo.h>
+#include <pthread.h>
+#include <signal.h>
+#define BVS_WATCHDOG_STACKS
+#endif
+
+#include "watchdog.h"
+#include "bvs/utils.h"
+
+using BVS::Watchdog;
+using BVS::ModuleData;
+
+
+
+#ifdef BVS_WATCHDOG_STACKS
+/** Captured stack, filled by the signal handler of the stalled thread. */
+static void* stackFrames[64];
+
+/** Number of captured frames. */
+static int stackFrameCount = 0;
+
+/** Set by the signal handler after capturing the stack. */
+static std::atomic<bool> stackCaptured{false};
+
+/** SIGUSR2 action installed before the watchdog's. */
+static struct sigaction previousAction;
+
+
+
+/** Capture stack of the interrupted thread.
+ * Only signals queued by the watchdog (carrying stackFrames) are handled,
+ * others are passed on to the previous action.
+ */
+static void captureStack(int signal, siginfo_t* info, void* context)
+{
+	if (info!=nullptr && info->si_code==SI_QUEUE && info->si_value.sival_ptr==stackFrames) {
+		stackFrameCount = backtrace(stackFrames, 64);
+		stackCaptured.store(true, std::memory_order_release);
+		return;
+	}
+
+	if (previousAction.sa_flags & SA_SIGINFO) {
+		previousAction.sa_sigaction(signal, info, context);
+	} else if (previousAction.sa_handler==SIG_DFL) {
+		sigaction(signal, &previousAction, nullptr);
+		raise(signal);
+	} else if (previousAction.sa_handler!=SIG_IGN) {
+		previousAction.sa_handler(signal);
+	}
+}
+
+
+
+/** Install captureStack for SIGUSR2, keeps the previous action. */
+static void installStackHandler()
+{
+	// first backtrace() call loads libgcc, which must not happen inside the handler
+	backtrace(stackFrames, 1);
+	struct sigaction action{};
+	action.sa_sigaction = captureStack;
+	sigemptyset(&action.sa_mask);
+	action.sa_flags = SA_RESTART | SA_SIGINFO;
+	sigaction(SIGUSR2, &action, &previousAction);
+}
+#endif //BVS_WATCHDOG_STACKS
+
+
+
+Watchdog::Watchdog(ModuleTable& table, std::chrono::milliseconds interval, unsigned int shutdownFactor, std::function<void()> shutdownHandler)
+	: logger{"Watchdog"},
+	table(table),
+	interval{interval},
+	shutdownFactor{shutdownFactor},
+	shutdownHandler{shutdownHandler},
+	shutdownCalled{false},
+	mutex{},
+	condition{},
+	running{false},
+	modules{},
+	thread{}
+{ }
+
+
+
+Watchdog::~Watchdog()
+{
+	{
+		std::lock_guard<std::mutex> lock{mutex};
+		running = false;
+	}
+	condition.notify_all();
+	if (thread.joinable()) thread.join();
+}
+
+
+
+Watchdog& Watchdog::watch(std::shared_ptr<ModuleData> data)
+{
+	if (data->index<0 || table[data->index].budget.count()==0) return *this;
+
+	std::lock_guard<std::mutex> lock{mutex};
+	modules.push_back(data);
+
+	if (!running) {
+#ifdef BVS_WATCHDOG_STACKS
+		// once per process, a second install would chain to itself
+		static std::once_flag installed;
+		std::call_once(installed, installStackHandler);
+#endif //BVS_WATCHDOG_STACKS
+		running = true;
+		thread = std::thread{&Watchdog::run, this};
+	}
+
+	return *this;
+}
+
+
+
+Watchdog& Watchdog::unwatch(const std::string& id)
+{
+	std::lock_guard<std::mutex> lock{mutex};
+	modules.erase(std::remove_if(modules.begin(), modules.end(),
+				[&](std::shared_ptr<ModuleData>& data) { return data->id==id; }),
+			modules.end());
+
+	return *this;
+}
+
+
+
+void Watchdog::run()
+{
+	nameThisThread("watchdog");
+	LOG(3, "started, checking every " << interval.count() << "ms!");
+
+	std::unique_lock<std::mutex> lock{mutex};
+	while (running) {
+		condition.wait_for(lock, interval);
+		if (!running) break;
+
+		auto now = std::chrono::steady_clock::now();
+		bool hung = false;
+		std::shared_ptr<ModuleData> stalled;
+		for (auto& data: modules) hung = check(data, now, stalled) || hung;
+
+		// unlocked, waiting for the stack must not block unwatch() and the
+		// handler may well stop the system (and this watchdog)
+		bool shutdown = hung && !shutdownCalled;
+		if (stalled || shutdown) {
+			shutdownCalled = shutdownCalled || shutdown;
+			lock.unlock();
+			if (stalled) logStack(*stalled);
+			if (shutdown) shutdownHandler();
+			lock.lock();
+		}
+	}
+}
+
+
+
+bool Watchdog::check(const std::shared_ptr<ModuleData>& module, std::chrono::steady_clock::time_point now,
+		std::shared_ptr<ModuleData>& stalled)
+{
+	const ModuleData& data = *module;
+	ModuleState& state = table[data.index];
+	long long start = state.executionStart.load(std::memory_order_acquire);
+	if (start==0) return false;
+
+	auto running = now - std::chrono::steady_clock::time_point{std::chrono::nanoseconds{start}};
+	if (state.overrun.load()) {
+		if (shutdownFactor==0 || shutdownCalled || running<=shutdownFactor*state.budget) return false;
+		LOG(1, "module '" << data.id << "' in pool '" << data.poolName << "' hangs for "
+				<< std::chrono::duration_cast<std::chrono::milliseconds>(running).count()
+				<< "ms (watchdogShutdownFactor: " << shutdownFactor << "x budgetMs), calling shutdown handler!");
+		return true;
+	}
+	if (running<=state.budget) return false;
+
+	state.overrun = true;
+	LOG(1, "module '" << data.id << "' in pool '" << data.poolName << "' running for "
+			<< std::chrono::duration_cast<std::chrono::milliseconds>(running).count()
+			<< "ms (budgetMs: " << state.budget.count() << ")!");
+	if (!stalled && requestStack(data)) stalled = module;
+
+	switch (state.budgetAction) {
+		case BudgetAction::LOG: break;
+		case BudgetAction::SKIP: LOG(1, "skipping next round of '" << data.id << "' once execute() returns!"); break;
+		case BudgetAction::FAIL: LOG(1, "marking '" << data.id << "' as FAIL once execute() returns!"); break;
+		case BudgetAction::SHUTDOWN: LOG(1, "requesting shutdown because of '" << data.id << "' once execute() returns!"); break;
+	}
+
+	return false;
+}
+
+
+
+bool Watchdog::requestStack(const ModuleData& data)
+{
+#ifdef BVS_WATCHDOG_STACKS
+	stackCaptured = false;
+	union sigval value;
+	value.sival_ptr = stackFrames;
+	return pthread_sigqueue(table[data.index].nativeThread, SIGUSR2, value)==0;
+#else
+	(void) data;
+	return false;
+#endif //BVS_WATCHDOG_STACKS
+}
+
+
+
+void Watchdog::logStack(const ModuleData& data)
+{
+#ifdef BVS_WATCHDOG_STACKS
+	for (int i=0; i<100 && !stackCaptured.load(std::memory_order_acquire); i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	if (!stackCaptured) {
+		LOG(1, "could not capture stack of '" << data.id << "'!");
+		return;
+	}
+
+	char** symbols = backtrace_symbols(stackFrames, stackFrameCount);
+	// skip the signal handler and the signal trampoline
+	for (int i=2; i<stackFrameCount && symbols!=nullptr; i++)
+		LOG(1, "[bt]: (" << i-2 << ") " << symbols[i]);
+	free(symbols);
+#else
+	(void) data;
+#endif //BVS_WATCHDOG_STACKS
+}
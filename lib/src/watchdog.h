@@ -0,0 +1,109 @@
+#ifndef BVS_WATCHDOG_H
+#define BVS_WATCHDOG_H
+
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bvs/logger.h"
+#include "controldata.h"
+
+
+
+/** BVS namespace, contains all library stuff. */
+namespace BVS
+{
+	/** Stall watchdog, checks module executions against their time budgets.
+	 * Modules with a budget (see ModuleState::budget) are checked every
+	 * interval. If an execution runs longer than its budget, the watchdog
+	 * logs the module, its pool and the time it has been running, captures
+	 * the stack of the executing thread (Linux only, using SIGUSR2, other
+	 * SIGUSR2 signals are passed on to the previously installed handler)
+	 * and marks the execution as overrun, so the module's budget action is
+	 * applied once execute() returns. Only the stack of the first module
+	 * found stalling in a check is captured.
+	 *
+	 * Thus, a stall is detected after at most budget + interval.
+	 *
+	 * SKIP and FAIL cannot interrupt a running execute(), a module that
+	 * never returns would freeze the system. Therefore, once an execution
+	 * runs longer than shutdownFactor times its budget, the watchdog calls
+	 * the shutdown handler from its own thread (once).
+	 */
+	class Watchdog
+	{
+		public:
+			/** Create watchdog, the thread is started by the first watch().
+			 * @param[in] table Module table holding the states of watched modules.
+			 * @param[in] interval Check interval.
+			 * @param[in] shutdownFactor Call shutdownHandler after this many budgets (0 = never).
+			 * @param[in] shutdownHandler Called from the watchdog thread if an execution hangs.
+			 */
+			Watchdog(ModuleTable& table, std::chrono::milliseconds interval, unsigned int shutdownFactor, std::function<void()> shutdownHandler);
+
+			/** Stop watchdog thread. */
+			~Watchdog();
+
+			/** Watch a started module (only if it has a budget).
+			 * @param[in] data Module meta data, its state is found by ModuleData::index.
+			 * @return Reference to object.
+			 */
+			Watchdog& watch(std::shared_ptr<ModuleData> data);
+
+			/** Stop watching a module.
+			 * @param[in] id Module id.
+			 * @return Reference to object.
+			 */
+			Watchdog& unwatch(const std::string& id);
+
+		private:
+			/** Watchdog thread. */
+			void run();
+
+			/** Check a module's execution against its budget.
+			 * @param[in] module Module meta data.
+			 * @param[in] now Current time (steady clock).
+			 * @param[in,out] stalled Module whose stack was requested (set if empty and a stack was requested).
+			 * @return True if the execution hangs (shutdownFactor exceeded).
+			 */
+			bool check(const std::shared_ptr<ModuleData>& module, std::chrono::steady_clock::time_point now,
+					std::shared_ptr<ModuleData>& stalled);
+
+			/** Signal the thread executing a module to capture its stack.
+			 * Called with the mutex held, so the module cannot be stopped meanwhile.
+			 * @param[in] data Module meta data.
+			 * @return True if the signal was sent.
+			 */
+			bool requestStack(const ModuleData& data);
+
+			/** Wait for the requested stack and log it (without holding the mutex).
+			 * @param[in] data Module meta data.
+			 */
+			void logStack(const ModuleData& data);
+
+			Logger logger; /**< Logger metadata. */
+			ModuleTable& table; /**< Module states. */
+			std::chrono::milliseconds interval; /**< Check interval. */
+			unsigned int shutdownFactor; /**< Budgets after which an execution hangs (0 = never). */
+			std::function<void()> shutdownHandler; /**< Called if an execution hangs. */
+			bool shutdownCalled; /**< Shutdown handler was called. */
+			std::mutex mutex; /**< Protects modules and running. */
+			std::condition_variable condition; /**< Wakes watchdog thread on shutdown. */
+			bool running; /**< Watchdog thread should keep running. */
+			ModuleDataVector modules; /**< Watched modules. */
+			std::thread thread; /**< Watchdog thread. */
+
+			Watchdog(const Watchdog&) = delete; /**< -Weffc++ */
+			Watchdog& operator=(const Watchdog&) = delete; /**< -Weffc++ */
+	};
+} // namespace BVS
+
+
+
+#endif //BVS_WATCHDOG_H
+
@@ -0,0 +1,146 @@
+#include <algorithm>
+#include <chrono>
+#include <functional>
+
+#include "BVSSyntheticModule.h"
+
+
+
+namespace
+{
+	/** Spin through a dependent chain of multiply-adds.
+	 * @param[in] iterations Number of iterations.
+	 * @return Result, so the work cannot be optimized away.
+	 */
+	unsigned long long spin(unsigned long long iterations)
+	{
+		unsigned long long x = iterations;
+		for (unsigned long long i=0; i<iterations; i++) x = x*6364136223846793005ull + 1442695040888963407ull;
+		return x;
+	}
+
+
+
+	/** Iterations of spin() per microsecond, measured once per process.
+	 * @return Calibrated rate.
+	 */
+	double iterationsPerMicrosecond()
+	{
+		static const double rate = []() {
+			volatile unsigned long long sink = 0;
+			unsigned long long iterations = 1<<16;
+			std::chrono::nanoseconds elapsed{0};
+			while (elapsed<std::chrono::milliseconds{10}) {
+				iterations *= 2;
+				std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+				sink = sink + spin(iterations);
+				elapsed = std::chrono::steady_clock::now() - start;
+			}
+			return iterations*1000.0/elapsed.count();
+		}();
+
+		return rate;
+	}
+}
+
+
+
+BVSSyntheticModule::BVSSyntheticModule(BVS::ModuleInfo info, const BVS::Info& bvs)
+	: BVS::Module()
+	, info(info)
+	, logger(info.id)
+	, bvs(bvs)
+	, distribution(Distribution::CONSTANT)
+	, duration(getOption<double>("durationUs", 100))
+	, spread(getOption<double>("spreadUs", 0))
+	, payloadSize(getOption<size_t>("payloadBytes", 1024))
+	, allocationSize(getOption<size_t>("allocationKB", 0)*1024)
+	, random(getOption<unsigned int>("seed", 0) ? getOption<unsigned int>("seed", 0) : std::hash<std::string>{}(info.id))
+	, memory(getOption<size_t>("memoryKB", 0)*1024)
+	, payload(payloadSize)
+	, received()
+	, inputs()
+	, outputs()
+	, sink(0)
+{
+	std::string name = getOption<std::string>("distribution", "CONSTANT");
+	if (name=="UNIFORM") distribution = Distribution::UNIFORM;
+	else if (name=="NORMAL") distribution = Distribution::NORMAL;
+	else if (name=="EXPONENTIAL") distribution = Distribution::EXPONENTIAL;
+	else if (name!="CONSTANT") LOG(0, "unknown distribution '" << name << "' (Possible: CONSTANT UNIFORM NORMAL EXPONENTIAL)");
+
+	// connectors have to be created in the constructor to be registered
+	unsigned int inputCount = getOption<unsigned int>("inputs", 0);
+	unsigned int outputCount = getOption<unsigned int>("outputs", 1);
+	received.resize(inputCount);
+	for (unsigned int i=0; i<inputCount; i++)
+		inputs.emplace_back(new BVS::Connector<Payload>{"in" + std::to_string(i), BVS::ConnectorType::INPUT});
+	for (unsigned int i=0; i<outputCount; i++)
+		outputs.emplace_back(new BVS::Connector<Payload>{"out" + std::to_string(i), BVS::ConnectorType::OUTPUT});
+
+	LOG(3, "calibrated " << iterationsPerMicrosecond() << " iterations/us");
+}
+
+
+
+BVSSyntheticModule::~BVSSyntheticModule() noexcept
+{
+
+}
+
+
+
+BVS::Status BVSSyntheticModule::execute()
+{
+	for (size_t i=0; i<inputs.size(); i++) inputs[i]->receive(received[i]);
+
+	burn(nextDuration());
+
+	// touch working set (one byte per cache line) and temporary allocation
+	for (size_t i=0; i<memory.size(); i+=64) memory[i]++;
+	if (allocationSize) {
+		std::unique_ptr<char[]> allocation{new char[allocationSize]};
+		for (size_t i=0; i<allocationSize; i+=4096) allocation[i] = static_cast<char>(i);
+		sink = sink + allocation[allocationSize/2];
+	}
+
+	if (!payload.empty()) payload[0]++;
+	for (auto& output: outputs) output->send(payload);
+
+	return BVS::Status::OK;
+}
+
+
+
+BVS::Status BVSSyntheticModule::debugDisplay()
+{
+	return BVS::Status::OK;
+}
+
+
+
+double BVSSyntheticModule::nextDuration()
+{
+	double next = duration;
+	switch (distribution) {
+		case Distribution::CONSTANT: break;
+		case Distribution::UNIFORM: next = std::uniform_real_distribution<double>{duration-spread, duration+spread}(random); break;
+		case Distribution::NORMAL: next = std::normal_distribution<double>{duration, spread}(random); break;
+		case Distribution::EXPONENTIAL: next = std::exponential_distribution<double>{1.0/std::max(duration, 1.0)}(random); break;
+	}
+
+	return std::max(next, 0.0);
+}
+
+
+
+void BVSSyntheticModule::burn(double microseconds)
+{
+	sink = sink + spin(static_cast<unsigned long long>(microseconds*iterationsPerMicrosecond()));
+}
+
+
+
+/** This calls a macro to create needed module utilities. */
+BVS_MODULE_UTILITIES(BVSSyntheticModule)
+
@@ -0,0 +1,101 @@
+#ifndef BVSSYNTHETICMODULE_H
+#define BVSSYNTHETICMODULE_H
+
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "bvs/module.h"
+
+
+
+/** Synthetic load generator for scale testing.
+ * Burns a configurable amount of CPU, touches and allocates memory, consumes
+ * its inputs and sends payloads on its outputs. Together with the topology
+ * generator 'bvs-topology', this allows to build large, reproducible graphs
+ * to measure the framework itself.
+ *
+ * The CPU work is calibrated once per process, so a given duration always
+ * means the same amount of work, no matter how long the module waits for a
+ * core.
+ *
+ * Dependencies: none
+ * Inputs: in0 ... in<inputs-1> (std::vector<char>)
+ * Outputs: out0 ... out<outputs-1> (std::vector<char>)
+ * Configuration Options: please see BVSSyntheticModule.conf
+ */
+class BVSSyntheticModule : public BVS::Module
+{
+	public:
+		/** Synthetic module constructor.
+		 * @param[in] info Module information, set by framework.
+		 * @param[in] bvs Reference to framework info for config option retrieval.
+		 */
+		BVSSyntheticModule(BVS::ModuleInfo info, const BVS::Info& bvs);
+
+		/** Synthetic module destructor. */
+		~BVSSyntheticModule() noexcept;
+
+		/** Receive inputs, burn CPU, use memory and send outputs.
+		 * @return Module's status.
+		 */
+		BVS::Status execute();
+
+		/** UNUSED
+		 * @return Module's status.
+		 */
+		BVS::Status debugDisplay();
+
+	private:
+		/** Payload type of all connectors. */
+		typedef std::vector<char> Payload;
+
+		/** Distribution of execution durations. */
+		enum class Distribution { CONSTANT, UNIFORM, NORMAL, EXPONENTIAL };
+
+		/** Get option from own section, falling back to [BVSSyntheticModule].
+		 * @param[in] option Option name.
+		 * @param[in] defaultValue Value if neither section sets it.
+		 * @return Option value.
+		 */
+		template<typename T> T getOption(const std::string& option, T defaultValue) const
+		{
+			return bvs.config.getValue<T>(info.conf + "." + option,
+					bvs.config.getValue<T>("BVSSyntheticModule." + option, defaultValue));
+		}
+
+		/** Draw the duration of the next execution.
+		 * @return Duration in microseconds.
+		 */
+		double nextDuration();
+
+		/** Burn CPU.
+		 * @param[in] microseconds Calibrated duration.
+		 */
+		void burn(double microseconds);
+
+		const BVS::ModuleInfo info; /**< Module metadata, set by framework. */
+		BVS::Logger logger; /**< Logger instance. */
+		const BVS::Info& bvs; /**< Info reference. */
+
+		Distribution distribution; /**< Duration distribution. */
+		const double duration; /**< Mean duration in microseconds. */
+		const double spread; /**< Spread of the duration in microseconds. */
+		const size_t payloadSize; /**< Bytes sent per output. */
+		const size_t allocationSize; /**< Bytes allocated (and freed) per execution. */
+		std::mt19937 random; /**< Random engine, seeded for reproducible runs. */
+		std::vector<char> memory; /**< Working set touched each execution. */
+		Payload payload; /**< Outgoing payload. */
+		std::vector<Payload> received; /**< Last received payloads. */
+		std::vector<std::unique_ptr<BVS::Connector<Payload>>> inputs; /**< Input connectors. */
+		std::vector<std::unique_ptr<BVS::Connector<Payload>>> outputs; /**< Output connectors. */
+		volatile unsigned long long sink; /**< Keeps burned work from being optimized away. */
+
+		BVSSyntheticModule(const BVSSyntheticModule&) = delete; /**< -Weffc++ */
+		BVSSyntheticModule& operator=(const BVSSyntheticModule&) = delete; /**< -Weffc++ */
+};
+
+
+
+#endif //BVSSYNTHETICMODULE_H
+
@@ -0,0 +1,45 @@
+#include "bvs/connector.h"
+#include "bvs/module.h"
+
+
+
+/** Module with one input and one output, used by the loader test. */
+class BVSTestConnectors : public BVS::Module
+{
+	public:
+		/** Construct module (signature required by the framework). */
+		BVSTestConnectors(BVS::ModuleInfo, const BVS::Info&)
+			: BVS::Module(),
+			input{"input", BVS::ConnectorType::INPUT},
+			output{"output", BVS::ConnectorType::OUTPUT}
+		{ }
+
+		/** Pass the input on, incremented.
+		 * @return Always OK.
+		 */
+		BVS::Status execute()
+		{
+			int value = 0;
+			input.receive(value);
+			output.send(value+1);
+			return BVS::Status::OK;
+		}
+
+		/** UNUSED
+		 * @return Always OK.
+		 */
+		BVS::Status debugDisplay() { return BVS::Status::OK; }
+
+	private:
+		BVS::Connector<int> input; /**< Input. */
+		BVS::Connector<int> output; /**< Output. */
+
+		BVSTestConnectors(const BVSTestConnectors&) = delete; /**< -Weffc++ */
+		BVSTestConnectors& operator=(const BVSTestConnectors&) = delete; /**< -Weffc++ */
+};
+
+
+
+/** This calls a macro to create needed module utilities. */
+BVS_MODULE_UTILITIES(BVSTestConnectors)
+
@@ -0,0 +1,64 @@
+#include <cstdlib>
+#include <iostream>
+#include <memory>
+
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "bvs/bvs.h"
+#include "test.h"
+
+
+
+/** Step through rounds with allocationStrict in a child process.
+ * The unforked master runs in the calling thread, its round lasts from
+ * round sync to round sync, so allocating between two steps allocates in
+ * the master's round.
+ * @param[in] allocate Allocate once after the warmup rounds.
+ * @return Exit status of the child.
+ */
+static int stepRounds(bool allocate)
+{
+	pid_t pid = fork();
+	if (pid==0) {
+		const char* argv[] = {"allocationstricttest",
+			"--bvs.options=BVS.allocationTracking=ON:BVS.allocationStrict=ON:BVS.allocationWarmup=3"};
+		BVS::BVS* bvs = new BVS::BVS{2, argv};
+		bvs->enableLogConsole(std::cerr);
+		bvs->setLogSystemVerbosity(1);
+		bvs->loadModule("a(BVSBenchNoop)");
+		bvs->loadModule("b(BVSBenchNoop)", true);
+		bvs->start(false);
+
+		std::unique_ptr<int> allocation;
+		for (int i=0; i<20; i++) {
+			if (allocate && i==10) allocation.reset(new int{i});
+			bvs->step();
+		}
+
+		bvs->quit();
+		delete bvs;
+		_exit(EXIT_SUCCESS);
+	}
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return status;
+}
+
+
+
+int main()
+{
+	// steady rounds of the framework do not allocate
+	int status = stepRounds(false);
+	CHECK(WIFEXITED(status) && WEXITSTATUS(status)==EXIT_SUCCESS);
+
+	// an allocation in a steady round stops the system
+	std::cerr << "expecting an allocation error:" << std::endl;
+	status = stepRounds(true);
+	CHECK(!WIFEXITED(status) || WEXITSTATUS(status)!=EXIT_SUCCESS);
+
+	return BVS_TEST_RESULT;
+}
+
@@ -0,0 +1,63 @@
+#include <cstdlib>
+#include <memory>
+#include <thread>
+
+#include "allocationtracker.h"
+#include "test.h"
+
+using BVS::AllocationTracker;
+using BVS::Allocations;
+
+
+
+int main()
+{
+	bool tracking = AllocationTracker::available();
+#ifdef BVS_ALLOCATION_TRACKING
+	CHECK(tracking);
+#else
+	CHECK(!tracking);
+#endif //BVS_ALLOCATION_TRACKING
+	unsigned long long expected = tracking ? 1 : 0;
+
+	// operator new and new[] are counted with their size
+	Allocations start = AllocationTracker::thread();
+	std::unique_ptr<char> single{new char};
+	Allocations allocations = AllocationTracker::since(start);
+	CHECK_EQUAL(allocations.count, expected);
+	CHECK_EQUAL(allocations.bytes, expected);
+
+	start = AllocationTracker::thread();
+	std::unique_ptr<char[]> array{new char[100]};
+	allocations = AllocationTracker::since(start);
+	CHECK_EQUAL(allocations.count, expected);
+	CHECK_EQUAL(allocations.bytes, 100*expected);
+
+	// freeing does not count, neither does malloc
+	start = AllocationTracker::thread();
+	single.reset();
+	array.reset();
+	void* memory = std::malloc(100);
+	std::free(memory);
+	allocations = AllocationTracker::since(start);
+	CHECK_EQUAL(allocations.count, 0ull);
+	CHECK_EQUAL(allocations.bytes, 0ull);
+
+	// counters are per thread
+	Allocations other{0, 0};
+	start = AllocationTracker::thread();
+	std::thread thread{[&]() {
+		Allocations threadStart = AllocationTracker::thread();
+		for (int i=0; i<10; i++) std::unique_ptr<int>{new int{i}};
+		other = AllocationTracker::since(threadStart);
+	}};
+	thread.join();
+	allocations = AllocationTracker::since(start);
+	CHECK_EQUAL(other.count, 10*expected);
+	CHECK_EQUAL(other.bytes, 10*sizeof(int)*expected);
+	// starting the thread allocates its state in this thread, the thread's allocations are not seen here
+	CHECK(allocations.count<=expected);
+
+	return BVS_TEST_RESULT;
+}
+
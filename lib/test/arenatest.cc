@@ -0,0 +1,101 @@
+#include <cstdint>
+#include <vector>
+
+#include "bvs/arena.h"
+#include "test.h"
+
+using BVS::Arena;
+using BVS::ArenaAllocator;
+
+
+
+/** Check if a pointer is aligned. */
+static bool aligned(const void* pointer, size_t alignment)
+{
+	return reinterpret_cast<uintptr_t>(pointer)%alignment==0;
+}
+
+
+
+int main()
+{
+	// chunks are requested lazily, with a minimal size
+	{
+		Arena arena{0};
+		CHECK_EQUAL(arena.capacity(), 0u);
+		CHECK_EQUAL(arena.used(), 0u);
+		arena.allocate(1);
+		CHECK_EQUAL(arena.capacity(), 64u);
+		CHECK_EQUAL(arena.used(), 1u);
+	}
+
+	// allocations are aligned and do not overlap
+	{
+		Arena arena{1024};
+		char* a = static_cast<char*>(arena.allocate(3, 1));
+		char* b = static_cast<char*>(arena.allocate(8, 8));
+		char* c = static_cast<char*>(arena.allocate(16, 64));
+		char* d = static_cast<char*>(arena.allocate(1));
+		CHECK(aligned(b, 8));
+		CHECK(aligned(c, 64));
+		CHECK(aligned(d, alignof(std::max_align_t)));
+		CHECK(a+3<=b);
+		CHECK(b+8<=c);
+		CHECK(c+16<=d);
+		CHECK_EQUAL(arena.used(), 28u);
+		CHECK_EQUAL(arena.capacity(), 1024u);
+
+		// reset reuses the chunk from its start and keeps the statistics
+		arena.reset();
+		CHECK_EQUAL(arena.used(), 0u);
+		CHECK_EQUAL(arena.lastUsed(), 28u);
+		CHECK_EQUAL(arena.highWaterMark(), 28u);
+		CHECK(arena.allocate(3, 1)==a);
+		arena.reset();
+		CHECK_EQUAL(arena.lastUsed(), 3u);
+		CHECK_EQUAL(arena.highWaterMark(), 28u);
+	}
+
+	// a round spilling into more chunks is merged into one chunk, the next round fits
+	{
+		Arena arena{256};
+		std::vector<void*> round;
+		for (int i=0; i<10; i++) round.push_back(arena.allocate(100));
+		size_t capacity = arena.capacity();
+		CHECK(capacity>=1000u);
+		arena.reset();
+		CHECK_EQUAL(arena.capacity(), capacity);
+		char* first = static_cast<char*>(arena.allocate(100));
+		for (int i=1; i<10; i++) arena.allocate(100);
+		CHECK_EQUAL(arena.capacity(), capacity);
+		CHECK(static_cast<char*>(arena.allocate(1))<first+capacity);
+		arena.reset();
+		CHECK(arena.allocate(100)==first);
+	}
+
+	// allocations larger than a chunk get a chunk of their own
+	{
+		Arena arena{64};
+		void* large = arena.allocate(4096, 128);
+		CHECK(aligned(large, 128));
+		CHECK(arena.capacity()>=4096u);
+	}
+
+	// standard containers through ArenaAllocator
+	{
+		Arena arena{64};
+		Arena other{64};
+		std::vector<int, ArenaAllocator<int>> values{ArenaAllocator<int>{arena}};
+		for (int i=0; i<1000; i++) values.push_back(i);
+		bool correct = true;
+		for (int i=0; i<1000; i++) correct = correct && values[i]==i;
+		CHECK(correct);
+		CHECK(arena.used()>=1000*sizeof(int));
+		CHECK(aligned(values.data(), alignof(int)));
+		CHECK(ArenaAllocator<int>{arena}==ArenaAllocator<char>{arena});
+		CHECK(ArenaAllocator<int>{arena}!=ArenaAllocator<int>{other});
+	}
+
+	return BVS_TEST_RESULT;
+}
+
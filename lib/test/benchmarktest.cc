@@ -0,0 +1,91 @@
+#include <chrono>
+#include <memory>
+#include <string>
+
+#include "benchmarkrecorder.h"
+#include "test.h"
+
+using BVS::BenchmarkRecorder;
+using BVS::BenchmarkSummary;
+using BVS::ControlFlag;
+using BVS::DurationSummary;
+using BVS::ModuleData;
+using BVS::ModuleRecordVector;
+using BVS::ModuleTable;
+using BVS::PoolData;
+using BVS::PoolPlan;
+
+
+
+/** Check all values of a duration summary. */
+static bool summaryEquals(const DurationSummary& d, double mean, double p50, double p90, double p99, double max)
+{
+	return d.mean==mean && d.p50==p50 && d.p90==p90 && d.p99==p99 && d.max==max;
+}
+
+
+
+int main()
+{
+	ModuleTable table{1};
+	auto data = std::make_shared<ModuleData>("m\"1", "", "m", "", nullptr, nullptr, "p\\1", BVS::ConnectorMap{});
+	data->index = table.acquire(nullptr, nullptr);
+	auto& module = table[data->index];
+	auto pool = std::make_shared<PoolData>("p\\1", ControlFlag::WAIT);
+	pool->plan = std::make_shared<ModuleRecordVector>(ModuleRecordVector{
+			{data->index, data, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr}});
+	PoolPlan poolPlan{pool};
+
+	// rounds of 1..100us (shuffled), warmup rounds are not recorded
+	BenchmarkRecorder recorder{5, 100, poolPlan};
+	for (unsigned long long round=0; round<105; round++) {
+		std::chrono::nanoseconds duration{round<5 ? 1000000 : ((round-5)*37%100 + 1)*1000};
+		module.duration = duration/2;
+		pool->busy = duration/4;
+		pool->round = round;
+		CHECK(!recorder.complete());
+		recorder.record(poolPlan, table, round, duration);
+	}
+	CHECK(recorder.complete());
+
+	// nearest rank percentiles
+	BenchmarkSummary summary = recorder.summarize();
+	CHECK_EQUAL(summary.warmupRounds, 5u);
+	CHECK_EQUAL(summary.rounds, 100u);
+	CHECK(summaryEquals(summary.roundTime, 50.5, 50, 90, 99, 100));
+	CHECK(summaryEquals(summary.modules["m\"1"], 25.25, 25, 45, 49.5, 50));
+	CHECK(summaryEquals(summary.pools["p\\1"], 12.625, 12.5, 22.5, 24.75, 25));
+	CHECK(summaryEquals(summary.poolIdle["p\\1"], 37.875, 37.5, 67.5, 74.25, 75));
+
+	// a pool that did not take part in a round is not sampled
+	BenchmarkRecorder partial{0, 2, poolPlan};
+	pool->round = 0;
+	pool->busy = std::chrono::microseconds{5};
+	module.duration = std::chrono::microseconds{3};
+	partial.record(poolPlan, table, 0, std::chrono::microseconds{7});
+	partial.record(poolPlan, table, 1, std::chrono::microseconds{9});
+	summary = partial.summarize();
+	CHECK(summaryEquals(summary.roundTime, 8, 7, 9, 9, 9));
+	CHECK(summaryEquals(summary.pools["p\\1"], 5, 5, 5, 5, 5));
+	CHECK(summaryEquals(summary.poolIdle["p\\1"], 2, 2, 2, 2, 2));
+	CHECK(summaryEquals(summary.modules["m\"1"], 3, 3, 3, 3, 3));
+
+	// no rounds
+	summary = BenchmarkRecorder{0, 0, poolPlan}.summarize();
+	CHECK_EQUAL(summary.rounds, 0u);
+	CHECK(summaryEquals(summary.roundTime, 0, 0, 0, 0, 0));
+
+	// ids are escaped in JSON keys
+	summary.pools.clear();
+	summary.poolIdle.clear();
+	summary.modules.clear();
+	summary.pools["p\"\\\n\x01"] = {1, 1, 1, 1, 1};
+	summary.poolIdle["p\"\\\n\x01"] = {2, 2, 2, 2, 2};
+	summary.modules["m\"1"] = {3, 3, 3, 3, 3};
+	std::string json = summary.json();
+	CHECK(json.find("\"pools\":{\"p\\\"\\\\\\n\\u0001\":{\"busy\":{\"mean_us\":1.000")!=std::string::npos);
+	CHECK(json.find("\"modules\":{\"m\\\"1\":{\"mean_us\":3.000")!=std::string::npos);
+
+	return BVS_TEST_RESULT;
+}
+
@@ -0,0 +1,114 @@
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+#include "binarylogwriter.h"
+#include "test.h"
+
+using BVS::BinaryLogHeader;
+using BVS::BinaryLogWriter;
+using BVS::Logger;
+using BVS::LogRecord;
+using BVS::LogSite;
+
+
+
+/** Read a whole file. */
+static std::string readFile(const char* file)
+{
+	std::ifstream in{file, std::ios::binary};
+	std::stringstream content;
+	content << in.rdbuf();
+	return content.str();
+}
+
+
+
+/** Decode a binary log with bvs-logdecode (built next to the test). */
+static std::string decode(const std::string& options)
+{
+	std::string output;
+	FILE* pipe = popen(("./bvs-logdecode " + options).c_str(), "r");
+	if (!pipe) return output;
+	char buffer[256];
+	while (fgets(buffer, sizeof(buffer), pipe)) output += buffer;
+	CHECK_EQUAL(pclose(pipe), 0);
+	return output;
+}
+
+
+
+int main()
+{
+	const char* file = "binarylogtest.blog";
+	Logger logger{"Test"};
+	Logger other{"OtherLogger"};
+	static LogSite site{"test.cc", 42, "\"value \" << value"};
+	static LogSite second{"other.cc", 7, "pointer"};
+
+	{
+		BinaryLogWriter writer{file, 4096};
+		CHECK(writer.getError().empty());
+
+		LogRecord record;
+		record << "value " << 42 << ' ' << -7L << ' ' << 3u << ' ' << 1.5 << ' ' << true << ' ' << std::string{"end"};
+		CHECK(writer.write(logger, site, 2, record.arguments));
+		CHECK(site.id!=0u);
+		record.clear() << "again";
+		CHECK(writer.write(logger, site, 1, record.arguments));
+		record.clear() << static_cast<const void*>(reinterpret_cast<void*>(0xabc));
+		CHECK(writer.write(other, second, 3, record.arguments));
+		CHECK_EQUAL(writer.getDropped(), 0ull);
+	}
+
+	// the file is truncated to the used size and starts with the header
+	std::string binary = readFile(file);
+	CHECK(binary.size()>sizeof(BinaryLogHeader));
+	CHECK(binary.size()<4096u);
+	BinaryLogHeader header;
+	binary.copy(reinterpret_cast<char*>(&header), sizeof(header));
+	CHECK_EQUAL(std::string{header.magic}, "BVSBLOG");
+	CHECK_EQUAL(header.version, BVS::binaryLogVersion);
+	CHECK_EQUAL(header.headerSize, sizeof(BinaryLogHeader));
+
+	// decoding restores the messages and call sites (logger names are padded to the longest seen so far)
+	CHECK_EQUAL(decode(file),
+			"[2|Test] value 42 -7 3 1.5 true end\n"
+			"[1|Test] again\n"
+			"[3|OtherLogger] 0xabc\n");
+	CHECK_EQUAL(decode(std::string{"-s "} + file),
+			"    1 test.cc:42: \"value \" << value\n"
+			"    2 other.cc:7: pointer\n");
+
+	// a truncated record ends the log
+	binary.resize(binary.size()-3);
+	std::ofstream{file, std::ios::binary} << binary;
+	CHECK_EQUAL(decode(file), "[2|Test] value 42 -7 3 1.5 true end\n[1|Test] again\n");
+
+	// messages beyond the capacity are dropped and counted, the file keeps its full size
+	{
+		BinaryLogWriter writer{file, 4096};
+		LogRecord record;
+		record << std::string(5000, 'x');
+		CHECK(!writer.write(logger, site, 1, record.arguments));
+		CHECK_EQUAL(writer.getDropped(), 1ull);
+	}
+	CHECK_EQUAL(readFile(file).size(), 4096u);
+	CHECK_EQUAL(decode(file), "");
+
+	// manipulators store nothing, values keep their raw format
+	LogRecord manipulated;
+	manipulated << std::fixed << std::setprecision(1) << std::setw(4) << 1.5;
+	CHECK(manipulated.arguments==(LogRecord{} << 1.5).arguments);
+
+	// a writer on an unusable path drops everything
+	BinaryLogWriter invalid{"/nonexistent/binarylogtest.blog", 4096};
+	CHECK(!invalid.getError().empty());
+	LogRecord record;
+	CHECK(!invalid.write(logger, site, 1, record.arguments));
+	std::remove(file);
+
+	return BVS_TEST_RESULT;
+}
+
@@ -0,0 +1,133 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <new>
+
+#include "bvs/config.h"
+#include "test.h"
+
+using BVS::Config;
+using BVS::ConfigHandle;
+
+
+
+/** Number of allocations of this program. */
+static std::atomic<unsigned long long> allocations{0};
+
+
+
+void* operator new(std::size_t size)
+{
+	allocations++;
+	void* memory = std::malloc(size ? size : 1);
+	if (!memory) throw std::bad_alloc{};
+	return memory;
+}
+
+
+
+void operator delete(void* memory) noexcept
+{
+	std::free(memory);
+}
+
+
+
+void operator delete(void* memory, std::size_t) noexcept
+{
+	std::free(memory);
+}
+
+
+
+/** Write a config file. */
+static void writeFile(const char* file, const std::string& content)
+{
+	std::ofstream out{file};
+	out << content;
+}
+
+
+
+int main()
+{
+	const char* file = "configtest.conf";
+	writeFile(file, "[Test]\nthreshold = 5\nname = left\n");
+	Config config{"bvs"};
+	config.loadConfigFile(file);
+
+	ConfigHandle<int> threshold = config.handle<int>("Test.threshold", 1);
+	ConfigHandle<std::string> name = config.handle<std::string>("Test.name", "none");
+	ConfigHandle<std::string> missing = config.handle<std::string>("Test.missing", "default");
+	CHECK_EQUAL(threshold.get(), 5);
+	CHECK_EQUAL(*name.get(), "left");
+	CHECK_EQUAL(*missing.get(), "default");
+	CHECK_EQUAL(name.getOption(), "Test.name");
+
+	// reading handles never allocates, strings share the current copy
+	unsigned long long before = allocations;
+	int sum = 0;
+	size_t length = 0;
+	for (int i=0; i<1000; i++) {
+		sum += threshold.get();
+		length += name.get()->size();
+	}
+	CHECK_EQUAL(allocations-before, 0ull);
+	CHECK_EQUAL(sum, 5000);
+	CHECK_EQUAL(length, 4000u);
+	CHECK(name.get()==name.get());
+
+	// reloading refreshes handles, replaced copies stay valid until reclaimed between rounds
+	const std::string* held = name.get();
+	writeFile(file, "[Test]\nthreshold = 7\nname = right\n");
+	CHECK(config.stageReload());
+	CHECK_EQUAL(*name.get(), "left");
+	config.applyReload();
+	CHECK_EQUAL(threshold.get(), 7);
+	CHECK_EQUAL(*name.get(), "right");
+	CHECK_EQUAL(*held, "left");
+	config.reclaim();
+	CHECK_EQUAL(*name.get(), "right");
+	before = allocations;
+	config.reclaim();
+	CHECK_EQUAL(allocations-before, 0ull);
+
+	// reloads are staged until applied, subscribers receive the changed options
+	std::vector<std::string> notified;
+	unsigned int subscription = config.subscribe([&](const std::vector<std::string>& options) { notified = options; });
+	writeFile("configtest.source.conf", "[Other]\nvalue = 1\n");
+	writeFile(file, "[Test]\nthreshold = 7\nname = right\nsource configtest.source.conf\n");
+	CHECK(config.stageReload());
+	CHECK(config.hasPendingReload());
+	CHECK_EQUAL(config.getLoadedFiles().size(), 1u);
+	CHECK_EQUAL(config.getValue<int>("Other.value", 0), 0);
+	CHECK_EQUAL(config.applyReload().size(), 1u);
+	CHECK(!config.hasPendingReload());
+	CHECK_EQUAL(notified.size(), 1u);
+	CHECK_EQUAL(notified.at(0), "other.value");
+	CHECK_EQUAL(config.getLoadedFiles().size(), 2u);
+	CHECK_EQUAL(config.getValue<int>("Other.value", 0), 1);
+
+	// unchanged files stage nothing, parse errors keep the current options
+	CHECK(!config.stageReload());
+	writeFile(file, "[Test]\nthreshold = 8\n[Test]\n");
+	CHECK(!config.stageReload());
+	CHECK(config.applyReload().empty());
+	CHECK_EQUAL(threshold.get(), 7);
+
+	// a newly sourced file without options is staged as well
+	writeFile("configtest.empty.conf", "");
+	writeFile(file, "[Test]\nthreshold = 7\nname = right\nsource configtest.source.conf\nsource configtest.empty.conf\n");
+	CHECK(config.stageReload());
+	CHECK(config.applyReload().empty());
+	CHECK_EQUAL(config.getLoadedFiles().size(), 3u);
+	config.unsubscribe(subscription);
+
+	std::remove(file);
+	std::remove("configtest.source.conf");
+	std::remove("configtest.empty.conf");
+
+	return BVS_TEST_RESULT;
+}
+
@@ -0,0 +1,64 @@
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+
+#include "configwatcher.h"
+#include "test.h"
+
+using BVS::Config;
+using BVS::ConfigWatcher;
+
+
+
+/** Write a config file. */
+static void writeFile(const char* file, const std::string& content)
+{
+	std::ofstream out{file};
+	out << content;
+}
+
+
+
+/** Wait at most 5 seconds for the watcher to stage a reload. */
+static bool waitForReload(const Config& config)
+{
+	for (int i=0; i<500 && !config.hasPendingReload(); i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds{10});
+	return config.hasPendingReload();
+}
+
+
+
+int main()
+{
+	const char* file = "configwatchertest.conf";
+	const char* source = "configwatchertest.source.conf";
+	writeFile(file, "[Test]\nvalue = 1\n");
+	std::remove(source);
+	Config config{"bvs"};
+	config.loadConfigFile(file);
+	ConfigWatcher watcher{config};
+
+	// changes of loaded files are staged
+	int interval = ConfigWatcher::interval;
+	std::this_thread::sleep_for(std::chrono::milliseconds{interval});
+	writeFile(source, "[Other]\nvalue = 1\n");
+	writeFile(file, "[Test]\nvalue = 2\nsource configwatchertest.source.conf\n");
+	CHECK(waitForReload(config));
+	config.applyReload();
+	CHECK_EQUAL(config.getValue<int>("Test.value", 0), 2);
+
+	// once applied, newly sourced files are watched too
+	watcher.watch();
+	writeFile(source, "[Other]\nvalue = 2\n");
+	CHECK(waitForReload(config));
+	config.applyReload();
+	CHECK_EQUAL(config.getValue<int>("Other.value", 0), 2);
+
+	std::remove(file);
+	std::remove(source);
+
+	return BVS_TEST_RESULT;
+}
+
@@ -0,0 +1,61 @@
+#include "connectiongraph.h"
+#include "test.h"
+
+using BVS::ConnectionGraph;
+using BVS::ConnectorData;
+using BVS::ConnectorType;
+
+
+
+int main()
+{
+	ConnectorData out0{"out0", ConnectorType::OUTPUT, true, nullptr, 0, "int", false};
+	ConnectorData out1{"out1", ConnectorType::OUTPUT, true, nullptr, 0, "int", false};
+	ConnectorData inA{"in", ConnectorType::INPUT, true, nullptr, 0, "int", false};
+	ConnectorData inB{"in", ConnectorType::INPUT, true, nullptr, 0, "int", false};
+	ConnectorData inC{"in", ConnectorType::INPUT, true, nullptr, 0, "int", false};
+
+	ConnectionGraph graph;
+	CHECK_EQUAL(graph.size(), 0u);
+	CHECK(graph.origin(&inA)==nullptr);
+	CHECK(graph.consumers(&out0).empty());
+
+	// edges are indexed in both directions
+	graph.connect({"a", "in", &inA}, {"src", "out0", &out0})
+		.connect({"b", "in", &inB}, {"src", "out0", &out0})
+		.connect({"c", "in", &inC}, {"src", "out1", &out1});
+	CHECK_EQUAL(graph.size(), 3u);
+	CHECK(graph.origin(&inA)!=nullptr);
+	CHECK_EQUAL(graph.origin(&inA)->module, "src");
+	CHECK_EQUAL(graph.origin(&inA)->connector, "out0");
+	CHECK(graph.origin(&inA)->data==&out0);
+	CHECK_EQUAL(graph.consumers(&out0).size(), 2u);
+	CHECK_EQUAL(graph.consumers(&out1).size(), 1u);
+	CHECK_EQUAL(graph.consumers(&out1).at(0).module, "c");
+
+	// connecting an input again replaces its previous edge
+	graph.connect({"b", "in", &inB}, {"src", "out1", &out1});
+	CHECK_EQUAL(graph.size(), 3u);
+	CHECK(graph.origin(&inB)->data==&out1);
+	CHECK_EQUAL(graph.consumers(&out0).size(), 1u);
+	CHECK_EQUAL(graph.consumers(&out0).at(0).module, "a");
+	CHECK_EQUAL(graph.consumers(&out1).size(), 2u);
+
+	// disconnecting removes both directions
+	graph.disconnectInput(&inA);
+	CHECK(graph.origin(&inA)==nullptr);
+	CHECK(graph.consumers(&out0).empty());
+	CHECK_EQUAL(graph.size(), 2u);
+	graph.disconnectInput(&inA);
+	CHECK_EQUAL(graph.size(), 2u);
+
+	graph.disconnectOutput(&out1);
+	CHECK(graph.origin(&inB)==nullptr);
+	CHECK(graph.origin(&inC)==nullptr);
+	CHECK(graph.consumers(&out1).empty());
+	CHECK_EQUAL(graph.size(), 0u);
+	graph.disconnectOutput(&out1);
+
+	return BVS_TEST_RESULT;
+}
+
@@ -0,0 +1,110 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bvs/connector.h"
+#include "test.h"
+
+using BVS::Connector;
+using BVS::ConnectorData;
+using BVS::ConnectorDataCollector;
+using BVS::ConnectorType;
+using BVS::PayloadSize;
+
+
+
+/** Trivially copyable payload. */
+struct Point
+{
+	double x; /**< X coordinate. */
+	double y; /**< Y coordinate. */
+	double z; /**< Z coordinate. */
+};
+
+
+
+/** Payload that is neither a container nor trivially copyable. */
+struct Named
+{
+	/** Creates payload.
+	 * @param[in] name Name.
+	 * @param[in] id Identifier.
+	 */
+	Named(std::string name = "", int id = 0) : name{name}, id{id} {}
+
+	std::string name; /**< Name. */
+	int id; /**< Identifier. */
+};
+
+
+
+/** Connect an input to an output like the loader does.
+ * @return Metadata of the input.
+ */
+static std::shared_ptr<ConnectorData> connect(const std::string& input, const std::string& output)
+{
+	std::shared_ptr<ConnectorData> in = ConnectorDataCollector::connectors()[input];
+	std::shared_ptr<ConnectorData> out = ConnectorDataCollector::connectors()[output];
+	in->lock = std::unique_lock<std::mutex>{out->mutex, std::defer_lock};
+	in->pointer = out->pointer;
+	out->active = true;
+	return in;
+}
+
+
+
+int main()
+{
+	// containers report their elements, trivially copyable types their size, anything else 0
+	CHECK_EQUAL(PayloadSize<std::vector<int>>::size(std::vector<int>(10)), 10*sizeof(int));
+	CHECK_EQUAL(PayloadSize<std::vector<Point>>::size(std::vector<Point>(3)), 3*sizeof(Point));
+	CHECK_EQUAL(PayloadSize<std::string>::size(std::string{"hello"}), 5u);
+	CHECK_EQUAL(PayloadSize<Point>::size(Point{}), sizeof(Point));
+	CHECK_EQUAL(PayloadSize<int>::size(0), sizeof(int));
+	CHECK_EQUAL(PayloadSize<Named>::size(Named{}), 0u);
+
+	// sends, receives and bytes are counted on both sides
+	Connector<std::vector<int>> output{"output", ConnectorType::OUTPUT};
+	Connector<std::vector<int>> input{"input", ConnectorType::INPUT};
+	Connector<Named> namedOutput{"namedOutput", ConnectorType::OUTPUT};
+	std::shared_ptr<ConnectorData> out = ConnectorDataCollector::connectors()["output"];
+	std::shared_ptr<ConnectorData> in = connect("input", "output");
+	std::shared_ptr<ConnectorData> named = ConnectorDataCollector::connectors()["namedOutput"];
+
+	output.send(std::vector<int>(4));
+	output.send(std::vector<int>(2));
+	std::vector<int> received;
+	CHECK(input.receive(received));
+	CHECK_EQUAL(received.size(), 2u);
+	CHECK_EQUAL(out->statistics.sends.load(), 2u);
+	CHECK_EQUAL(out->statistics.receives.load(), 0u);
+	CHECK_EQUAL(out->statistics.bytes.load(), 6*sizeof(int));
+	CHECK_EQUAL(out->statistics.acquisitions.load(), 2u);
+	CHECK_EQUAL(in->statistics.receives.load(), 1u);
+	CHECK_EQUAL(in->statistics.sends.load(), 0u);
+	CHECK_EQUAL(in->statistics.bytes.load(), 2*sizeof(int));
+	CHECK_EQUAL(in->statistics.contended.load(), 0u);
+	CHECK_EQUAL(in->statistics.waitNanoseconds.load(), 0u);
+	namedOutput.send(Named{"name", 1});
+	CHECK_EQUAL(named->statistics.sends.load(), 1u);
+	CHECK_EQUAL(named->statistics.bytes.load(), 0u);
+
+	// a receive while the output is locked waits, it is counted as contended
+	output.lockConnection();
+	std::thread receiver{[&](){
+		std::vector<int> value;
+		input.receive(value);
+	}};
+	while (in->statistics.acquisitions.load()<2) std::this_thread::yield();
+	std::this_thread::sleep_for(std::chrono::milliseconds{20});
+	output.unlockConnection();
+	receiver.join();
+	CHECK_EQUAL(in->statistics.receives.load(), 2u);
+	CHECK_EQUAL(in->statistics.contended.load(), 1u);
+	CHECK(in->statistics.waitNanoseconds.load()>=1000000u);
+	CHECK_EQUAL(out->statistics.contended.load(), 0u);
+
+	return BVS_TEST_RESULT;
+}
+
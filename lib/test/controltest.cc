@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bvs/bvs.h"
+#include "test.h"
+
+using BVS::Logger;
+
+
+
+/** Wait at most 5 seconds until the master ran a few more rounds. */
+static bool waitForRounds(unsigned long long rounds)
+{
+	unsigned long long first = Logger::round.load();
+	for (int i=0; i<500 && Logger::round.load()<first+rounds; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds{10});
+	return Logger::round.load()>=first+rounds;
+}
+
+
+
+/** Median of some durations. */
+static std::chrono::nanoseconds median(std::vector<std::chrono::nanoseconds> durations)
+{
+	std::sort(durations.begin(), durations.end());
+	return durations[durations.size()/2];
+}
+
+
+
+int main()
+{
+	const char* argv[] = {"controltest"};
+	BVS::BVS* bvs = new BVS::BVS{1, argv};
+	bvs->enableLogConsole(std::cerr);
+	bvs->setLogSystemVerbosity(1);
+
+	bvs->loadModule("a(BVSBenchNoop)");
+	bvs->loadModule("b(BVSBenchNoop)", false, "pool");
+	bvs->start();
+	bvs->run();
+	CHECK(waitForRounds(10));
+
+	// modules come and go while the master runs, pools are created and joined on the way
+	std::vector<std::chrono::nanoseconds> poolStarts;
+	std::vector<std::chrono::nanoseconds> unloads;
+	for (int i=0; i<50; i++) {
+		std::string id = "x" + std::to_string(i);
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		if (i%3==0) bvs->loadModule(id + "(BVSBenchNoop)");
+		else if (i%3==1) bvs->loadModule(id + "(BVSBenchNoop)", true);
+		else bvs->loadModule(id + "(BVSBenchNoop)", false, "pool");
+		if (i%3==1) poolStarts.push_back(std::chrono::steady_clock::now() - start);
+		CHECK(waitForRounds(2));
+		start = std::chrono::steady_clock::now();
+		bvs->unloadModule(id);
+		unloads.push_back(std::chrono::steady_clock::now() - start);
+	}
+
+	// starting a module in a new pool and unloading wait for round boundaries, not for a poll interval
+	CHECK(median(poolStarts)<std::chrono::milliseconds{10});
+	CHECK(median(unloads)<std::chrono::milliseconds{10});
+
+	CHECK(waitForRounds(10));
+
+	bvs->quit();
+	delete bvs;
+
+	return BVS_TEST_RESULT;
+}
+
@@ -0,0 +1,126 @@
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include "flightrecorder.h"
+#include "test.h"
+
+using BVS::ConnectorData;
+using BVS::ConnectorMap;
+using BVS::ConnectorType;
+using BVS::FlightRecorder;
+using BVS::FlightRecorderDumper;
+using BVS::Status;
+
+
+
+/** Read a whole file. */
+static std::string readFile(const char* file)
+{
+	std::ifstream in{file};
+	std::stringstream content;
+	content << in.rdbuf();
+	return content.str();
+}
+
+
+
+/** Record rounds first..last (output sends = round). */
+static void recordRounds(FlightRecorder& recorder, int slot, ConnectorData& output, unsigned long long first, unsigned long long last)
+{
+	for (unsigned long long round=first; round<=last; round++) {
+		recorder.recordModule(slot, round, std::chrono::microseconds{round}, std::chrono::microseconds{1}, Status::OK);
+		output.statistics.sends = round;
+		recorder.recordRound(round, std::chrono::microseconds{10*round});
+	}
+}
+
+
+
+int main()
+{
+	const char* file = "flightrecordertest.json";
+	auto output = std::make_shared<ConnectorData>("out", ConnectorType::OUTPUT, true, nullptr, 0, "int", false);
+	ConnectorMap connectors{{"out", output},
+		{"in", std::make_shared<ConnectorData>("in", ConnectorType::INPUT, true, nullptr, 0, "int", false)}};
+
+	FlightRecorder recorder{4, 2, 4};
+	int slot = recorder.addModule("mod", connectors);
+	CHECK_EQUAL(slot, 0);
+	CHECK_EQUAL(recorder.addModule("other", ConnectorMap{}), 1);
+	CHECK_EQUAL(recorder.addModule("full", ConnectorMap{}), -1);
+
+	// the ring keeps the last 4 rounds, oldest first, only outputs are recorded
+	recordRounds(recorder, slot, *output, 0, 5);
+	CHECK(recorder.dump(file, true));
+	std::string json = readFile(file);
+	CHECK(json.find("\"round\":1,")==std::string::npos);
+	CHECK(json.find("\"round\":2,")<json.find("\"round\":5,"));
+	CHECK(json.find("\"round\":5,\"timestamp_us\":")!=std::string::npos);
+	CHECK(json.find("\"duration_us\":50,\"modules\":{\"mod\":{\"duration_us\":5,\"cpu_us\":1,\"status\":\"OK\"}}")!=std::string::npos);
+	CHECK(json.find("\"connectors\":{\"mod.out\":5}")!=std::string::npos);
+	CHECK(json.find("mod.in")==std::string::npos);
+	CHECK(json.find("\"other\"")==std::string::npos);
+
+	// removed modules are not dumped, their slot is reused
+	recorder.removeModule(slot);
+	CHECK(recorder.dump(file, true));
+	CHECK(readFile(file).find("mod.out")==std::string::npos);
+	CHECK_EQUAL(recorder.addModule("mod", connectors), slot);
+
+	// binary dump starts with the header
+	CHECK(recorder.dump(file, false));
+	std::string binary = readFile(file);
+	CHECK(binary.size()>sizeof(FlightRecorder::FileHeader));
+	FlightRecorder::FileHeader header;
+	binary.copy(reinterpret_cast<char*>(&header), sizeof(header));
+	CHECK_EQUAL(std::string{header.magic}, "BVSFR");
+	CHECK_EQUAL(header.rounds, 4u);
+	CHECK_EQUAL(header.next, 2ull);
+
+	// copies need the same number of slots
+	FlightRecorder copy{4, 2, 4};
+	FlightRecorder other{8, 2, 4};
+	CHECK(copy.copy(recorder));
+	CHECK(!other.copy(recorder));
+	CHECK(copy.dump(file, false));
+	CHECK(readFile(file)==binary);
+
+	// names are escaped, control characters included
+	FlightRecorder names{1, 1, 1};
+	names.recordModule(names.addModule("m\"\\\n\t\x01", ConnectorMap{}), 0,
+			std::chrono::microseconds{1}, std::chrono::microseconds{1}, Status::OK);
+	names.recordRound(0, std::chrono::microseconds{1});
+	CHECK(names.dump(file, true));
+	CHECK(readFile(file).find("\"modules\":{\"m\\\"\\\\\\n\\t\\u0001\":{")!=std::string::npos);
+
+	// the dumper writes a copy taken at request time and drops requests within its interval
+	std::remove(file);
+	{
+		FlightRecorderDumper dumper{recorder, file, true, std::chrono::milliseconds{60000}};
+		CHECK(dumper.request());
+		recordRounds(recorder, slot, *output, 6, 7);
+		CHECK(dumper.wait());
+		CHECK(!dumper.request());
+		CHECK(readFile(file).find("\"round\":5,")!=std::string::npos);
+		CHECK(readFile(file).find("\"round\":6,")==std::string::npos);
+	}
+	{
+		FlightRecorderDumper dumper{recorder, file, true, std::chrono::milliseconds{0}};
+		CHECK(dumper.request());
+		CHECK(dumper.wait());
+		recordRounds(recorder, slot, *output, 8, 8);
+		CHECK(dumper.request());
+		CHECK(dumper.wait());
+		CHECK(readFile(file).find("\"round\":8,")!=std::string::npos);
+	}
+	{
+		FlightRecorderDumper dumper{recorder, "/nonexistent/flightrecordertest.json", true, std::chrono::milliseconds{0}};
+		CHECK(dumper.request());
+		CHECK(!dumper.wait());
+	}
+	std::remove(file);
+
+	return BVS_TEST_RESULT;
+}
+
@@ -0,0 +1,90 @@
+#include <chrono>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "bvs/bvs.h"
+#include "bvs/statspage.h"
+#include "test.h"
+
+using BVS::Logger;
+using BVS::StatsPageConnector;
+using BVS::StatsPageHeader;
+using BVS::StatsPageModule;
+using BVS::StatsPagePool;
+
+
+
+/** Number of loaded modules. */
+static const int moduleCount = 8;
+
+
+
+int main()
+{
+	// modules are constructed by 4 loader threads, each module's connectors must end up in its own metadata
+	std::string modules;
+	for (int i=0; i<moduleCount; i++) {
+		modules += (i ? "," : "") + std::string{"m"} + std::to_string(i) + "(BVSTestConnectors)";
+		if (i) modules += ".input(m" + std::to_string(i-1) + ".output)";
+	}
+	std::string options = "--bvs.options=BVS.loadThreads=4:BVS.statsPage=ON:BVS.modules=" + modules;
+	const char* argv[] = {"loadertest", options.c_str()};
+	BVS::BVS* bvs = new BVS::BVS{2, argv};
+	bvs->enableLogConsole(std::cerr);
+	bvs->setLogSystemVerbosity(1);
+
+	bvs->loadModules();
+	bvs->connectAllModules();
+	bvs->start();
+	bvs->run();
+	for (int i=0; i<500 && Logger::round.load()<10; i++)
+		std::this_thread::sleep_for(std::chrono::milliseconds{10});
+	CHECK(Logger::round.load()>=10);
+
+	// connectors are read from the statistics page, which lists ModuleData::connectors of every module
+	std::string path = "/dev/shm/bvs-" + std::to_string(getpid());
+	int fd = open(path.c_str(), O_RDONLY);
+	CHECK(fd>=0);
+	off_t size = lseek(fd, 0, SEEK_END);
+	const StatsPageHeader* page = static_cast<const StatsPageHeader*>(mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0));
+	close(fd);
+	CHECK(page!=MAP_FAILED);
+	std::vector<char> buffer(size);
+	while (!BVS::readStatsPage(page, buffer.data(), buffer.size())) std::this_thread::yield();
+	munmap(const_cast<StatsPageHeader*>(page), size);
+
+	auto snapshot = reinterpret_cast<const StatsPageHeader*>(buffer.data());
+	auto pools = reinterpret_cast<const StatsPagePool*>(reinterpret_cast<const StatsPageModule*>(snapshot + 1)
+			+ snapshot->moduleCapacity);
+	auto connectors = reinterpret_cast<const StatsPageConnector*>(pools + snapshot->poolCapacity);
+	CHECK_EQUAL(snapshot->moduleCount, static_cast<uint32_t>(moduleCount));
+	CHECK_EQUAL(snapshot->connectorCount, static_cast<uint32_t>(2*moduleCount));
+	for (int i=0; i<moduleCount; i++) {
+		std::string id = "m" + std::to_string(i);
+		int inputs = 0;
+		int outputs = 0;
+		for (uint32_t j=0; j<snapshot->connectorCount; j++) {
+			const StatsPageConnector& connector = connectors[j];
+			if (std::string{connector.name}==id + ".input" && !connector.output) {
+				inputs++;
+				// connected inputs received from their output
+				CHECK(i==0 || connector.receives>0);
+			}
+			if (std::string{connector.name}==id + ".output" && connector.output) outputs++;
+		}
+		CHECK_EQUAL(inputs, 1);
+		CHECK_EQUAL(outputs, 1);
+	}
+
+	bvs->quit();
+	delete bvs;
+
+	return BVS_TEST_RESULT;
+}
+
@@ -0,0 +1,88 @@
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+#include <sys/resource.h>
+
+#include "logfilesink.h"
+#include "test.h"
+
+using BVS::LogFileSink;
+
+
+
+/** Read a whole file. */
+static std::string readFile(const std::string& file)
+{
+	std::ifstream in{file, std::ios::binary};
+	std::stringstream content;
+	content << in.rdbuf();
+	return content.str();
+}
+
+
+
+int main()
+{
+	const std::string file = "logfilesinktest.log";
+
+	// the file grows in steps while open and is truncated to its content on close
+	{
+		LogFileSink sink{file, false, 0, 1};
+		CHECK(sink.getError().empty());
+		CHECK(sink.write("first\n", 6));
+		CHECK_EQUAL(readFile(file).size(), LogFileSink::growthSize);
+		std::string large(LogFileSink::growthSize, 'x');
+		CHECK(sink.write(large.data(), large.size()));
+		CHECK_EQUAL(readFile(file).size(), 2*LogFileSink::growthSize);
+	}
+	CHECK_EQUAL(readFile(file).size(), 6+LogFileSink::growthSize);
+
+	// appending continues after the content
+	{
+		LogFileSink sink{file, false, 0, 1};
+		CHECK(sink.write("first\n", 6));
+	}
+	{
+		LogFileSink sink{file, true, 0, 1};
+		CHECK(sink.write("second\n", 7));
+	}
+	CHECK_EQUAL(readFile(file), "first\nsecond\n");
+
+	// segments rotate once full, the oldest one is dropped
+	{
+		LogFileSink sink{file, false, 16, 3};
+		for (int i=0; i<5; i++) CHECK(sink.write(("line " + std::to_string(i) + "\n").c_str(), 7));
+	}
+	CHECK_EQUAL(readFile(file), "line 4\n");
+	CHECK_EQUAL(readFile(file + ".1"), "line 2\nline 3\n");
+	CHECK_EQUAL(readFile(file + ".2"), "line 0\nline 1\n");
+	CHECK(!std::ifstream{file + ".3"});
+	std::remove((file + ".1").c_str());
+	std::remove((file + ".2").c_str());
+
+	// space that can not be allocated closes the file with an error (instead of SIGBUS on write)
+	signal(SIGXFSZ, SIG_IGN);
+	struct rlimit limit;
+	getrlimit(RLIMIT_FSIZE, &limit);
+	struct rlimit small = limit;
+	small.rlim_cur = LogFileSink::growthSize/2;
+	CHECK_EQUAL(setrlimit(RLIMIT_FSIZE, &small), 0);
+	{
+		LogFileSink sink{file, false, 0, 1};
+		CHECK(sink.getError().find("could not allocate space for log file")!=std::string::npos);
+		CHECK(!sink.write("lost\n", 5));
+	}
+	{
+		LogFileSink sink{file, false, LogFileSink::growthSize/4, 1};
+		CHECK(sink.getError().empty());
+		std::string large(LogFileSink::growthSize/8, 'x');
+		CHECK(sink.write(large.data(), large.size()));
+	}
+	setrlimit(RLIMIT_FSIZE, &limit);
+	std::remove(file.c_str());
+
+	return BVS_TEST_RESULT;
+}
+
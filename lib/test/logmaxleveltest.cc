@@ -0,0 +1,30 @@
+#include "bvs/logger.h"
+#include "test.h"
+
+using BVS::Logger;
+
+
+
+/** Number of evaluate() calls. */
+static int evaluations = 0;
+
+/** Count an evaluation of a log argument. */
+static int evaluate()
+{
+	return ++evaluations;
+}
+
+
+
+int main()
+{
+	// built with BVS_LOG_MAX_LEVEL (1 unless the build sets its own), calls above are removed
+	Logger logger{"MaxLevel", 3};
+	LOG(1, "level 1 " << evaluate());
+	LOG(2, "level 2 " << evaluate());
+	LOG(3, "level 3 " << evaluate());
+	CHECK_EQUAL(evaluations, BVS_LOG_MAX_LEVEL<3 ? BVS_LOG_MAX_LEVEL : 3);
+
+	return BVS_TEST_RESULT;
+}
+
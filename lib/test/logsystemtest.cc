@@ -0,0 +1,192 @@
+#include <fstream>
+#include <future>
+#include <sstream>
+#include <thread>
+
+#include "logsystem.h"
+#include "test.h"
+
+using BVS::Config;
+using BVS::Logger;
+using BVS::LogRecord;
+using BVS::LogRing;
+using BVS::LogSite;
+using BVS::LogSystem;
+
+
+
+/** Drain a ring into a string, one line per record ('target:data'). */
+static std::string drainRing(LogRing& ring)
+{
+	std::string out;
+	ring.drain([&](uint8_t target, const char* data, size_t size) {
+			out += std::to_string(target) + ":" + std::string{data, size} + "\n"; });
+	return out;
+}
+
+
+
+/** Number of evaluate() calls. */
+static int evaluations = 0;
+
+/** Count an evaluation of a log argument. */
+static int evaluate()
+{
+	return ++evaluations;
+}
+
+
+
+/** Log above and at the verbosity of a logger with verbosity 1. */
+static void logQuietly()
+{
+	Logger logger{"Quiet", 1};
+	LOG(3, "filtered " << evaluate());
+	LOG(1, "logged " << evaluate());
+}
+
+
+
+/** Log a message and wait at most 10 seconds for it to return.
+ * @return False if logging did not return in time.
+ */
+static bool logWithin10Seconds(LogSystem& system, const Logger& logger, const std::string& message)
+{
+	auto done = std::async(std::launch::async, [&](){
+			system.out(logger, 1) << message;
+			system.endl(logger, 1);
+			});
+	return done.wait_for(std::chrono::seconds{10})==std::future_status::ready;
+}
+
+
+
+int main()
+{
+	// capacity is rounded up to a power of two (at least 256)
+	CHECK_EQUAL(LogRing{1}.capacity(), 256u);
+	CHECK_EQUAL(LogRing{300}.capacity(), 512u);
+
+	// records wrap around the end of the buffer and keep their order
+	LogRing ring{256};
+	std::string record(100, 'a');
+	for (int i=0; i<20; i++) {
+		record.assign(100, 'a'+i%26);
+		CHECK(ring.push(record.data(), record.size(), 1+i%4));
+		CHECK(ring.push("x", 1, 2));
+		CHECK_EQUAL(drainRing(ring), std::to_string(1+i%4) + ":" + record + "\n2:x\n");
+		CHECK_EQUAL(ring.fill(), 0u);
+	}
+
+	// full rings reject records until drained, records larger than the ring never fit
+	CHECK(ring.push(record.data(), record.size(), 1));
+	CHECK(ring.push(record.data(), record.size(), 1));
+	CHECK(!ring.push(record.data(), record.size(), 1));
+	CHECK(ring.fits(record.size()));
+	CHECK(ring.fits(256-5));
+	CHECK(!ring.fits(256-4));
+	CHECK_EQUAL(ring.fill(), 210u);
+	drainRing(ring);
+	CHECK(ring.push(record.data(), record.size(), 1));
+
+	// concurrent producer and consumer
+	LogRing shared{1024};
+	const int count = 20000;
+	std::thread producer{[&](){
+		for (int i=0; i<count; i++) {
+			std::string message = std::to_string(i);
+			while (!shared.push(message.data(), message.size(), 1)) std::this_thread::yield();
+		}
+	}};
+	int expected = 0;
+	bool ordered = true;
+	while (expected<count) {
+		shared.drain([&](uint8_t, const char* data, size_t size) {
+				ordered = ordered && std::string{data, size}==std::to_string(expected);
+				expected++;
+				});
+	}
+	producer.join();
+	CHECK(ordered);
+
+	// BLOCK: a message larger than the thread's ring is written directly instead of waiting forever
+	{
+		std::ofstream conf{"logsystemtest.conf"};
+		conf << "[BVS]\nlogAsync = ON\nlogBufferSize = 64\nlogOverflow = BLOCK\nlogColors = OFF\nlogVerbosity = 3\n"
+			<< "[Logger]\nDuplicates.suppressDuplicates = ON\n";
+	}
+	Config config{"bvs"};
+	config.loadConfigFile("logsystemtest.conf");
+	std::remove("logsystemtest.conf");
+	std::stringstream console;
+	auto system = LogSystem::connectToLogSystem();
+	system->updateSettings(config);
+	system->updateLoggerLevels(config);
+	system->enableLogConsole(console);
+	Logger logger{"Test"};
+
+	std::string small{"small message"};
+	std::string large(1000, 'L');
+	CHECK(logWithin10Seconds(*system, logger, small));
+	CHECK(logWithin10Seconds(*system, logger, large));
+	CHECK(logWithin10Seconds(*system, logger, small + "2"));
+	system->flush();
+	std::string output = console.str();
+	CHECK(output.find(small)!=std::string::npos);
+	CHECK(output.find(large)!=std::string::npos);
+	CHECK(output.find(small)<output.find(large));
+	CHECK(output.find(large)<output.find(small + "2"));
+
+	// duplicates are checked on the captured values, held back and reported once the interval expired
+	Logger duplicates{"Duplicates"};
+	system->announce(duplicates);
+	CHECK(duplicates.capture(1));
+	CHECK(!duplicates.capture(0));
+	static LogSite site{"logsystemtest.cc", 1, "\"duplicate \" << number"};
+	auto commit = [&](const std::string& text, int number) {
+		LogRecord record;
+		record << text << number;
+		system->commit(duplicates, site, 2, record);
+	};
+	for (int i=0; i<5; i++) commit("duplicate ", 1);
+	commit("other ", 1);
+	system->flush();
+	output = console.str();
+	CHECK(output.find("] duplicate 1\n")!=std::string::npos);
+	CHECK_EQUAL(output.find("] duplicate 1\n"), output.rfind("] duplicate 1"));
+	CHECK(output.find("] other 1\n")!=std::string::npos);
+	CHECK(output.find("repeated")==std::string::npos);
+	std::this_thread::sleep_for(std::chrono::milliseconds{bvs_log_duplicate_interval+200});
+	system->flush();
+	CHECK(console.str().find("] duplicate 1 (repeated 4 times)\n")!=std::string::npos);
+
+	// retired loggers write their held back duplicates immediately
+	for (int i=0; i<3; i++) commit("duplicate ", 2);
+	system->retire(duplicates);
+	system->flush();
+	CHECK(console.str().find("] duplicate 2 (repeated 2 times)\n")!=std::string::npos);
+
+	// arguments of filtered messages are never evaluated
+	logQuietly();
+	CHECK_EQUAL(evaluations, 1);
+
+	// JSON records escape quotes, backslashes and control characters of names and messages
+	system->enableLogJSON("logsystemtest.json");
+	Logger json{"Json\"Logger"};
+	system->out(json, 2) << "quote \" backslash \\ tab \t line\nnext \x01 end" << std::endl;
+	system->endl(json, 2);
+	system->flush();
+	system->disableLogJSON();
+	std::ifstream file{"logsystemtest.json"};
+	std::string line;
+	CHECK(std::getline(file, line));
+	CHECK_EQUAL(line.substr(0, 6), "{\"ts\":");
+	CHECK(line.find(",\"logger\":\"Json\\\"Logger\",\"level\":2,\"round\":0,")!=std::string::npos);
+	CHECK(line.find(",\"msg\":\"quote \\\" backslash \\\\ tab \\t line\\nnext \\u0001 end\"}")!=std::string::npos);
+	CHECK_EQUAL(line.back(), '}');
+	CHECK(!std::getline(file, line));
+	std::remove("logsystemtest.json");
+
+	return BVS_TEST_RESULT;
+}
+
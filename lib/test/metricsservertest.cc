@@ -0,0 +1,91 @@
+#include <string>
+
+#include "metricsserver.h"
+#include "statswriter.h"
+#include "test.h"
+
+using BVS::ConnectorData;
+using BVS::ConnectorType;
+using BVS::ControlFlag;
+using BVS::Info;
+using BVS::ModuleData;
+using BVS::ModuleRecordVector;
+using BVS::ModuleTable;
+using BVS::PoolData;
+using BVS::PoolPlan;
+using BVS::StatsWriter;
+using BVSD::MetricsServer;
+
+
+
+/** Check that the metrics contain a whole line. */
+static bool hasLine(const std::string& metrics, const std::string& line)
+{
+	return ("\n" + metrics).find("\n" + line + "\n")!=std::string::npos;
+}
+
+
+
+int main()
+{
+	BVS::Config config{"metricsservertest"};
+	Info info{"test", config, 0, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, 0, 1, {}, {0, 0}};
+	ModuleTable table{1};
+	auto output = std::make_shared<ConnectorData>("out", ConnectorType::OUTPUT, true, nullptr, 0, "int", false);
+	auto data = std::make_shared<ModuleData>("m\"\\\n1", "", "m", "", nullptr, nullptr, "p",
+			BVS::ConnectorMap{{"out", output}});
+	data->index = table.acquire(nullptr, nullptr);
+	auto pool = std::make_shared<PoolData>("p", ControlFlag::WAIT);
+	pool->plan = std::make_shared<ModuleRecordVector>(ModuleRecordVector{
+			{data->index, data, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr}});
+	PoolPlan pools{pool};
+	auto& module = table[data->index];
+
+	// module durations fall into the first, second and last (+Inf) bucket
+	StatsWriter writer{1, 1, 1};
+	const unsigned long long durations[] = {100, 700, 2000000};
+	for (unsigned long long round=0; round<3; round++) {
+		info.round = round;
+		module.executedRound = round;
+		module.duration = std::chrono::microseconds{durations[round]};
+		module.cpuDuration = std::chrono::microseconds{50};
+		output->statistics.waitNanoseconds = 1500000;
+		writer.publish(info, table, pools, std::chrono::microseconds{1000*(round+1)});
+	}
+
+	MetricsServer server{"", writer.getPath()};
+	CHECK(server.mapPage());
+	std::string metrics = server.render();
+
+	// round histogram, buckets are cumulative, sums are converted from us to s
+	CHECK(hasLine(metrics, "bvs_rounds_total 3"));
+	CHECK(hasLine(metrics, "bvs_round_duration_seconds_bucket{le=\"0.0005\"} 0"));
+	CHECK(hasLine(metrics, "bvs_round_duration_seconds_bucket{le=\"0.001\"} 1"));
+	CHECK(hasLine(metrics, "bvs_round_duration_seconds_bucket{le=\"0.0025\"} 2"));
+	CHECK(hasLine(metrics, "bvs_round_duration_seconds_bucket{le=\"0.005\"} 3"));
+	CHECK(hasLine(metrics, "bvs_round_duration_seconds_bucket{le=\"1\"} 3"));
+	CHECK(hasLine(metrics, "bvs_round_duration_seconds_bucket{le=\"+Inf\"} 3"));
+	CHECK(hasLine(metrics, "bvs_round_duration_seconds_sum 0.006"));
+	CHECK(hasLine(metrics, "bvs_round_duration_seconds_count 3"));
+
+	// label values escape quotes, backslashes and newlines, +Inf bucket matches the count
+	const std::string labels = "module=\"m\\\"\\\\\\n1\",pool=\"p\"";
+	CHECK(hasLine(metrics, "bvs_module_executions_total{module=\"m\\\"\\\\\\n1\"} 3"));
+	CHECK(hasLine(metrics, "bvs_module_duration_seconds_bucket{" + labels + ",le=\"0.0005\"} 1"));
+	CHECK(hasLine(metrics, "bvs_module_duration_seconds_bucket{" + labels + ",le=\"0.001\"} 2"));
+	CHECK(hasLine(metrics, "bvs_module_duration_seconds_bucket{" + labels + ",le=\"1\"} 2"));
+	CHECK(hasLine(metrics, "bvs_module_duration_seconds_bucket{" + labels + ",le=\"+Inf\"} 3"));
+	CHECK(hasLine(metrics, "bvs_module_duration_seconds_sum{" + labels + "} 2.0008"));
+	CHECK(hasLine(metrics, "bvs_module_duration_seconds_count{" + labels + "} 3"));
+	CHECK(hasLine(metrics, "bvs_module_cpu_seconds_total{module=\"m\\\"\\\\\\n1\"} 0.00015"));
+	CHECK(hasLine(metrics, "bvs_connector_wait_seconds_total{connector=\"m\\\"\\\\\\n1.out\"} 0.0015"));
+	CHECK(metrics.find("m\"")==std::string::npos);
+
+	// no page, no metrics
+	MetricsServer missing{"", "/nonexistent/metricsservertest"};
+	CHECK(!missing.mapPage());
+	CHECK(missing.render().empty());
+
+	return BVS_TEST_RESULT;
+}
+
@@ -0,0 +1,38 @@
+#include "perfcounters.h"
+#include "test.h"
+
+using BVS::PerfCounters;
+
+
+
+int main()
+{
+	std::vector<unsigned long long> counters(2);
+
+	// not multiplexed, raw differences
+	PerfCounters::difference({100, 100, {10, 20}}, {200, 200, {15, 60}}, counters);
+	CHECK_EQUAL(counters[0], 5ull);
+	CHECK_EQUAL(counters[1], 40ull);
+
+	// multiplexed during the interval, difference is scaled by the interval's ratio
+	PerfCounters::difference({100, 100, {10, 20}}, {300, 150, {15, 60}}, counters);
+	CHECK_EQUAL(counters[0], 20ull);
+	CHECK_EQUAL(counters[1], 160ull);
+
+	// ratio changed between readings: scaling each reading would go backwards
+	PerfCounters::difference({1000, 100, {100, 100}}, {1100, 200, {101, 101}}, counters);
+	CHECK_EQUAL(counters[0], 1ull);
+	CHECK_EQUAL(counters[1], 1ull);
+
+	// counters going backwards (or missing) count as nothing
+	PerfCounters::difference({100, 100, {10, 20}}, {200, 200, {5}}, counters);
+	CHECK_EQUAL(counters[0], 0ull);
+	CHECK_EQUAL(counters[1], 0ull);
+
+	// group did not run at all
+	PerfCounters::difference({100, 100, {10, 20}}, {200, 100, {10, 20}}, counters);
+	CHECK_EQUAL(counters[0], 0ull);
+
+	return BVS_TEST_RESULT;
+}
+
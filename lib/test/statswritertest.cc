@@ -0,0 +1,108 @@
+#include <thread>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+#include "statswriter.h"
+#include "test.h"
+
+using BVS::ControlFlag;
+using BVS::Info;
+using BVS::ModuleData;
+using BVS::ModuleDataMap;
+using BVS::ModuleRecordVector;
+using BVS::ModuleTable;
+using BVS::PoolData;
+using BVS::PoolPlan;
+using BVS::StatsPageHeader;
+using BVS::StatsPageModule;
+using BVS::StatsWriter;
+using BVS::Status;
+
+
+
+int main()
+{
+	BVS::Config config{"statswritertest"};
+	Info info{"test", config, 0, {}, {}, {}, {}, {}, {}, {}, {}, {}, {}, 0, 1, {}, {0, 0}};
+	ModuleTable table{4};
+	ModuleDataMap modules;
+	modules["a"] = std::make_shared<ModuleData>("a", "", "a", "", nullptr, nullptr, "master", BVS::ConnectorMap{});
+	modules["b"] = std::make_shared<ModuleData>("b", "", "b", "", nullptr, nullptr, "master", BVS::ConnectorMap{});
+	modules["c"] = std::make_shared<ModuleData>("c", "", "c", "", nullptr, nullptr, "master", BVS::ConnectorMap{});
+	auto pool = std::make_shared<PoolData>("master", ControlFlag::WAIT);
+	auto plan = std::make_shared<ModuleRecordVector>();
+	for (auto& it: modules) {
+		it.second->index = table.acquire(nullptr, nullptr);
+		plan->push_back({it.second->index, it.second, nullptr, nullptr, nullptr, nullptr, nullptr, nullptr});
+	}
+	pool->plan = plan;
+	PoolPlan pools{pool};
+	auto& a = table[modules["a"]->index];
+	auto& b = table[modules["b"]->index];
+
+	// stopped modules stay in the published plan until the next round, they are not shown
+	table[modules["c"]->index].flag = ControlFlag::QUIT;
+
+	StatsWriter writer{4, 4, 16};
+	CHECK(!writer.getPath().empty());
+	int fd = open(writer.getPath().c_str(), O_RDONLY);
+	CHECK(fd>=0);
+	off_t size = lseek(fd, 0, SEEK_END);
+	const StatsPageHeader* page = static_cast<const StatsPageHeader*>(mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0));
+	close(fd);
+	CHECK(page!=MAP_FAILED);
+	std::vector<char> buffer(size);
+	const StatsPageHeader* snapshot = reinterpret_cast<const StatsPageHeader*>(buffer.data());
+	const StatsPageModule* snapshotModules = reinterpret_cast<const StatsPageModule*>(snapshot + 1);
+
+	// only rounds in which execute() was called count as executions
+	for (unsigned long long round=0; round<10; round++) {
+		info.round = round;
+		a.executedRound = round;
+		a.duration = std::chrono::microseconds{100};
+		if (round%2==0) b.executedRound = round;
+		b.status = round%2==0 ? Status::FAIL : Status::OK;
+		writer.publish(info, table, pools, std::chrono::microseconds{1000});
+	}
+	CHECK(BVS::readStatsPage(page, buffer.data(), buffer.size()));
+	CHECK_EQUAL(snapshot->rounds, 10u);
+	CHECK_EQUAL(snapshot->moduleCount, 2u);
+	CHECK_EQUAL(std::string{snapshotModules[0].id}, "a");
+	CHECK_EQUAL(snapshotModules[0].executions, 10u);
+	CHECK_EQUAL(snapshotModules[0].durationSum, 1000u);
+	CHECK_EQUAL(std::string{snapshotModules[1].id}, "b");
+	CHECK_EQUAL(snapshotModules[1].executions, 5u);
+	CHECK_EQUAL(snapshotModules[1].failCount, 5u);
+	uint64_t histogramSum = 0;
+	for (auto count: snapshotModules[1].histogram) histogramSum += count;
+	CHECK_EQUAL(histogramSum, 5u);
+
+	// seqlock: readers never see a half written page (round and sums are written apart)
+	std::atomic<bool> writing{true};
+	std::thread publisher{[&](){
+		for (unsigned long long round=10; round<20000; round++) {
+			info.round = round;
+			a.executedRound = round;
+			writer.publish(info, table, pools, std::chrono::microseconds{1000});
+		}
+		writing = false;
+	}};
+	int consistent = 0;
+	while (writing) {
+		if (!BVS::readStatsPage(page, buffer.data(), buffer.size())) continue;
+		CHECK_EQUAL(snapshot->sequence.load()%2, 0u);
+		CHECK_EQUAL(snapshot->rounds, snapshot->round+1);
+		CHECK_EQUAL(snapshot->roundDurationSum, 1000*snapshot->rounds);
+		CHECK_EQUAL(snapshotModules[0].executions, snapshot->rounds);
+		consistent++;
+	}
+	publisher.join();
+	CHECK(consistent>0);
+
+	munmap(const_cast<StatsPageHeader*>(page), size);
+
+	return BVS_TEST_RESULT;
+}
+
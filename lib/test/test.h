@@ -0,0 +1,50 @@
+#ifndef BVS_TEST_H
+#define BVS_TEST_H
+
+#include <iostream>
+
+
+
+/** Minimal unit test support.
+ * A test is an executable that calls CHECK/CHECK_EQUAL for every
+ * expectation and returns BVS_TEST_RESULT from main, ctest reports a
+ * non-zero exit code as failure:
+ * @code
+ * int main()
+ * {
+ *     CHECK(1+1==2);
+ *     CHECK_EQUAL(std::string{"a"}+"b", "ab");
+ *     return BVS_TEST_RESULT;
+ * }
+ * @endcode
+ */
+namespace BVSTest
+{
+	/** Number of failed checks. */
+	inline int& failures()
+	{
+		static int count = 0;
+		return count;
+	}
+} // namespace BVSTest
+
+
+
+/** Check that a condition holds, print it if not. */
+#define CHECK(condition) do { if (!(condition)) { \
+	std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition ") failed" << std::endl; \
+	BVSTest::failures()++; } } while (false)
+
+/** Check that two values compare equal, print both if not. */
+#define CHECK_EQUAL(actual, expected) do { if (!((actual)==(expected))) { \
+	std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK_EQUAL(" #actual ", " #expected ") failed: '" \
+		<< (actual) << "' != '" << (expected) << "'" << std::endl; \
+	BVSTest::failures()++; } } while (false)
+
+/** Exit code of a test. */
+#define BVS_TEST_RESULT (BVSTest::failures()==0 ? 0 : 1)
+
+
+
+#endif //BVS_TEST_H
+
@@ -0,0 +1,156 @@
+#include <atomic>
+
+#include <pthread.h>
+#include <signal.h>
+
+#include "watchdog.h"
+#include "test.h"
+
+using BVS::BudgetAction;
+using BVS::ControlFlag;
+using BVS::ModuleData;
+using BVS::ModuleState;
+using BVS::ModuleTable;
+using BVS::Status;
+using BVS::Watchdog;
+
+
+
+/** Module table of all tests. */
+static ModuleTable table{8};
+
+
+
+/** Create module data with a budget, its state is taken from the table. */
+static std::shared_ptr<ModuleData> moduleData(std::string id, unsigned int budgetMs)
+{
+	auto data = std::make_shared<ModuleData>(id, "", id, "", nullptr, nullptr, "pool", BVS::ConnectorMap{});
+	data->index = table.acquire(nullptr, nullptr);
+	ModuleState& state = table[data->index];
+	state.flag = ControlFlag::RUN;
+	state.budget = std::chrono::milliseconds{budgetMs};
+	state.budgetAction = BudgetAction::FAIL;
+	state.nativeThread = pthread_self();
+
+	return data;
+}
+
+
+
+/** Get the state of a module. */
+static ModuleState& state(const std::shared_ptr<ModuleData>& data)
+{
+	return table[data->index];
+}
+
+
+
+/** Mark module as executing since the given time. */
+static void startExecution(const std::shared_ptr<ModuleData>& data, std::chrono::milliseconds ago)
+{
+	state(data).executionStart = std::chrono::duration_cast<std::chrono::nanoseconds>
+		((std::chrono::steady_clock::now() - ago).time_since_epoch()).count();
+}
+
+
+
+/** Number of SIGUSR2 signals seen by the handler installed before the watchdog's. */
+static std::atomic<int> previousSignals{0};
+
+/** Handler installed before the watchdog's. */
+static void countSignal(int)
+{
+	previousSignals++;
+}
+
+
+
+/** Wait (at most 2s) for a condition. */
+template<typename Condition> static bool waitFor(Condition condition)
+{
+	for (int i=0; i<2000 && !condition(); i++) std::this_thread::sleep_for(std::chrono::milliseconds{1});
+	return condition();
+}
+
+
+
+int main()
+{
+	std::atomic<int> shutdowns{0};
+	struct sigaction action{};
+	action.sa_handler = countSignal;
+	sigemptyset(&action.sa_mask);
+	sigaction(SIGUSR2, &action, nullptr);
+
+	{
+		// overrun within the shutdown factor: marked, no shutdown
+		Watchdog watchdog{table, std::chrono::milliseconds{1}, 10, [&](){ shutdowns++; }};
+		auto slow = moduleData("slow", 5);
+		auto idle = moduleData("idle", 5);
+		auto unbudgeted = moduleData("unbudgeted", 0);
+		watchdog.watch(slow).watch(idle).watch(unbudgeted);
+		startExecution(slow, std::chrono::milliseconds{20});
+		startExecution(unbudgeted, std::chrono::milliseconds{1000});
+		CHECK(waitFor([&](){ return state(slow).overrun.load(); }));
+		std::this_thread::sleep_for(std::chrono::milliseconds{10});
+		CHECK_EQUAL(shutdowns.load(), 0);
+		CHECK(!state(idle).overrun);
+		CHECK(!state(unbudgeted).overrun);
+		CHECK(state(slow).status==Status::OK);
+
+		// hung: handler is called from the watchdog thread, once
+		startExecution(slow, std::chrono::milliseconds{60});
+		CHECK(waitFor([&](){ return shutdowns.load()>0; }));
+		std::this_thread::sleep_for(std::chrono::milliseconds{10});
+		CHECK_EQUAL(shutdowns.load(), 1);
+	}
+
+	{
+		// factor 0 never calls the handler, unwatched modules are not checked
+		shutdowns = 0;
+		Watchdog watchdog{table, std::chrono::milliseconds{1}, 0, [&](){ shutdowns++; }};
+		auto hung = moduleData("hung", 1);
+		auto gone = moduleData("gone", 1);
+		watchdog.watch(hung).watch(gone).unwatch("gone");
+		startExecution(hung, std::chrono::milliseconds{1000});
+		startExecution(gone, std::chrono::milliseconds{1000});
+		CHECK(waitFor([&](){ return state(hung).overrun.load(); }));
+		std::this_thread::sleep_for(std::chrono::milliseconds{10});
+		CHECK_EQUAL(shutdowns.load(), 0);
+		CHECK(!state(gone).overrun);
+	}
+
+	{
+		// waiting for a stack does not block unwatch() (the thread blocks the signal, it is never captured)
+		Watchdog watchdog{table, std::chrono::milliseconds{1}, 0, [](){}};
+		auto blocked = moduleData("blocked", 1);
+		std::atomic<bool> done{false};
+		std::atomic<bool> masked{false};
+		std::thread thread{[&](){
+			sigset_t set;
+			sigemptyset(&set);
+			sigaddset(&set, SIGUSR2);
+			pthread_sigmask(SIG_BLOCK, &set, nullptr);
+			masked = true;
+			while (!done) std::this_thread::sleep_for(std::chrono::milliseconds{1});
+		}};
+		CHECK(waitFor([&](){ return masked.load(); }));
+		state(blocked).nativeThread = thread.native_handle();
+		watchdog.watch(blocked);
+		startExecution(blocked, std::chrono::milliseconds{1000});
+		CHECK(waitFor([&](){ return state(blocked).overrun.load(); }));
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		watchdog.unwatch("blocked");
+		CHECK(std::chrono::steady_clock::now() - start<std::chrono::milliseconds{50});
+		done = true;
+		thread.join();
+	}
+
+	// stacks were captured without the previous handler, other SIGUSR2 are passed on to it
+	CHECK_EQUAL(previousSignals.load(), 0);
+	pthread_kill(pthread_self(), SIGUSR2);
+	CHECK_EQUAL(previousSignals.load(), 1);
+
+	return BVS_TEST_RESULT;
+}
+
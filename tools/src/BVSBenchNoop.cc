@@ -0,0 +1,31 @@
+#include "bvs/module.h"
+
+
+
+/** Module doing nothing, used by bvs-bench to measure round overhead. */
+class BVSBenchNoop : public BVS::Module
+{
+	public:
+		/** Construct module (signature required by the framework). */
+		BVSBenchNoop(BVS::ModuleInfo, const BVS::Info&) : BVS::Module() { }
+
+		/** Do nothing.
+		 * @return Always OK.
+		 */
+		BVS::Status execute() { return BVS::Status::OK; }
+
+		/** UNUSED
+		 * @return Always OK.
+		 */
+		BVS::Status debugDisplay() { return BVS::Status::OK; }
+
+	private:
+		BVSBenchNoop(const BVSBenchNoop&) = delete; /**< -Weffc++ */
+		BVSBenchNoop& operator=(const BVSBenchNoop&) = delete; /**< -Weffc++ */
+};
+
+
+
+/** This calls a macro to create needed module utilities. */
+BVS_MODULE_UTILITIES(BVSBenchNoop)
+
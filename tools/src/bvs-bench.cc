@@ -0,0 +1,362 @@
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <streambuf>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "bvs/bvs.h"
+#include "bvs/connector.h"
+#include "bvs/logger.h"
+#include "barrier.h"
+
+using BVS::Barrier;
+using BVS::Config;
+using BVS::Connector;
+using BVS::ConnectorData;
+using BVS::ConnectorDataCollector;
+using BVS::ConnectorMap;
+using BVS::ConnectorType;
+using BVS::Logger;
+
+
+
+/** Result of a single benchmark. */
+struct Result
+{
+	std::string name; /**< Benchmark name. */
+	std::string parameters; /**< Parameters as JSON members, e.g. "payload":8. */
+	unsigned long long iterations; /**< Measured operations. */
+	double nanoseconds; /**< Time per operation. */
+	size_t bytes; /**< Bytes per operation (0 if not applicable). */
+};
+
+static std::vector<Result> results; /**< Collected results. */
+static std::chrono::milliseconds minTime{200}; /**< Minimal measurement time per benchmark. */
+static std::string filter; /**< Only run benchmarks whose name contains this. */
+static bool failed = false; /**< A benchmark could not be measured. */
+
+
+
+/** Stream buffer discarding everything, used as log console. */
+class DiscardBuffer : public std::streambuf
+{
+	protected:
+		/** Discard character. */
+		int overflow(int c) { return c; }
+
+		/** Discard characters. */
+		std::streamsize xsputn(const char*, std::streamsize n) { return n; }
+};
+
+
+
+/** Print usage. */
+static void usage()
+{
+	printf("usage: bvs-bench [-f filter] [-t time] [-o file] [--bvs.config=...]\n");
+	printf("   -f filter      only run benchmarks whose name contains filter\n");
+	printf("   -t time        minimal measurement time per benchmark in ms (default: 200)\n");
+	printf("   -o file        write JSON results to file (default: stdout)\n");
+	printf("   --bvs.*        passed on to the framework (e.g. --bvs.config=bench.conf)\n");
+	printf("run from the bin directory, the round benchmark loads libBVSBenchNoop\n");
+	printf("exits with an error if a benchmark could not be measured (e.g. no rounds ran)\n");
+}
+
+
+
+/** Check if a benchmark is selected by the filter. */
+static bool selected(const std::string& name)
+{
+	return filter.empty() || name.find(filter)!=std::string::npos;
+}
+
+
+
+/** Measure an operation.
+ * Calls operation with growing batch sizes until minTime has passed.
+ * @param[in] name Benchmark name.
+ * @param[in] parameters Parameters as JSON members.
+ * @param[in] bytes Bytes per operation (0 if not applicable).
+ * @param[in] operation Function performing the given number of operations.
+ */
+template<typename F> static void measure(const std::string& name, const std::string& parameters, size_t bytes, F operation)
+{
+	operation(1);
+
+	unsigned long long iterations = 0;
+	unsigned long long batch = 1;
+	std::chrono::nanoseconds elapsed{0};
+	std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+	while (elapsed<minTime) {
+		operation(batch);
+		iterations += batch;
+		elapsed = std::chrono::steady_clock::now() - start;
+		if (batch<(1ull<<20)) batch *= 2;
+	}
+
+	results.push_back({name, parameters, iterations, static_cast<double>(elapsed.count())/iterations, bytes});
+	fprintf(stderr, "%-20s %-36s %14.1f ns/op\n", name.c_str(), parameters.c_str(), results.back().nanoseconds);
+}
+
+
+
+/** Connector send/receive with and without a competing thread.
+ * Input and output are connected the same way Loader::connectModule does it.
+ * With contention, a second thread uses the other end of the connection.
+ */
+static void benchConnector()
+{
+	if (!selected("connector")) return;
+
+	typedef std::vector<char> Payload;
+	for (size_t size: {size_t{8}, size_t{64}, size_t{1024}, size_t{16384}, size_t{262144}, size_t{4194304}, size_t{33554432}}) {
+		ConnectorMap& connectors = ConnectorDataCollector::connectors();
+		connectors.clear();
+		Connector<Payload> output{"output", ConnectorType::OUTPUT};
+		Connector<Payload> input{"input", ConnectorType::INPUT};
+		std::shared_ptr<ConnectorData> out = connectors["output"];
+		std::shared_ptr<ConnectorData> in = connectors["input"];
+		in->lock = std::unique_lock<std::mutex>{out->mutex, std::defer_lock};
+		in->pointer = out->pointer;
+		out->active = true;
+		connectors.clear();
+
+		Payload sent(size, 'b');
+		Payload received;
+		output.send(sent);
+		input.receive(received);
+
+		for (bool contention: {false, true}) {
+			std::string parameters = "\"payload\":" + std::to_string(size) + ",\"contention\":" + (contention ? "true" : "false");
+			std::atomic<bool> stop{false};
+			std::thread rival;
+
+			if (contention) rival = std::thread{[&](){ Payload p; while (!stop) input.receive(p); }};
+			if (selected("connector.send")) measure("connector.send", parameters, size, [&](unsigned long long n){ for (; n; n--) output.send(sent); });
+			stop = true;
+			if (rival.joinable()) rival.join();
+
+			stop = false;
+			if (contention) rival = std::thread{[&](){ while (!stop) output.send(sent); }};
+			if (selected("connector.receive")) measure("connector.receive", parameters, size, [&](unsigned long long n){ for (; n; n--) input.receive(received); });
+			stop = true;
+			if (rival.joinable()) rival.join();
+		}
+	}
+}
+
+
+
+/** Barrier round trips.
+ * Mirrors the round synchronization of Control: the caller starts a round
+ * for all parties and waits until the last one has arrived.
+ */
+static void benchBarrier()
+{
+	if (!selected("barrier.enqueue")) return;
+
+	for (int parties: {1, 2, 4, 8, 16, 32, 64}) {
+		Barrier barrier;
+		std::unique_lock<std::mutex> masterLock{barrier.attachParty()};
+		std::atomic<int> active{0};
+		std::atomic<unsigned long long> round{0};
+		std::atomic<bool> quit{false};
+
+		std::vector<std::thread> threads;
+		for (int i=0; i<parties; i++)
+			threads.emplace_back([&]() {
+					std::unique_lock<std::mutex> lock{barrier.attachParty()};
+					unsigned long long seen = 0;
+					while (true) {
+						barrier.enqueue(lock, [&](){ return round.load()!=seen || quit; });
+						if (quit) break;
+						seen = round.load();
+						if (active.fetch_sub(1)==1) barrier.notify();
+					}
+					barrier.detachParty();
+					});
+
+		measure("barrier.enqueue", "\"parties\":" + std::to_string(parties), 0, [&](unsigned long long n) {
+				for (; n; n--) {
+					active.store(parties);
+					round.fetch_add(1);
+					barrier.notify();
+					barrier.enqueue(masterLock, [&](){ return active.load()==0; });
+				}
+				});
+
+		quit = true;
+		barrier.notify();
+		for (auto& thread: threads) thread.join();
+	}
+}
+
+
+
+/** LOG calls of filtered and unfiltered levels, the console discards the output. */
+static void benchLog(BVS::BVS& bvs)
+{
+	if (!selected("log.out")) return;
+
+	DiscardBuffer discard;
+	std::ostream console{&discard};
+	bvs.enableLogConsole(console);
+
+	Logger logger{"Bench", 1, Logger::TO_CLI};
+	int value = 42;
+	measure("log.out", "\"filtered\":true", 0, [&](unsigned long long n){ for (; n; n--) LOG(2, "filtered message " << value); });
+	measure("log.out", "\"filtered\":false", 0, [&](unsigned long long n){ for (; n; n--) LOG(1, "unfiltered message " << value); });
+
+	bvs.enableLogConsole(std::cerr);
+}
+
+
+
+/** Config lookups of existing and missing options.
+ * The options come from a loaded [bench] section, a missing section would
+ * measure its warning instead of the lookup.
+ */
+static void benchConfig()
+{
+	if (!selected("config.getValue")) return;
+
+	char path[] = "/tmp/bvs-bench-XXXXXX";
+	int descriptor = mkstemp(path);
+	FILE* file = descriptor<0 ? nullptr : fdopen(descriptor, "w");
+	if (!file) {
+		fprintf(stderr, "cannot create config file '%s'\n", path);
+		failed = true;
+		return;
+	}
+	fprintf(file, "[bench]\nnumber = 42\ntext = value\n");
+	fclose(file);
+	Config config{"bench"};
+	config.loadConfigFile(path);
+	std::remove(path);
+
+	int number = 0;
+	std::string text;
+	measure("config.getValue", "\"type\":\"int\"", 0, [&](unsigned long long n){ for (; n; n--) number += config.getValue<int>("bench.number", 0); });
+	measure("config.getValue", "\"type\":\"string\"", 0, [&](unsigned long long n){ for (; n; n--) text = config.getValue<std::string>("bench.text", ""); });
+	measure("config.getValue", "\"type\":\"missing\"", 0, [&](unsigned long long n){ for (; n; n--) number += config.getValue<int>("bench.missing", 1); });
+	if (number==0) fprintf(stderr, "%s\n", text.c_str());
+}
+
+
+
+/** Round overhead of the master controller with a growing number of no-op modules.
+ * Rounds are counted while running freely, so the measurement includes
+ * everything Control does between two rounds.
+ */
+static void benchRounds(BVS::BVS& bvs)
+{
+	if (!selected("control.round")) return;
+
+	auto measureRounds = [&](int modules) {
+		bvs.run();
+		std::this_thread::sleep_for(std::chrono::milliseconds{50});
+
+		unsigned long long first = Logger::round.load();
+		std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+		std::this_thread::sleep_for(minTime);
+		unsigned long long rounds = Logger::round.load() - first;
+		std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+		bvs.pause();
+
+		std::string parameters = "\"modules\":" + std::to_string(modules);
+		if (!rounds) {
+			fprintf(stderr, "%-20s %-36s no rounds ran!\n", "control.round", parameters.c_str());
+			failed = true;
+			return;
+		}
+		results.push_back({"control.round", parameters, rounds, static_cast<double>(elapsed.count())/rounds, 0});
+		fprintf(stderr, "%-20s %-36s %14.1f ns/op\n", "control.round", results.back().parameters.c_str(), results.back().nanoseconds);
+	};
+
+	bvs.start();
+	int loaded = 0;
+	for (int modules: {0, 1, 8, 64}) {
+		for (; loaded<modules; loaded++) bvs.loadModule("noop" + std::to_string(loaded) + "(BVSBenchNoop)");
+		measureRounds(modules);
+	}
+}
+
+
+
+/** Escape a string for JSON. */
+static std::string escape(const std::string& s)
+{
+	std::string out;
+	for (char c: s) {
+		if (c=='"' || c=='\\') out += '\\';
+		out += c;
+	}
+
+	return out;
+}
+
+
+
+/** Write results as JSON. */
+static void writeResults(FILE* file)
+{
+	fprintf(file, "{\n\t\"version\": \"%s\",\n\t\"minTime\": %lld,\n\t\"benchmarks\": [", escape(bvs_version).c_str(),
+			static_cast<long long>(minTime.count()));
+	for (size_t i=0; i<results.size(); i++) {
+		const Result& r = results[i];
+		fprintf(file, "%s\n\t\t{\"name\": \"%s\", %s, \"iterations\": %llu, \"nsPerOp\": %.3f",
+				i ? "," : "", r.name.c_str(), r.parameters.c_str(), r.iterations, r.nanoseconds);
+		if (r.bytes && r.nanoseconds>0) fprintf(file, ", \"bytesPerSecond\": %.0f", r.bytes*1e9/r.nanoseconds);
+		fprintf(file, "}");
+	}
+	fprintf(file, "\n\t]\n}\n");
+}
+
+
+
+int main(int argc, char** argv)
+{
+	std::string output;
+	std::vector<const char*> bvsArgs{argv[0]};
+	for (int i=1; i<argc; i++) {
+		if (!strcmp(argv[i], "-f") && i+1<argc) filter = argv[++i];
+		else if (!strcmp(argv[i], "-t") && i+1<argc) minTime = std::chrono::milliseconds{atoi(argv[++i])};
+		else if (!strcmp(argv[i], "-o") && i+1<argc) output = argv[++i];
+		else if (!strncmp(argv[i], "--bvs.", 6)) bvsArgs.push_back(argv[i]);
+		else {
+			usage();
+			return strcmp(argv[i], "-h") ? EXIT_FAILURE : EXIT_SUCCESS;
+		}
+	}
+
+	BVS::BVS* bvs = new BVS::BVS(static_cast<int>(bvsArgs.size()), bvsArgs.data());
+	// quiet, the per round LOG would dominate the round benchmark
+	bvs->enableLogConsole(std::cerr);
+	bvs->setLogSystemVerbosity(1);
+
+	benchConnector();
+	benchBarrier();
+	benchLog(*bvs);
+	benchConfig();
+	benchRounds(*bvs);
+
+	bvs->quit();
+	delete bvs;
+
+	FILE* file = output.empty() ? stdout : fopen(output.c_str(), "w");
+	if (!file) {
+		fprintf(stderr, "cannot open '%s'\n", output.c_str());
+		return EXIT_FAILURE;
+	}
+	writeResults(file);
+	if (file!=stdout) fclose(file);
+
+	return failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
+
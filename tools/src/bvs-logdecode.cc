@@ -0,0 +1,157 @@
+#include <cerrno>
+#include <cinttypes>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iterator>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bvs/binarylog.h"
+
+
+
+/** Call site of a message. */
+struct Site
+{
+	Site() : file{}, line{0}, expression{} {}
+
+	std::string file; /**< Source file. */
+	uint32_t line; /**< Source line. */
+	std::string expression; /**< LOG arguments as written in the source. */
+};
+
+
+
+/** Print usage. */
+static void usage()
+{
+	printf("usage: bvs-logdecode [-t] [-s] file\n");
+	printf("   -t    prefix messages with time and thread\n");
+	printf("   -s    list call sites instead of messages\n");
+	printf("   file  binary log (BVS.logFormat = BINARY)\n");
+}
+
+
+
+/** Read a string with 16 bit length, advancing position.
+ * @return False if the string exceeds the end.
+ */
+static bool readString(const char*& position, const char* end, std::string& value)
+{
+	uint16_t length;
+	if (!BVS::readBinaryLogValue(position, end, length) || position+length > end) return false;
+	value.assign(position, length);
+	position += length;
+	return true;
+}
+
+
+
+/** Reconstruct the text of a message from its tagged arguments.
+ * @return False if an argument was malformed.
+ */
+static bool decodeArguments(const char* position, const char* end, std::string& text)
+{
+	std::ostringstream out;
+	out.setf(out.boolalpha);
+
+	bool ok = BVS::formatBinaryLogArguments(position, end, out);
+	text = out.str() + (ok ? "" : "<malformed>");
+	return ok;
+}
+
+
+
+/** Main function, decodes a binary log to text. */
+int main(int argc, char** argv)
+{
+	bool times = false;
+	bool sitesOnly = false;
+	std::string path;
+
+	for (int i=1; i<argc; i++) {
+		std::string arg = argv[i];
+		if (arg=="-t") times = true;
+		else if (arg=="-s") sitesOnly = true;
+		else if (arg=="-h" || arg=="--help") { usage(); return EXIT_SUCCESS; }
+		else if (arg[0]!='-' && path.empty()) path = arg;
+		else { usage(); return EXIT_FAILURE; }
+	}
+	if (path.empty()) { usage(); return EXIT_FAILURE; }
+
+	std::ifstream file{path, std::ios::binary};
+	std::vector<char> data{std::istreambuf_iterator<char>{file}, std::istreambuf_iterator<char>{}};
+	if (!file.good() && !file.eof()) {
+		fprintf(stderr, "could not read '%s': %s\n", path.c_str(), strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	BVS::BinaryLogHeader header;
+	if (data.size()<sizeof(header)) {
+		fprintf(stderr, "'%s' is not a binary log\n", path.c_str());
+		return EXIT_FAILURE;
+	}
+	memcpy(&header, data.data(), sizeof(header));
+	if (memcmp(header.magic, "BVSBLOG", 8) || header.version!=BVS::binaryLogVersion) {
+		fprintf(stderr, "'%s' is not a binary log of version %u\n", path.c_str(), BVS::binaryLogVersion);
+		return EXIT_FAILURE;
+	}
+
+	std::map<uint32_t, Site> sites;
+	std::map<uint32_t, std::string> loggers;
+	size_t padding = 0;
+	const char* position = data.data() + header.headerSize;
+	const char* end = data.data() + data.size();
+
+	// records are written in order of reservation, an empty size ends the log
+	while (position+5 <= end) {
+		uint32_t size;
+		memcpy(&size, position, sizeof(size));
+		if (size<5 || position+size > end) break;
+		uint8_t type = position[4];
+		const char* field = position + 5;
+		const char* next = position + size;
+		position = next;
+
+		if (type==BVS::binaryLogSite) {
+			uint32_t id;
+			Site site;
+			if (BVS::readBinaryLogValue(field, next, id) && BVS::readBinaryLogValue(field, next, site.line)
+					&& readString(field, next, site.file) && readString(field, next, site.expression))
+				sites[id] = site;
+		} else if (type==BVS::binaryLogLogger) {
+			uint32_t id;
+			if (BVS::readBinaryLogValue(field, next, id)) {
+				loggers[id].assign(field, next);
+				if (loggers[id].size()>padding) padding = loggers[id].size();
+			}
+		} else if (type==BVS::binaryLogMessage && !sitesOnly) {
+			uint8_t level;
+			uint32_t site, logger, thread;
+			uint64_t time;
+			if (!BVS::readBinaryLogValue(field, next, level) || !BVS::readBinaryLogValue(field, next, site) || !BVS::readBinaryLogValue(field, next, logger)
+					|| !BVS::readBinaryLogValue(field, next, thread) || !BVS::readBinaryLogValue(field, next, time)) continue;
+
+			std::string text;
+			decodeArguments(field, next, text);
+			if (times) {
+				time_t seconds = time/1000000000;
+				char clock[16];
+				strftime(clock, sizeof(clock), "%H:%M:%S", localtime(&seconds));
+				printf("%s.%06" PRIu64 " T%-3u ", clock, (time%1000000000)/1000, thread);
+			}
+			printf("[%u|%-*s] %s\n", level, static_cast<int>(padding), loggers[logger].c_str(), text.c_str());
+		}
+	}
+
+	if (sitesOnly)
+		for (auto& site: sites)
+			printf("%5u %s:%u: %s\n", site.first, site.second.file.c_str(), site.second.line, site.second.expression.c_str());
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,160 @@
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "bvs/statspage.h"
+
+
+
+/** Print usage. */
+static void usage()
+{
+	printf("usage: bvs-top [-d delay] [-n iterations] [pid]\n");
+	printf("   -d delay       refresh delay in ms (default: 1000)\n");
+	printf("   -n iterations  quit after n refreshes (default: run until the page vanishes)\n");
+	printf("   pid            bvs process to show (default: newest '/dev/shm/bvs-*')\n");
+}
+
+
+
+/** Find the newest statistics page.
+ * @return Page path or empty string if none was found.
+ */
+static std::string findPage()
+{
+	std::string newest;
+	time_t newestTime = 0;
+
+	DIR* dir = opendir("/dev/shm");
+	if (!dir) return newest;
+	while (dirent* entry = readdir(dir)) {
+		if (strncmp(entry->d_name, "bvs-", 4)) continue;
+		std::string path = std::string{"/dev/shm/"} + entry->d_name;
+		struct stat info;
+		if (stat(path.c_str(), &info)==0 && info.st_mtime>=newestTime) {
+			newest = path;
+			newestTime = info.st_mtime;
+		}
+	}
+	closedir(dir);
+
+	return newest;
+}
+
+
+
+/** Convert status code to name. */
+static const char* statusName(int32_t status)
+{
+	static const char* names[] = { "OK", "NOINPUT", "FAIL", "WAIT", "DONE", "SHUTDOWN" };
+	return status>=0 && status<6 ? names[status] : "?";
+}
+
+
+
+/** Render a snapshot. */
+static void render(const std::string& path, const std::vector<char>& snapshot)
+{
+	auto header = reinterpret_cast<const BVS::StatsPageHeader*>(snapshot.data());
+	auto modules = reinterpret_cast<const BVS::StatsPageModule*>(header + 1);
+	auto pools = reinterpret_cast<const BVS::StatsPagePool*>(modules + header->moduleCapacity);
+
+	// clear screen, move cursor home
+	printf("\033[H\033[2J");
+	printf("%s  pid: %llu  round: %llu  duration: %.3fms  fps: %.1f  util: %.0f%%  imbalance: %.2f\n\n",
+			path.c_str(), static_cast<unsigned long long>(header->pid),
+			static_cast<unsigned long long>(header->round), header->roundDuration/1000.0,
+			header->roundDuration ? 1000000.0/header->roundDuration : 0.0,
+			header->roundUtilization, header->poolImbalance);
+
+	printf("%-24s %12s %12s %8s\n", "POOL", "BUSY(ms)", "IDLE(ms)", "UTIL");
+	for (uint32_t i=0; i<header->poolCount; i++)
+		if (pools[i].active) printf("%-24.24s %12.3f %12.3f %7.0f%%\n", pools[i].name,
+				pools[i].busy/1000.0, pools[i].idle/1000.0, pools[i].utilization);
+
+	// slowest modules first
+	std::vector<const BVS::StatsPageModule*> sorted;
+	for (uint32_t i=0; i<header->moduleCount; i++)
+		if (modules[i].active) sorted.push_back(&modules[i]);
+	std::sort(sorted.begin(), sorted.end(),
+			[](const BVS::StatsPageModule* a, const BVS::StatsPageModule* b) { return a->duration>b->duration; });
+
+	printf("\n%-24s %-16s %12s %12s %10s %10s %9s\n", "MODULE", "POOL", "TIME(ms)", "CPU(ms)", "VCSW", "ICSW", "STATUS");
+	for (auto module: sorted)
+		printf("%-24.24s %-16.16s %12.3f %12.3f %10llu %10llu %9s\n", module->id, module->pool,
+				module->duration/1000.0, module->cpuDuration/1000.0,
+				static_cast<unsigned long long>(module->voluntarySwitches),
+				static_cast<unsigned long long>(module->involuntarySwitches),
+				statusName(module->status));
+	fflush(stdout);
+}
+
+
+
+/** Main function, maps a statistics page and renders it periodically. */
+int main(int argc, char** argv)
+{
+	unsigned int delay = 1000;
+	long iterations = -1;
+	std::string path;
+
+	for (int i=1; i<argc; i++) {
+		std::string arg = argv[i];
+		if (arg=="-d" && i+1<argc) delay = std::atoi(argv[++i]);
+		else if (arg=="-n" && i+1<argc) iterations = std::atol(argv[++i]);
+		else if (arg=="-h" || arg=="--help") { usage(); return EXIT_SUCCESS; }
+		else if (arg[0]!='-') path = "/dev/shm/bvs-" + arg;
+		else { usage(); return EXIT_FAILURE; }
+	}
+
+	if (path.empty()) path = findPage();
+	if (path.empty()) {
+		fprintf(stderr, "no statistics page found, is BVS.statsPage enabled?\n");
+		return EXIT_FAILURE;
+	}
+
+	int fd = open(path.c_str(), O_RDONLY);
+	struct stat info;
+	if (fd<0 || fstat(fd, &info)!=0 || static_cast<size_t>(info.st_size)<sizeof(BVS::StatsPageHeader)) {
+		fprintf(stderr, "could not open '%s': %s\n", path.c_str(), strerror(errno));
+		return EXIT_FAILURE;
+	}
+	void* page = mmap(nullptr, info.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	close(fd);
+	if (page==MAP_FAILED) {
+		fprintf(stderr, "could not map '%s': %s\n", path.c_str(), strerror(errno));
+		return EXIT_FAILURE;
+	}
+
+	auto header = static_cast<const BVS::StatsPageHeader*>(page);
+	if (memcmp(header->magic, "BVSSTAT", 8) || header->version!=BVS::statsPageVersion) {
+		fprintf(stderr, "'%s' is not a statistics page of version %u\n", path.c_str(), BVS::statsPageVersion);
+		return EXIT_FAILURE;
+	}
+
+	std::vector<char> snapshot(info.st_size);
+	for (long i=0; iterations<0 || i<iterations; i++) {
+		if (i>0) std::this_thread::sleep_for(std::chrono::milliseconds{delay});
+		if (access(path.c_str(), F_OK)!=0) {
+			printf("'%s' vanished, quitting!\n", path.c_str());
+			break;
+		}
+		if (BVS::readStatsPage(header, snapshot.data(), snapshot.size())) render(path, snapshot);
+	}
+
+	munmap(page, info.st_size);
+
+	return EXIT_SUCCESS;
+}